@@ -10,45 +10,296 @@
 #ifndef CONTEXT_H
 #define CONTEXT_H
 
+#include <algorithm>
 #include <memory>
-#include <qobject.h>
 #include <vector>
+#include "broadphase.h"
+#include "bvh.h"
 #include "collider.h"
+#include "distanceconstraints.h"
+#include "particlestore.h"
+#include "profiler.h"
+#include "sdf.h"
+#include "threadpool.h"
 
 
 /**
- * @class Context
+ * @enum SolverMode
+ * @brief Méthode de résolution des contraintes utilisée par projectConstraints.
+ */
+enum class SolverMode {
+    Sequential, /**< Particule par particule, sur un seul thread. */
+    Colored,    /**< Contraintes dynamiques regroupées par couleurs indépendantes, chaque couleur résolue en parallèle.
+                     Mêmes positions que Sequential, vitesses différentes pour les particules à plusieurs contacts. */
+    Jacobi      /**< Chaque particule applique en parallèle la moyenne des corrections de ses contraintes dynamiques.
+                     Plus dissipatif que Sequential dès qu'une particule a plusieurs contacts. */
+};
+
+/**
+ * @struct XPBDSettings
+ * @brief Réglages du solveur XPBD (voir Context::setXPBD).
+ *
+ * Chaque pas est découpé en substeps sous-pas. À chaque sous-pas, les contacts sont détectés sur les
+ * positions prédites puis projetés au plus iterations fois, en conservant le multiplicateur de Lagrange
+ * de chaque contrainte (les paires presque en contact, à contact_margin près, sont aussi suivies: une
+ * correction peut les amener au contact pendant les itérations). Les itérations s'arrêtent dès que le plus grand résidu (recouvrement restant,
+ * diminué de la part admise par la souplesse) passe sous tolerance. La vitesse est ensuite déduite du
+ * déplacement: les contacts sont inélastiques, ce qui stabilise les empilements.
+ */
+struct XPBDSettings {
+    bool enabled=false; /**< Faux: une seule projection par pas avec rebond des vitesses (méthode d'origine) */
+    unsigned substeps=4; /**< Nombre de sous-pas par pas, au moins 1 */
+    unsigned iterations=8; /**< Nombre maximal d'itérations par sous-pas, au moins 1 */
+    double static_compliance=0; /**< Souplesse des contacts avec les colliders (inverse d'une raideur, 0: rigide) */
+    double dynamic_compliance=0; /**< Souplesse des contacts entre particules */
+    double tolerance=0.01; /**< Résidu en dessous duquel les itérations s'arrêtent */
+    double contact_margin=1; /**< Distance en deçà de laquelle deux particules proches sont suivies pendant le sous-pas sans se toucher encore */
+};
+
+/**
+ * @struct SleepSettings
+ * @brief Réglages de la mise en sommeil des particules (voir Context::setSleep).
+ *
+ * Une particule est au repos tant que sa vitesse reste sous velocity et qu'elle ne s'éloigne pas de plus
+ * de displacement de sa position au début de la période de repos. Les particules en contact forment un
+ * îlot, qui s'endort d'un bloc quand toutes ses particules sont au repos depuis frames pas.
+ *
+ * Le solveur d'origine fait rebondir les contacts sans perte: une pile y reste agitée (vitesse moyenne de l'ordre
+ * de 15 sur les étagères de shelves.scene) et ne s'endort jamais. Activer la mise en sommeil active donc aussi
+ * XPBD, dont les contacts inélastiques laissent les piles au repos, s'il ne l'est pas déjà (voir Context::setSleep).
+ */
+struct SleepSettings {
+    bool enabled=false; /**< Faux: toutes les particules sont simulées à chaque pas */
+    double velocity=0.1; /**< Vitesse maximale d'une particule au repos */
+    double displacement=1; /**< Déplacement maximal d'une particule au repos depuis le début de son repos */
+    std::uint32_t frames=30; /**< Nombre de pas de repos de tout l'îlot avant sa mise en sommeil */
+};
+
+/**
+ * @struct CCDSettings
+ * @brief Réglages de la détection continue des collisions (voir Context::setCCD).
+ *
+ * Une particule est rapide quand son déplacement prédit pendant le pas (ou le sous-pas XPBD) dépasse speed_threshold
+ * fois son rayon: elle pourrait alors traverser un collider mince ou une autre particule sans jamais les recouvrir.
+ * Sa trajectoire est balayée jusqu'au premier impact (sphère balayée contre les colliders et contre les trajectoires
+ * des autres particules) et elle s'arrête à l'impact, en recouvrant l'obstacle de skin fois son rayon: la détection
+ * ordinaire en fait une contrainte. Le reste du déplacement est perdu pour ce pas, ainsi que la composante de la vitesse
+ * selon la normale de l'obstacle à l'impact: la vitesse tangentielle (glissement) est conservée. Une particule qui recouvre déjà un collider n'est arrêtée que si elle le traverserait. Les particules
+ * lentes ne coûtent qu'un test de vitesse.
+ *
+ * Une particule rapide arrêtée raccourcit sa trajectoire: celles qui la suivaient (un bloc de particules lancé d'un
+ * seul tenant) la traverseraient. Les paires de particules rapides sont donc balayées de nouveau sur les trajectoires
+ * raccourcies, jusqu'à passes fois, tant qu'une particule s'arrête plus tôt.
+ */
+struct CCDSettings {
+    bool enabled=false; /**< Faux: contacts détectés seulement aux positions prédites */
+    double speed_threshold=0.5; /**< Déplacement par pas, en rayons de la particule, au-delà duquel la trajectoire est balayée */
+    double skin=0.01; /**< Recouvrement laissé à l'impact, en fraction du rayon */
+    unsigned passes=4; /**< Nombre maximal de balayages des paires de particules rapides */
+};
+
+/**
+ * @struct ParticleStream
+ * @brief Source continue de particules (voir Context::addStream).
+ *
+ * À chaque pas, rate*dt particules sont émises (la partie fractionnaire est reportée au pas suivant),
+ * réparties régulièrement sur le segment de longueur width centré sur (x,y) et perpendiculaire à la
+ * vitesse initiale (vx,vy). L'émission s'arrête après max_particles particules (0: sans limite).
+ */
+struct ParticleStream {
+    double x=0; /**< Centre de la sortie */
+    double y=0;
+    double vx=0; /**< Vitesse initiale des particules émises */
+    double vy=0;
+    double rate=10; /**< Particules émises par unité de temps */
+    double width=0; /**< Largeur de la sortie */
+    double radius=5; /**< Rayon des particules émises */
+    double mass=1; /**< Masse des particules émises */
+    std::size_t max_particles=0; /**< Nombre total de particules à émettre, 0 pour une source sans fin */
+    std::size_t emitted=0; /**< Particules déjà émises */
+    double pending=0; /**< Fraction de particule reportée au pas suivant (remise à 0 quand la source est épuisée) */
+};
+
+/**
+ * @class BasicContext
  * @brief Classe pour représenter un ensemble de particules dans un environnement soumis à un champ de force.
  *
  * Cette classe implémente le contexte de la simulation défini par un vecteur de particules, des colliders,
  * un champ de force, un coefficient de frottement, des contraintes statiques, une hauteur et une largeur de l'environnement.
- * Elle implémente toutes les méthodes pour actualiser la situation à chaque pas temporel
+ * Elle implémente toutes les méthodes pour actualiser la situation à chaque pas temporel.
+ * Elle ne dépend pas de Qt (bibliothèque pbd_core): l'interface graphique passe par ContextAdapter.
+ *
+ * Déterminisme: pour un même état initial, updatePhysicalSystem donne des résultats identiques au bit près
+ * quels que soient le nombre de threads et le jeu d'instructions choisi (voir kernels.h). Les paires de
+ * contact sont triées par (i,j), les contraintes de chaque particule sont appliquées dans l'ordre de la liste
+ * CSR, les morceaux des boucles parallèles ne dépendent que de parallel_grain, chaque couleur (Colored) ne
+ * touche que des particules distinctes et chaque particule (Jacobi) somme ses corrections dans un ordre fixe.
+ * Le résidu XPBD est un maximum, qui ne dépend pas de l'ordre des tâches. pbd_core est compilé sans contraction en FMA. stateHash permet de le vérifier pas à pas.
+ *
+ * Liens de distance: les liens (cordes, treillis, voir distances) sont persistants. projectConstraints les résout
+ * en un passage après les contacts, en annulant aussi la vitesse relative le long de chaque lien: un treillis y reste
+ * sensiblement élastique, XPBD le rend rigide en résolvant les liens avant les contacts à chaque itération.
+ * Sequential les résout dans l'ordre des liens, Colored et Jacobi couleur par couleur en parallèle. Deux particules
+ * liées font partie du même îlot de sommeil.
+ *
+ * Précision: la classe est paramétrée par le type des réels de la simulation (Real) et instanciée dans Context.cpp
+ * en double (Context, la précision d'origine) et en float (ContextF: deux fois plus de particules par instruction
+ * SIMD, moitié moins de mémoire par pas). Les réglages (XPBDSettings, SleepSettings, CCDSettings, ParticleStream) restent en
+ * double. Les deux versions suivent les mêmes étapes dans le même ordre et sont chacune déterministe; une
+ * simulation en float s'écarte de la même simulation en double, d'autant plus vite que les contacts sont nombreux.
  */
-class Context :public QObject{
-    Q_OBJECT
+template <class Real>
+class BasicContext {
 private:
-    double gravity_value=9.81/2; /**< Valeur de la gravité, agissant sur le champ de force initial */
-    double alpha_value=0.003; /**< Valeur du coefficient de frottement linéaire appliqué*/
+    Real gravity_value=9.81/2; /**< Valeur de la gravité, agissant sur le champ de force initial */
+    Real alpha_value=0.003; /**< Valeur du coefficient de frottement linéaire appliqué*/
+    std::vector<std::uint32_t> contact_cursor; /**< Curseur d'écriture utilisé par buildContactAdjacency */
+    ColliderBVH collider_bvh; /**< Hiérarchie de boîtes englobantes sur les colliders, utilisée par addStaticContactConstraints */
+    bool collider_bvh_dirty=true; /**< Vrai si les colliders ont changé depuis la dernière construction de collider_bvh */
+    std::vector<std::uint32_t> nearby_colliders; /**< Colliders proches d'une particule, renvoyés par collider_bvh */
+    ColliderSDFSettings sdf_settings; /**< Réglages de la grille de distances aux colliders */
+    BasicColliderSDF<Real> collider_sdf; /**< Grille de distances aux colliders, utilisée par addStaticContactConstraints si sdf_settings.enabled */
+    bool collider_sdf_dirty=true; /**< Vrai si les colliders ou les réglages ont changé depuis le dernier calcul de collider_sdf */
+    std::vector<Real> contact_depth; /**< Tampon de travail des fonctions de détection par type de collider */
+    SolverMode solver_mode=SolverMode::Sequential; /**< Méthode de résolution des contraintes */
+    unsigned thread_count=1; /**< Nombre de threads utilisés par les solveurs parallèles */
+    std::size_t parallel_grain=1024; /**< Nombre de particules ou de contraintes par tâche des boucles parallèles */
+    std::unique_ptr<ThreadPool> thread_pool; /**< Threads des solveurs parallèles, créés au premier usage */
+    std::vector<std::uint64_t> used_colors; /**< Couleurs déjà prises par les contraintes de chaque particule (une par bit) */
+    std::vector<std::uint32_t> constraint_color; /**< Couleur de chaque contrainte dynamique */
+    std::vector<std::uint32_t> color_offsets; /**< Début de chaque couleur dans color_list */
+    std::vector<std::uint32_t> color_list; /**< Contraintes dynamiques rangées couleur par couleur */
+    XPBDSettings xpbd; /**< Réglages du solveur XPBD */
+    std::vector<Real> static_target; /**< XPBD: valeur de n.p à atteindre pour chaque contrainte statique */
+    std::vector<Real> static_lambda; /**< XPBD: multiplicateur de Lagrange de chaque contrainte statique */
+    std::vector<Real> dynamic_lambda; /**< XPBD: multiplicateur de Lagrange de chaque contrainte dynamique */
+    unsigned solver_iterations=0; /**< Itérations XPBD du dernier pas, tous sous-pas confondus */
+    SleepSettings sleep; /**< Réglages de la mise en sommeil */
+    bool xpbd_for_sleep=false; /**< Vrai si setSleep a activé XPBD: il le désactive avec la mise en sommeil */
+    std::size_t awake_count=0; /**< Particules éveillées, rangées en tête du ParticleStore */
+    std::uint64_t sleep_revision=UINT64_MAX; /**< Révision du ParticleStore au dernier rangement des particules éveillées */
+    std::vector<Real> sleep_force; /**< Champ de force, bords et nombre de colliders vus au pas précédent: un changement réveille tout */
+    int sleep_width=0;
+    int sleep_height=0;
+    std::size_t sleep_colliders=0;
+    float predict_dt=0; /**< Pas de la dernière prédiction, appliqué aux particules réveillées pendant le pas */
+    std::vector<std::uint32_t> island_parent; /**< Union-find des îlots de contact */
+    std::vector<std::uint32_t> island_rest; /**< Repos de chaque îlot (le plus petit de ses particules) */
+    std::vector<std::uint32_t> island_label; /**< Numéro de chaque îlot: la plus petite poignée de ses particules */
+    std::vector<std::uint32_t> woken_islands; /**< Îlots endormis touchés pendant le pas */
+    CCDSettings ccd; /**< Réglages de la détection continue des collisions */
+    std::vector<std::uint32_t> fast_particles; /**< Particules rapides du dernier pas ou sous-pas (voir sweepFastParticles) */
+    std::vector<std::uint32_t> fast_index; /**< Rang de chaque particule dans fast_particles, UINT32_MAX pour une particule lente */
+    std::vector<std::uint32_t> fast_order; /**< Particules rapides triées selon le bord gauche de la boîte de leur trajectoire */
+    std::vector<ContactPair> fast_pairs; /**< Paires (rangs dans fast_particles) de particules rapides dont les boîtes se recouvrent */
+    std::vector<AABB> fast_boxes; /**< Boîte de la trajectoire de chaque particule rapide */
+    std::vector<Real> impact_time; /**< Fraction du déplacement de chaque particule rapide avant son premier impact */
+    std::vector<Real> impact_nx; /**< Normale (non unitaire) de l'obstacle au premier impact de chaque particule rapide, selon x */
+    std::vector<Real> impact_ny; /**< Normale au premier impact, selon y */
+    std::vector<std::uint32_t> nearby_particles; /**< Particules proches d'une trajectoire, renvoyées par la broadphase */
+
+    void projectSequential();
+    void colorConstraints();
+    void projectColored();
+    void projectJacobi();
+    std::size_t activeCount() const {return sleep.enabled?awake_count:particles.size();}
+    void findStaticContacts(std::size_t begin,std::size_t end);
+    void prepareSleep();
+    void wakeTouchedIslands();
+    void updateSleep();
+    std::uint32_t findIsland(std::uint32_t i);
+    void emitStreams(float dt);
+    void updateXPBD(float dt);
+    void projectXPBD(Real h);
+    Real iterateXPBD(Real h);
+    Real projectDistances(Real h,bool update_velocity);
+    ThreadPool& threadPool();
 public:
-    std::vector<particle> particles; /**< Vecteur de particules */
-    std::vector<std::shared_ptr<collider>> colliders; /**< Vecteur de colliders. L'ampoul magique a forcé l'utilisation de shared_ptr: à expliquer... */
-    std::vector<double> champ_de_force; /**< Vecteur représentant un champ de force */
-    double alpha; /**< Coefficient de frottement linéaire*/
-    std::vector<StaticConstraint> S_Constraints; /**< Vecteur contenant les contraintes statiques ajoutées lors de la méthode addStaticContactConstraints pour les utiliser dans la méthode enforceStaticGroundConstraint du fichier context.cpp */
-    std::vector<DynamicConstraint> D_Constraints; /**< Vecteur contenant les contraintes dynamiques ajoutées lors de la méthode addDynamicContactConstraints pour les utiliser dans la méthode enforceDynamicGroundConstraint du fichier context.cpp */
+    BasicParticleStore<Real> particles; /**< Particules, stockées en tableaux contigus (voir particlestore.h) */
+    BasicColliderSet<Real> colliders; /**< Colliders statiques, rangés par type (voir collider.h) */
+    std::vector<ParticleStream> streams; /**< Sources continues, émettant au début de chaque pas (voir addStream) */
+    BasicDistanceConstraints<Real> distances; /**< Liens de distance persistants entre particules (voir distanceconstraints.h) */
+    std::vector<Real> champ_de_force; /**< Vecteur représentant un champ de force */
+    Real alpha; /**< Coefficient de frottement linéaire*/
+    std::vector<BasicStaticConstraint<Real>> S_Constraints; /**< Vecteur contenant les contraintes statiques ajoutées lors de la méthode addStaticContactConstraints pour les utiliser dans la méthode enforceStaticGroundConstraint du fichier context.cpp */
+    std::vector<BasicDynamicConstraint<Real>> D_Constraints; /**< Vecteur contenant les contraintes dynamiques ajoutées lors de la méthode addDynamicContactConstraints pour les utiliser dans la méthode enforceDynamicGroundConstraint du fichier context.cpp */
+    Broadphase broadphase; /**< Recherche des paires de particules en contact pour addDynamicContactConstraints */
+    std::vector<ContactPair> contact_pairs; /**< Paires trouvées par la broadphase, conservées d'un pas à l'autre pour éviter les allocations */
+    std::vector<std::uint32_t> contact_offsets; /**< Début des contraintes de chaque particule dans contact_list (taille nombre de particules+1) */
+    std::vector<std::uint32_t> contact_list; /**< Contraintes de chaque particule, rangées particule par particule (format CSR) */
     int width; /**< Largeur de l'environnement*/
     int height; /**< Longueur de l'environnment*/
+    Profiler profiler; /**< Durées des étapes et compteurs des derniers pas (vide sans PBD_ENABLE_PROFILING) */
 
     /**
      * @brief Constructeur par défaut.
      */
-    Context(){particles={},colliders={},champ_de_force={0,gravity_value},alpha=alpha_value,S_Constraints={},D_Constraints={},width=0,height=0;}
+    BasicContext(){colliders={},champ_de_force={0,gravity_value},alpha=alpha_value,S_Constraints={},D_Constraints={},width=0,height=0;}
+
+    std::size_t bvh_min_colliders=32; /**< En dessous de ce nombre de colliders, chaque type est testé sur toutes les particules sans passer par la BVH */
 
     /**
-     * @brief Méthode pour ajouter un collider au vecteur de colliders.
+     * @brief Méthode pour ajouter un plan aux colliders.
      * @param newCollider Nouveau collider à ajouter à la simulation.
+     * La hiérarchie de boîtes englobantes (et la grille de distances) sera reconstruite au prochain pas.
      */
-    void addCollider(std::shared_ptr<collider> newCollider) {colliders.push_back(newCollider);}
+    void addCollider(const basic_plancollider<Real>& newCollider) {colliders.planes.push_back(newCollider);collider_bvh_dirty=true;collider_sdf_dirty=true;}
+
+    /**
+     * @brief Méthode pour ajouter une sphère aux colliders.
+     * @param newCollider Nouveau collider à ajouter à la simulation.
+     * La hiérarchie de boîtes englobantes (et la grille de distances) sera reconstruite au prochain pas.
+     */
+    void addCollider(const basic_spherecollider<Real>& newCollider) {colliders.spheres.push_back(newCollider);collider_bvh_dirty=true;collider_sdf_dirty=true;}
+
+    /**
+     * @brief Ajoute une grille de particules immobiles, ligne par ligne.
+     * La place est réservée en une fois (voir ParticleStore::ensureCapacity): aucune allocation par particule.
+     * @param x0 Abscisse de la première particule.
+     * @param y0 Ordonnée de la première particule.
+     * @param cols Nombre de colonnes.
+     * @param rows Nombre de lignes.
+     * @param spacing Distance entre deux particules voisines.
+     * @param radius Rayon des particules.
+     * @param mass Masse des particules.
+     * @return Le nombre de particules ajoutées.
+     */
+    std::size_t emitGrid(double x0,double y0,std::size_t cols,std::size_t rows,double spacing,double radius,double mass);
+
+    /**
+     * @brief Ajoute des particules immobiles tirées au hasard dans le rectangle [x0,x1]x[y0,y1], sans recouvrement entre elles.
+     * Le rectangle est découpé en cellules d'un peu plus d'un diamètre: count cellules sont tirées, et une particule
+     * est placée au hasard dans chacune. Les particules sont ajoutées dans l'ordre des cellules (ligne par ligne).
+     * La mémoire utilisée est proportionnelle à count, pas au nombre de cellules.
+     * @param count Nombre de particules demandé, limité au nombre de cellules.
+     * @param seed Graine du tirage: une même graine donne les mêmes particules.
+     * @return Le nombre de particules ajoutées.
+     */
+    std::size_t emitRandom(double x0,double y0,double x1,double y1,std::size_t count,double radius,double mass,std::uint64_t seed);
+
+    /**
+     * @brief Ajoute une corde: count particules immobiles régulièrement espacées de (x0,y0) à (x1,y1),
+     * chacune liée à la suivante à sa distance actuelle.
+     * @param compliance Souplesse des liens (0: rigides).
+     * @return Le nombre de liens ajoutés.
+     */
+    std::size_t emitRope(double x0,double y0,double x1,double y1,std::size_t count,double radius,double mass,double compliance);
+
+    /**
+     * @brief Ajoute un treillis: une grille de particules (voir emitGrid) dont chaque particule est liée à ses voisines
+     * horizontale, verticale et diagonales. Pour que les contacts ne contrarient pas les liens, spacing doit dépasser
+     * le diamètre des particules.
+     * @param compliance Souplesse des liens (0: rigides).
+     * @return Le nombre de liens ajoutés.
+     */
+    std::size_t emitLattice(double x0,double y0,std::size_t cols,std::size_t rows,double spacing,double radius,double mass,double compliance);
+
+    /**
+     * @brief Ajoute une source continue de particules. Si elle est limitée (max_particles), la place de toutes ses
+     * particules est réservée tout de suite: l'émission ne déplace jamais les tableaux de particules en cours de route.
+     * @return L'indice de la source dans streams.
+     */
+    std::size_t addStream(const ParticleStream& stream);
 
     /**
      * @brief Actualise le contexte de la simulation après un certain pas temporel en appelant chacun des méthodes ci-dessous.
@@ -68,6 +319,18 @@ public:
      */
     void updateExpectedPosition(float dt);
 
+    /**
+     * @brief applyExternalForce puis updateExpectedPosition, fusionnées en une seule passe sur les particules
+     * @param dt Le pas temporel de la simulation
+     */
+    void applyExternalForceAndPredict(float dt);
+
+    /**
+     * @brief Détection continue des collisions (si elle est activée, voir CCDSettings): arrête les particules rapides au premier
+     * impact de leur trajectoire prédite, avant la détection des contacts.
+     */
+    void sweepFastParticles();
+
     /**
      * @brief Ajoute des contraintes statiques si un contact avec un collider et une particule est détecté
      */
@@ -79,6 +342,11 @@ public:
      */
     void addDynamicContactConstraints();
 
+    /**
+     * @brief Construit contact_offsets et contact_list à partir de S_Constraints et D_Constraints
+     */
+    void buildContactAdjacency();
+
     /**
     * @brief Résoud toutes les contraintes (statiques, entre particule, avec les bords)
     */
@@ -102,9 +370,149 @@ public:
      */
     void updateVelocityAndPosition(float dt);
 
-    void resetSimulation(){particles={};}
+    /**
+     * @brief applyFriction puis updateVelocityAndPosition, fusionnées en une seule passe sur les particules
+     * @param dt Le pas temporel de la simulation
+     */
+    void applyFrictionAndUpdate(float dt);
+
+    /**
+     * @brief Choisit la méthode de recherche des contacts entre particules.
+     * @param mode BroadphaseMode::UniformGrid (par défaut) ou BroadphaseMode::BruteForce pour la validation.
+     */
+    void setBroadphase(BroadphaseMode mode){broadphase.mode=mode;}
+
+    /**
+     * @brief Choisit la méthode de résolution des contraintes.
+     * @param mode SolverMode::Sequential (par défaut), SolverMode::Colored ou SolverMode::Jacobi.
+     */
+    void setSolverMode(SolverMode mode){solver_mode=mode;}
+
+    /**
+     * @brief Active ou règle le solveur XPBD, qui remplace la projection unique de updatePhysicalSystem.
+     * Sequential résout les contraintes une à une; Colored et Jacobi résolvent les contraintes
+     * dynamiques couleur par couleur en parallèle (l'accumulation de Jacobi n'a pas d'équivalent XPBD).
+     * @param settings Réglages, substeps et iterations sont ramenés à 1 au moins.
+     */
+    void setXPBD(const XPBDSettings& settings){xpbd=settings;xpbd.substeps=std::max(1u,xpbd.substeps);xpbd.iterations=std::max(1u,xpbd.iterations);xpbd_for_sleep=false;}
+
+    /**
+     * @brief Réglages actuels du solveur XPBD.
+     */
+    const XPBDSettings& xpbdSettings() const {return xpbd;}
+
+    /**
+     * @brief Nombre d'itérations XPBD du dernier pas, tous sous-pas confondus (0 sans XPBD).
+     */
+    unsigned lastSolverIterations() const {return solver_iterations;}
+
+    /**
+     * @brief Active ou règle la mise en sommeil des particules au repos.
+     * L'activer active aussi XPBD s'il ne l'est pas (avec ses réglages actuels, voir SleepSettings); la désactiver
+     * réveille toutes les particules et désactive XPBD s'il avait été activé ainsi.
+     */
+    void setSleep(const SleepSettings& settings);
+
+    /**
+     * @brief Réglages actuels de la mise en sommeil.
+     */
+    const SleepSettings& sleepSettings() const {return sleep;}
+
+    /**
+     * @brief Active ou règle la grille de distances aux colliders (voir sdf.h): les contacts statiques sont alors lus
+     * dans la grille, une seule contrainte par particule, au lieu d'être calculés collider par collider.
+     * La grille est calculée au prochain pas, ou par bakeColliderSDF.
+     */
+    void setColliderSDF(const ColliderSDFSettings& settings){sdf_settings=settings;collider_sdf_dirty=true;}
+
+    /**
+     * @brief Réglages actuels de la grille de distances.
+     */
+    const ColliderSDFSettings& colliderSDFSettings() const {return sdf_settings;}
+
+    /**
+     * @brief Calcule la grille de distances si elle est activée et que les colliders ou les réglages ont changé.
+     * @return La grille (vide si elle n'est pas activée).
+     */
+    const BasicColliderSDF<Real>& bakeColliderSDF();
+
+    /**
+     * @brief Active ou règle la détection continue des collisions des particules rapides.
+     */
+    void setCCD(const CCDSettings& settings){ccd=settings;}
+
+    /**
+     * @brief Réglages actuels de la détection continue des collisions.
+     */
+    const CCDSettings& ccdSettings() const {return ccd;}
+
+    /**
+     * @brief Nombre de particules rapides au dernier pas (au dernier sous-pas avec XPBD), 0 sans détection continue.
+     */
+    std::size_t lastFastParticles() const {return fast_particles.size();}
+
+    /**
+     * @brief Nombre de particules éveillées au dernier pas (toutes sans mise en sommeil).
+     */
+    std::size_t awakeCount() const {return activeCount();}
+
+    /**
+     * @brief Mémoire réservée par les tampons de travail des pas (contacts, contraintes, couleurs, multiplicateurs,
+     * îlots, broadphase...), en octets. Ces tampons gardent leur capacité d'un pas à l'autre (voir stepbuffers.h):
+     * c'est le maximum atteint depuis la création du contexte.
+     */
+    std::size_t stepBufferBytes() const;
+
+    /**
+     * @brief Réserve les tampons de travail des pas pour la capacité du ParticleStore, qui compte déjà toutes les particules
+     * des sources limitées (voir addStream). Un pas n'alloue alors plus rien tant que les contacts restent sous
+     * pairs_per_particle paires par particule et une contrainte statique par particule; au-delà, les tampons grandissent
+     * comme avant (voir stepbuffers.h). Les tampons de la détection continue ne sont réservés que si elle est activée.
+     * loadScene et loadCheckpoint l'appellent; à rappeler après avoir activé la détection continue ou ajouté des particules.
+     * @param pairs_per_particle Paires de contact prévues par particule: des disques égaux en empilement compact en ont 3
+     * (6 voisins), une pile qui s'interpénètre sous son poids près de 10 (pile.scene).
+     */
+    void reserveStepBuffers(double pairs_per_particle=12);
+
+    /**
+     * @brief Réveille toutes les particules.
+     */
+    void wakeAll();
+
+    /**
+     * @brief Choisit le nombre de threads des solveurs parallèles.
+     * @param threads Nombre de threads (appelant compris), 0 pour le nombre de coeurs de la machine.
+     */
+    void setThreadCount(unsigned threads){thread_count=threads>0?threads:std::max(1u,std::thread::hardware_concurrency());}
+
+    /**
+     * @brief Empreinte de l'état simulé: particules (positions, vitesses, rayons, masses), liens de distance et sources
+     * continues s'il y en a, champ de force, frottement et bords. Deux contextes ont la même empreinte si leurs états sont identiques au bit près.
+     */
+    std::uint64_t stateHash() const;
+
+    /**
+     * @brief Supprime toutes les particules et tous les liens.
+     */
+    void resetSimulation(){particles.clear();distances.clear();}
+
+    /**
+     * @brief Active ou désactive le frottement.
+     */
     void frictionTrigger(){if (alpha==0){alpha=alpha_value;}else{alpha=0;}}
+
+    /**
+     * @brief Active ou désactive la mise en sommeil (voir setSleep).
+     */
+    void sleepTrigger(){SleepSettings settings=sleep;settings.enabled=!sleep.enabled;setSleep(settings);}
+
+    /**
+     * @brief Fait tourner le champ de force d'un quart de tour.
+     */
     void gravityChange(){if(champ_de_force.at(0)!=0){champ_de_force={0,-champ_de_force.at(0)};}else{champ_de_force={champ_de_force.at(1),0};}}
 };
 
+using Context=BasicContext<double>;
+using ContextF=BasicContext<float>;
+
 #endif // CONTEXT_H
@@ -0,0 +1,57 @@
+/******************************************************************************
+ * @file allocationcounter.cpp
+ * @brief Opérateurs new et delete globaux qui comptent les allocations (voir allocationcounter.h).
+ *
+ * Les variantes tableau et nothrow de la bibliothèque standard appellent operator new(size): seules
+ * les versions simple et alignée sont remplacées.
+ ******************************************************************************/
+
+#include "allocationcounter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+static std::atomic<std::uint64_t> allocations{0};
+
+std::uint64_t allocationCount(){return allocations.load(std::memory_order_relaxed);}
+
+void* operator new(std::size_t size){
+    allocations.fetch_add(1,std::memory_order_relaxed);
+    if (void* p=std::malloc(size>0?size:1)){return p;}
+    throw std::bad_alloc();
+}
+
+/**
+* @brief Allocation alignée: std::aligned_alloc n'existe pas sous Windows, dont la mémoire alignée se libère à part
+*/
+static void* alignedAllocate(std::size_t size,std::size_t align){
+#ifdef _WIN32
+    return _aligned_malloc(size>0?size:1,align);
+#else
+    // aligned_alloc veut une taille multiple de l'alignement
+    const std::size_t rounded=size>0?(size+align-1)/align*align:align;
+    return std::aligned_alloc(align,rounded);
+#endif
+}
+
+static void alignedFree(void* p){
+#ifdef _WIN32
+    _aligned_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+void* operator new(std::size_t size,std::align_val_t alignment){
+    allocations.fetch_add(1,std::memory_order_relaxed);
+    if (void* p=alignedAllocate(size,(std::size_t)alignment)){return p;}
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete(void* p,std::size_t) noexcept {std::free(p);}
+void operator delete(void* p,std::align_val_t) noexcept {alignedFree(p);}
+void operator delete(void* p,std::size_t,std::align_val_t) noexcept {alignedFree(p);}
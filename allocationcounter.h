@@ -0,0 +1,23 @@
+/******************************************************************************
+ * @file allocationcounter.h
+ * @brief Compteur des allocations sur le tas du programme.
+ *
+ * allocationcounter.cpp remplace les opérateurs new et delete globaux par des versions qui comptent
+ * les allocations avant d'appeler malloc. Il n'est pas dans pbd_core: seul un programme qui le lie
+ * (pbd_run, cible pbd_allocation_counter) paie le compteur, l'interface graphique n'en a pas.
+ *
+ * Sert à vérifier qu'un pas de simulation n'alloue plus rien une fois les tampons de travail à leur
+ * taille maximale (voir stepbuffers.h): on lit allocationCount() avant et après le pas.
+ ******************************************************************************/
+
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <cstdint>
+
+/**
+ * @brief Nombre d'allocations (appels à operator new, toutes variantes) depuis le début du programme, tous threads confondus
+ */
+std::uint64_t allocationCount();
+
+#endif // ALLOCATIONCOUNTER_H
@@ -0,0 +1,171 @@
+/******************************************************************************
+ * @file batch.cpp
+ * @brief Implémentation des lots de simulations définis dans batch.h
+ ******************************************************************************/
+
+#include "batch.h"
+#include "checkpoint.h"
+#include "scene.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+
+template <class Real>
+double kineticEnergy(const BasicParticleStore<Real>& particles){
+    double energy=0;
+    for (std::size_t i=0;i<particles.size();i++){
+        double mass=particles.inv_mass[i]>0?1/(double)particles.inv_mass[i]:1;
+        energy+=0.5*mass*((double)particles.vx[i]*particles.vx[i]+(double)particles.vy[i]*particles.vy[i]);
+    }
+    return energy;
+}
+
+/**
+* @brief Vitesse quadratique moyenne des particules, 0 sans particule
+*/
+template <class Real>
+static double rmsSpeed(const BasicParticleStore<Real>& particles){
+    const std::size_t n=particles.size();
+    if (n==0){return 0;}
+    double sum=0;
+    for (std::size_t i=0;i<n;i++){sum+=(double)particles.vx[i]*particles.vx[i]+(double)particles.vy[i]*particles.vy[i];}
+    return std::sqrt(sum/n);
+}
+
+/**
+* @brief Charge la scène d'un cas, applique ses paramètres et la simule sur le thread appelant
+*/
+template <class Real>
+static BatchResult runCase(const BatchCase& c,const BatchSettings& settings){
+    BatchResult r;
+    BasicContext<Real> context;
+    r.loaded=isCheckpoint(c.scene)?loadCheckpoint(c.scene,context,&r.error):loadScene(c.scene,context,&r.error);
+    if (!r.loaded){return r;}
+    if (c.set_gravity){context.champ_de_force={Real(0),Real(c.gravity)};}
+    if (c.friction>=0){context.alpha=Real(c.friction);}
+    if (c.radius>0){
+        for (std::size_t i=0;i<context.particles.size();i++){context.particles.radius[i]=Real(c.radius);}
+        for (ParticleStream& stream:context.streams){stream.radius=c.radius;}
+    }
+    r.gravity=(double)context.champ_de_force[1];
+    r.friction=(double)context.alpha;
+
+    long calm=0;
+    auto start=std::chrono::steady_clock::now();
+    for (long s=0;s<settings.steps;s++){
+        context.updatePhysicalSystem((float)settings.dt);
+        r.steps++;
+        calm=rmsSpeed(context.particles)<settings.settle_speed?calm+1:0;
+        if (r.settle_time<0 && calm>=settings.settle_steps){
+            r.settle_time=(s+1-calm)*settings.dt;
+            if (settings.stop_when_settled){break;}
+        }
+    }
+    r.seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    r.steps_per_second=r.seconds>0?r.steps/r.seconds:0;
+    r.particles=context.particles.size();
+    r.kinetic_energy=kineticEnergy(context.particles);
+    r.rms_speed=rmsSpeed(context.particles);
+    r.hash=context.stateHash();
+    return r;
+}
+
+template <class Real>
+std::vector<BatchResult> runBatch(const std::vector<BatchCase>& cases,const BatchSettings& settings){
+    std::vector<BatchResult> results(cases.size());
+    const unsigned threads=settings.threads>0?settings.threads:std::max(1u,std::thread::hardware_concurrency());
+    // Un cas par tâche: les cas longs n'empêchent pas les autres threads de prendre les suivants
+    ThreadPool pool(threads);
+    pool.parallelFor(0,cases.size(),1,[&](std::size_t begin,std::size_t end){
+        for (std::size_t k=begin;k<end;k++){results[k]=runCase<Real>(cases[k],settings);}
+    });
+    return results;
+}
+
+/**
+* @brief Ouvre le fichier de sortie, la sortie standard pour "-"
+*/
+static FILE* openOutput(const std::string& path){return path=="-"?stdout:std::fopen(path.c_str(),"w");}
+
+static bool closeOutput(FILE* file){
+    if (file==stdout){return std::fflush(file)==0;}
+    return std::fclose(file)==0;
+}
+
+/**
+* @brief Écrit un texte entre guillemets, en doublant les guillemets (CSV) ou en les échappant (JSON)
+*/
+static void writeQuoted(FILE* file,const std::string& text,bool json){
+    std::fputc('"',file);
+    for (char ch:text){
+        if (ch=='"'){std::fputs(json?"\\\"":"\"\"",file);}
+        else if (json && ch=='\\'){std::fputs("\\\\",file);}
+        else if (json && (unsigned char)ch<0x20){std::fprintf(file,"\\u%04x",(unsigned)(unsigned char)ch);}
+        else {std::fputc(ch,file);}
+    }
+    std::fputc('"',file);
+}
+
+bool writeBatchCSV(const std::string& path,const std::vector<BatchCase>& cases,const std::vector<BatchResult>& results){
+    FILE* file=openOutput(path);
+    if (!file){return false;}
+    std::fprintf(file,"scene,gravity,friction,radius,particles,steps,kinetic_energy,rms_speed,settle_time,seconds,steps_per_second,hash,error\n");
+    for (std::size_t k=0;k<cases.size() && k<results.size();k++){
+        const BatchCase& c=cases[k];
+        const BatchResult& r=results[k];
+        writeQuoted(file,c.scene,false);
+        // Rayon vide: celui de la scène, qui peut varier d'une particule à l'autre
+        if (c.radius>0){std::fprintf(file,",%.10g,%.10g,%.10g",r.gravity,r.friction,c.radius);}
+        else {std::fprintf(file,",%.10g,%.10g,",r.gravity,r.friction);}
+        if (r.loaded){
+            // Temps de repos vide: scène pas posée
+            std::fprintf(file,",%zu,%ld,%.10g,%.10g,",r.particles,r.steps,r.kinetic_energy,r.rms_speed);
+            if (r.settle_time>=0){std::fprintf(file,"%.10g",r.settle_time);}
+            std::fprintf(file,",%.6f,%.3f,%016" PRIx64 ",",r.seconds,r.steps_per_second,r.hash);
+        }else{
+            std::fprintf(file,",,,,,,,,,");
+        }
+        writeQuoted(file,r.error,false);
+        std::fputc('\n',file);
+    }
+    return closeOutput(file);
+}
+
+bool writeBatchJSON(const std::string& path,const BatchSettings& settings,const std::vector<BatchCase>& cases,const std::vector<BatchResult>& results){
+    FILE* file=openOutput(path);
+    if (!file){return false;}
+    std::fprintf(file,"{\n  \"steps\": %ld,\n  \"dt\": %.10g,\n  \"settle_speed\": %.10g,\n  \"settle_steps\": %ld,\n  \"stop_when_settled\": %s,\n  \"cases\": [\n",
+                 settings.steps,settings.dt,settings.settle_speed,settings.settle_steps,settings.stop_when_settled?"true":"false");
+    const std::size_t n=std::min(cases.size(),results.size());
+    for (std::size_t k=0;k<n;k++){
+        const BatchCase& c=cases[k];
+        const BatchResult& r=results[k];
+        std::fprintf(file,"    {\"scene\": ");
+        writeQuoted(file,c.scene,true);
+        if (!r.loaded){
+            std::fprintf(file,", \"error\": ");
+            writeQuoted(file,r.error,true);
+        }else{
+            std::fprintf(file,", \"gravity\": %.10g, \"friction\": %.10g, \"radius\": ",r.gravity,r.friction);
+            if (c.radius>0){std::fprintf(file,"%.10g",c.radius);}
+            else {std::fprintf(file,"null");}
+            std::fprintf(file,",\n     \"particles\": %zu, \"steps\": %ld, \"kinetic_energy\": %.10g, \"rms_speed\": %.10g, \"settle_time\": ",
+                         r.particles,r.steps,r.kinetic_energy,r.rms_speed);
+            if (r.settle_time>=0){std::fprintf(file,"%.10g",r.settle_time);}
+            else {std::fprintf(file,"null");}
+            std::fprintf(file,",\n     \"seconds\": %.6f, \"steps_per_second\": %.3f, \"hash\": \"%016" PRIx64 "\"",r.seconds,r.steps_per_second,r.hash);
+        }
+        std::fprintf(file,"}%s\n",k+1<n?",":"");
+    }
+    std::fprintf(file,"  ]\n}\n");
+    return closeOutput(file);
+}
+
+template double kineticEnergy<float>(const BasicParticleStore<float>&);
+template double kineticEnergy<double>(const BasicParticleStore<double>&);
+template std::vector<BatchResult> runBatch<float>(const std::vector<BatchCase>&,const BatchSettings&);
+template std::vector<BatchResult> runBatch<double>(const std::vector<BatchCase>&,const BatchSettings&);
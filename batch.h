@@ -0,0 +1,96 @@
+/******************************************************************************
+ * @file batch.h
+ * @brief Lots de simulations indépendantes (balayages de paramètres) répartis sur un ThreadPool.
+ *
+ * Chaque cas d'un lot charge une scène dans son propre contexte, remplace éventuellement sa gravité,
+ * son frottement et le rayon de ses particules, puis la simule sur un seul thread. Les cas sont
+ * répartis entre les threads du pool (un cas par tâche, vol de tâches entre threads): un lot de
+ * centaines de petites scènes occupe tous les cœurs dans un seul processus.
+ *
+ * Les résultats d'un cas ne dépendent pas du nombre de threads du lot (sauf les durées): chaque
+ * contexte est simulé seul et de façon déterministe (voir Context::stateHash).
+ ******************************************************************************/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "Context.h"
+
+/**
+ * @struct BatchCase
+ * @brief Une simulation du lot: une scène et les paramètres qui remplacent les siens.
+ */
+struct BatchCase {
+    std::string scene;  /**< Fichier de scène ou point de reprise (voir scene.h, checkpoint.h) */
+    bool set_gravity=false; /**< Vrai: la gravité de la scène est remplacée par (0,gravity) */
+    double gravity=0;
+    double friction=-1; /**< Coefficient de frottement (Context::alpha), négatif: celui de la scène */
+    double radius=-1;   /**< Rayon de toutes les particules et des sources, négatif ou nul: ceux de la scène */
+};
+
+/**
+ * @struct BatchSettings
+ * @brief Réglages communs à tous les cas d'un lot.
+ *
+ * Une scène est posée quand la vitesse quadratique moyenne de ses particules reste sous settle_speed
+ * pendant settle_steps pas consécutifs; son temps de repos est l'instant du premier de ces pas.
+ */
+struct BatchSettings {
+    unsigned threads=0;       /**< Threads du lot, 0: un par cœur */
+    long steps=1000;          /**< Pas simulés par cas */
+    double dt=0.2;            /**< Pas de temps */
+    double settle_speed=0.1;  /**< Vitesse quadratique moyenne d'une scène au repos, comme SleepSettings::velocity */
+    long settle_steps=30;     /**< Pas consécutifs sous settle_speed pour qu'une scène soit posée */
+    bool stop_when_settled=false; /**< Vrai: un cas s'arrête dès que sa scène est posée */
+};
+
+/**
+ * @struct BatchResult
+ * @brief Mesures d'un cas, dans l'ordre des cas du lot.
+ */
+struct BatchResult {
+    bool loaded=false;       /**< Faux si la scène n'a pas pu être chargée (voir error) */
+    std::string error;
+    std::size_t particles=0; /**< Particules à la fin de la simulation */
+    double gravity=0;        /**< Gravité et frottement effectivement simulés (ceux de la scène s'ils ne sont pas remplacés) */
+    double friction=0;
+    long steps=0;            /**< Pas simulés (moins que BatchSettings::steps si le cas s'est arrêté une fois posé) */
+    double kinetic_energy=0; /**< Énergie cinétique finale */
+    double rms_speed=0;      /**< Vitesse quadratique moyenne finale */
+    double settle_time=-1;   /**< Temps de repos (voir BatchSettings), négatif si la scène ne s'est pas posée */
+    double seconds=0;        /**< Durée de la simulation, chargement exclu */
+    double steps_per_second=0;
+    std::uint64_t hash=0;    /**< Empreinte de l'état final (Context::stateHash) */
+};
+
+/**
+ * @brief Énergie cinétique des particules, en double; une particule de masse infinie compte comme une masse unité.
+ */
+template <class Real>
+double kineticEnergy(const BasicParticleStore<Real>& particles);
+
+/**
+ * @brief Simule tous les cas du lot en parallèle, chacun dans un contexte de précision Real.
+ * @return Les mesures de chaque cas, dans l'ordre de cases.
+ */
+template <class Real>
+std::vector<BatchResult> runBatch(const std::vector<BatchCase>& cases,const BatchSettings& settings);
+
+/**
+ * @brief Écrit les cas et leurs mesures en CSV (une ligne par cas, précédée d'une ligne d'en-tête).
+ * @param path Chemin du fichier, "-" pour la sortie standard.
+ * @return false si le fichier ne peut être écrit.
+ */
+bool writeBatchCSV(const std::string& path,const std::vector<BatchCase>& cases,const std::vector<BatchResult>& results);
+
+/**
+ * @brief Écrit les réglages, les cas et leurs mesures en JSON.
+ * @param path Chemin du fichier, "-" pour la sortie standard.
+ * @return false si le fichier ne peut être écrit.
+ */
+bool writeBatchJSON(const std::string& path,const BatchSettings& settings,const std::vector<BatchCase>& cases,const std::vector<BatchResult>& results);
+
+#endif // BATCH_H
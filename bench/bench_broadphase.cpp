@@ -0,0 +1,81 @@
+/******************************************************************************
+ * @file bench_broadphase.cpp
+ * @brief Mesure le temps de recherche des contacts entre particules de 1k à 1M particules.
+ *
+ * Les particules sont placées sur une grille perturbée aléatoirement (densité constante),
+ * comme un tas de particules au repos. Pour les petites tailles, la méthode exhaustive est
+ * aussi mesurée et on vérifie que les deux méthodes trouvent exactement les mêmes paires.
+ *
+ * Usage: bench_broadphase [nombre_max_de_particules]
+ ******************************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "../broadphase.h"
+
+/**
+* @brief Remplit le ParticleStore avec n particules de rayon 1 à 1.5 sur une grille de pas 2.5
+*/
+static void fillPile(ParticleStore& particles,std::size_t n){
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<double> jitter(-0.5,0.5);
+    std::uniform_real_distribution<double> radius(1.0,1.5);
+    std::size_t side=(std::size_t)std::ceil(std::sqrt((double)n));
+    particles.clear();
+    particles.reserve(n);
+    for (std::size_t k=0;k<n;k++){
+        particle p;
+        p.pos={(k%side)*2.5+jitter(rng),(k/side)*2.5+jitter(rng)};
+        p.radius=radius(rng);
+        p.mass=1;
+        particles.add(p);
+    }
+}
+
+/**
+* @brief Temps moyen (en ms) d'un appel à findContacts
+*/
+static double timeFindContacts(Broadphase& broadphase,const ParticleStore& particles,std::vector<ContactPair>& pairs,int repetitions){
+    auto start=std::chrono::steady_clock::now();
+    for (int r=0;r<repetitions;r++){broadphase.findContacts(particles,pairs);}
+    auto end=std::chrono::steady_clock::now();
+    return std::chrono::duration<double,std::milli>(end-start).count()/repetitions;
+}
+
+int main(int argc,char* argv[]){
+    std::size_t max_n=argc>1?std::strtoul(argv[1],nullptr,10):1000000;
+    const std::size_t brute_force_limit=20000;
+    bool all_equal=true;
+
+    std::printf("%10s %12s %14s %14s %8s\n","particles","pairs","grid (ms)","brute (ms)","equal");
+    for (std::size_t n=1000;n<=max_n;n*=10){
+        for (std::size_t m:{n,n*2,n*5}){
+            if (m>max_n){break;}
+            ParticleStore particles;
+            fillPile(particles,m);
+
+            Broadphase grid;
+            grid.mode=BroadphaseMode::UniformGrid;
+            std::vector<ContactPair> grid_pairs;
+            int repetitions=m<=100000?10:2;
+            double grid_ms=timeFindContacts(grid,particles,grid_pairs,repetitions);
+
+            if (m<=brute_force_limit){
+                Broadphase brute;
+                brute.mode=BroadphaseMode::BruteForce;
+                std::vector<ContactPair> brute_pairs;
+                double brute_ms=timeFindContacts(brute,particles,brute_pairs,1);
+                bool equal=grid_pairs==brute_pairs;
+                all_equal=all_equal && equal;
+                std::printf("%10zu %12zu %14.3f %14.3f %8s\n",m,grid_pairs.size(),grid_ms,brute_ms,equal?"yes":"NO");
+            }else{
+                std::printf("%10zu %12zu %14.3f %14s %8s\n",m,grid_pairs.size(),grid_ms,"-","-");
+            }
+        }
+    }
+    return all_equal?0:1;
+}
@@ -0,0 +1,145 @@
+/******************************************************************************
+ * @file bench_ccd.cpp
+ * @brief Mesure la traversée d'une étagère mince par un bloc de particules lâché de haut, selon le pas de temps,
+ * sans puis avec la détection continue des collisions (CCDSettings).
+ *
+ * La scène est celle de scenes/drop.scene, agrandie: un bloc de particules immobiles tombe de 1 900 sur deux
+ * plans dos à dos (10 d'épaisseur) et arrive à environ 136 par unité de temps. Pour chaque pas de temps, on
+ * simule la même durée et on mesure:
+ * - le nombre de traversées de l'étagère (une particule passe d'un côté à l'autre en un pas, au droit de l'étagère);
+ * - le temps de calcul de la durée simulée et le nombre de pas par seconde;
+ * - le nombre moyen de particules rapides par pas avec la détection continue.
+ * Les résultats sont écrits en JSON (le texte lisible va sur la sortie d'erreur).
+ *
+ * Sans détection continue, seul un petit pas évite les traversées; avec elle, un grand pas reste sans traversée
+ * pour une fraction du coût.
+ *
+ * Usage: bench_ccd [--quick] [--duration T] [--xpbd sous_pas,itérations|off] [--real float|double] [--out fichier.json]
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "../Context.h"
+
+/**
+ * @struct CCDResult
+ * @brief Mesures sur un pas de temps, avec ou sans détection continue.
+ */
+struct CCDResult {
+    double dt=0;
+    bool ccd=false;
+    std::size_t particles=0;
+    long steps=0;
+    std::size_t crossings=0; /**< Traversées de l'étagère */
+    double seconds=0;        /**< Temps de calcul de la durée simulée */
+    double fast_per_step=0;  /**< Particules rapides par pas */
+};
+
+static const double radius=5,mass=1,spacing=12;
+static const double shelf_y=2000,shelf_thickness=10,shelf_length=450;
+
+template <class Real>
+static CCDResult runCase(std::size_t cols,std::size_t rows,double dt,bool ccd,double duration,const XPBDSettings& xpbd){
+    CCDResult r;
+    r.dt=dt;
+    r.ccd=ccd;
+    BasicContext<Real> context;
+    context.width=1000;
+    context.height=2400;
+    context.alpha=0.003;
+    context.addCollider(basic_plancollider<Real>(std::make_pair(500.0,shelf_y),shelf_length,0));
+    context.addCollider(basic_plancollider<Real>(std::make_pair(500.0,shelf_y+shelf_thickness),shelf_length,M_PI));
+    context.emitGrid(500-(cols-1)*spacing/2,100,cols,rows,spacing,radius,mass);
+    context.setXPBD(xpbd);
+    CCDSettings settings;
+    settings.enabled=ccd;
+    context.setCCD(settings);
+    r.particles=context.particles.size();
+    r.steps=(long)std::ceil(duration/dt);
+
+    std::vector<double> before(r.particles);
+    unsigned long long fast=0;
+    for (long s=0;s<r.steps;s++){
+        for (std::size_t i=0;i<r.particles;i++){before[i]=context.particles.y[i];}
+        auto start=std::chrono::steady_clock::now();
+        context.updatePhysicalSystem((float)dt);
+        r.seconds+=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+        fast+=context.lastFastParticles();
+        // Les particules ne sont ni ajoutées ni retirées: les indices restent ceux du pas précédent
+        for (std::size_t i=0;i<r.particles;i++){
+            double x=context.particles.x[i],y=context.particles.y[i];
+            if (std::abs(x-500)>shelf_length-radius){continue;}
+            if ((before[i]<shelf_y && y>shelf_y+shelf_thickness) || (before[i]>shelf_y+shelf_thickness && y<shelf_y)){r.crossings++;}
+        }
+    }
+    r.fast_per_step=r.steps>0?(double)fast/r.steps:0;
+    return r;
+}
+
+static void usage(){
+    std::fprintf(stderr,"usage: bench_ccd [--quick] [--duration T] [--xpbd sous_pas,itérations|off] [--real float|double] [--out fichier.json]\n");
+}
+
+int main(int argc,char* argv[]){
+    bool quick=false;
+    double duration=300;
+    const char* out_path=nullptr;
+    XPBDSettings xpbd;
+    xpbd.enabled=true;
+    bool real_float=false;
+
+    for (int a=1;a<argc;a++){
+        const char* option=argv[a];
+        if (std::strcmp(option,"--quick")==0){quick=true;continue;}
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){usage(); return 2;}
+        a++;
+        if (std::strcmp(option,"--duration")==0){duration=std::atof(value);}
+        else if (std::strcmp(option,"--out")==0){out_path=value;}
+        else if (std::strcmp(option,"--xpbd")==0){
+            if (std::strcmp(value,"off")==0){xpbd.enabled=false;}
+            else if (std::sscanf(value,"%u,%u",&xpbd.substeps,&xpbd.iterations)!=2){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){real_float=true;}
+            else if (std::strcmp(value,"double")==0){real_float=false;}
+            else {usage(); return 2;}
+        }
+        else {usage(); return 2;}
+    }
+    if (!(duration>0)){usage(); return 2;}
+
+    // Bloc de 20x10 particules (celui de scenes/drop.scene), ou 60x20 hors --quick
+    const std::size_t cols=quick?20:60,rows=quick?10:20;
+    std::vector<double> steps=quick?std::vector<double>{0.05,0.2,1}:std::vector<double>{0.02,0.05,0.2,0.5,1,2};
+
+    FILE* out=out_path?std::fopen(out_path,"w"):stdout;
+    if (!out){
+        std::fprintf(stderr,"bench_ccd: impossible d'écrire %s\n",out_path);
+        return 1;
+    }
+    std::fprintf(out,"{\n  \"benchmark\": \"bench_ccd\",\n  \"real\": \"%s\",\n  \"duration\": %g,\n  \"xpbd\": ",real_float?"float":"double",duration);
+    if (xpbd.enabled){std::fprintf(out,"{\"substeps\": %u, \"iterations\": %u},\n",xpbd.substeps,xpbd.iterations);}
+    else {std::fprintf(out,"null,\n");}
+    std::fprintf(out,"  \"cases\": [\n");
+    std::fprintf(stderr,"%6s %4s %9s %7s %9s %10s %10s %10s\n","dt","ccd","particles","steps","crossings","time (s)","steps/s","fast/step");
+    for (std::size_t k=0;k<steps.size();k++){
+        for (int ccd=0;ccd<2;ccd++){
+            CCDResult r=real_float?runCase<float>(cols,rows,steps[k],ccd==1,duration,xpbd):runCase<double>(cols,rows,steps[k],ccd==1,duration,xpbd);
+            double rate=r.seconds>0?r.steps/r.seconds:0;
+            std::fprintf(stderr,"%6g %4s %9zu %7ld %9zu %10.3f %10.1f %10.2f\n",r.dt,r.ccd?"on":"off",r.particles,r.steps,r.crossings,r.seconds,rate,r.fast_per_step);
+            std::fprintf(out,"    {\"dt\": %g, \"ccd\": %s, \"particles\": %zu, \"steps\": %ld, \"crossings\": %zu,\n"
+                             "     \"seconds\": %.6f, \"steps_per_second\": %.3f, \"fast_per_step\": %.3f}%s\n",
+                         r.dt,r.ccd?"true":"false",r.particles,r.steps,r.crossings,r.seconds,rate,r.fast_per_step,
+                         k+1<steps.size() || ccd==0?",":"");
+        }
+    }
+    std::fprintf(out,"  ]\n}\n");
+    if (out!=stdout){std::fclose(out);}
+    return 0;
+}
@@ -0,0 +1,71 @@
+/******************************************************************************
+ * @file bench_kernels.cpp
+ * @brief Mesure le débit des étapes d'intégration pour chaque jeu d'instructions.
+ *
+ * Pour chaque jeu d'instructions disponible (scalar, sse2, avx2, avx512), on mesure
+ * les quatre étapes séparées (applyExternalForce, updateExpectedPosition, applyFriction,
+ * updateVelocityAndPosition) puis les deux passes fusionnées utilisées par
+ * Context::updatePhysicalSystem. Le débit est donné en millions de particules par seconde,
+ * pour un ensemble qui tient dans le cache et pour un ensemble qui n'y tient pas, en double puis
+ * en float (deux fois plus de particules par instruction, moitié moins de mémoire parcourue).
+ *
+ * Usage: bench_kernels [nombre_de_particules...]
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "../kernels.h"
+
+/**
+* @brief Débit (millions de particules par seconde) d'une fonction appelée sur n particules
+*/
+template <class F>
+static double throughput(std::size_t n,F f){
+    // On répète jusqu'à environ 2e8 particules traitées
+    int repetitions=(int)std::max<std::size_t>(3,200000000/std::max<std::size_t>(n,1));
+    f();
+    auto start=std::chrono::steady_clock::now();
+    for (int r=0;r<repetitions;r++){f();}
+    auto end=std::chrono::steady_clock::now();
+    double seconds=std::chrono::duration<double>(end-start).count();
+    return n*(double)repetitions/seconds/1e6;
+}
+
+/**
+* @brief Mesure toutes les fonctions de chaque jeu d'instructions, dans la précision Real
+*/
+template <class Real>
+static void benchPrecision(const std::vector<std::size_t>& sizes,const char* real){
+    const Real dt=0.2,gx=0,gy=Real(9.81/2*0.2),alpha=0.003;
+    for (std::size_t n:sizes){
+        for (const char* name:{"scalar","sse2","avx2","avx512"}){
+            const BasicStageKernels<Real>* k=stageKernelsFor<Real>(name);
+            if (!k){continue;}
+            // Tableaux remis à zéro à chaque jeu: en float, les vitesses amorties d'un jeu à l'autre
+            // finiraient dans les nombres dénormalisés et fausseraient la mesure
+            std::vector<Real> x(n,1),y(n,2),px(n),py(n),vx(n,0.5),vy(n,-0.5);
+            double force=throughput(n,[&]{k->applyForce(vx.data(),vy.data(),n,gx,gy);});
+            double predict=throughput(n,[&]{k->predict(x.data(),y.data(),vx.data(),vy.data(),px.data(),py.data(),n,dt);});
+            double friction=throughput(n,[&]{k->damp(vx.data(),vy.data(),n,alpha);});
+            double commit=throughput(n,[&]{k->commit(x.data(),y.data(),px.data(),py.data(),n);});
+            double fused1=throughput(n,[&]{k->applyForceAndPredict(x.data(),y.data(),vx.data(),vy.data(),px.data(),py.data(),n,gx,gy,dt);});
+            double fused2=throughput(n,[&]{k->dampAndCommit(x.data(),y.data(),px.data(),py.data(),vx.data(),vy.data(),n,alpha);});
+            std::printf("%10zu %8s %7s %10.1f %10.1f %10.1f %10.1f %12.1f %12.1f\n",n,name,real,force,predict,friction,commit,fused1,fused2);
+        }
+    }
+}
+
+int main(int argc,char* argv[]){
+    std::vector<std::size_t> sizes;
+    for (int a=1;a<argc;a++){sizes.push_back(std::strtoul(argv[a],nullptr,10));}
+    if (sizes.empty()){sizes={16384,4000000};}
+
+    std::printf("%10s %8s %7s %10s %10s %10s %10s %12s %12s\n","particles","isa","real","force","predict","friction","commit","force+pred","frict+comm");
+    benchPrecision<double>(sizes,"double");
+    benchPrecision<float>(sizes,"float");
+    std::printf("(millions de particules par seconde; PBD_SIMD choisirait: %s)\n",stageKernels().name);
+    return 0;
+}
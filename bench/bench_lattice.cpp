@@ -0,0 +1,199 @@
+/******************************************************************************
+ * @file bench_lattice.cpp
+ * @brief Mesure le coût des liens de distance sur des treillis de 2 500 à 250 000 particules.
+ *
+ * Chaque cas est un treillis carré (Context::emitLattice: liens horizontaux, verticaux et diagonaux,
+ * soit environ 4 liens par particule) qui tombe au fond d'une boîte sous gravité. On mesure:
+ * - l'ajout des liens en un seul lot (DistanceConstraints::add) et leur suppression en lots
+ *   (removeAttached sur une ligne de particules, remove d'un lien sur sept);
+ * - le temps moyen d'un pas avec les liens, et celui d'un pas sur la même grille sans lien;
+ * - l'allongement relatif maximal des liens à la fin du cas (0 pour des liens parfaitement rigides).
+ * Les résultats sont écrits en JSON (le texte lisible va sur la sortie d'erreur).
+ *
+ * Usage: bench_lattice [--quick] [--steps N] [--threads T] [--solver sequential|colored|jacobi]
+ *                      [--xpbd sous_pas,itérations] [--real float|double] [--out fichier.json]
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "../Context.h"
+#include "../kernels.h"
+
+/**
+ * @struct LatticeResult
+ * @brief Temps mesurés (en ms) sur un treillis.
+ */
+struct LatticeResult {
+    std::size_t particles=0;
+    std::size_t links=0;
+    std::size_t colors=0; /**< Couleurs des liens (solveurs parallèles) */
+    double add_ms=0;      /**< Ajout de tous les liens en un lot */
+    double remove_row_ms=0;   /**< removeAttached sur une ligne de particules */
+    double remove_every_ms=0; /**< remove d'un lien sur sept */
+    double step_ms=0;         /**< Pas moyen avec les liens */
+    double step_free_ms=0;    /**< Pas moyen sur la même grille sans lien */
+    double max_stretch=0;     /**< Allongement relatif maximal des liens après les pas */
+};
+
+static const double radius=5,mass=1,spacing=2.2*radius;
+
+static double elapsedMs(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+/**
+* @brief Boîte et réglages communs aux deux versions d'un cas
+*/
+template <class Real>
+static void setupContext(BasicContext<Real>& context,std::size_t side,unsigned threads,SolverMode solver,const XPBDSettings& xpbd){
+    context.width=(int)(side*spacing+40);
+    context.height=(int)(side*spacing*1.5+40);
+    context.setThreadCount(threads);
+    context.setSolverMode(solver);
+    context.setXPBD(xpbd);
+}
+
+/**
+* @brief Temps moyen (en ms) d'un pas, après quelques pas de mise en route
+*/
+template <class Real>
+static double timeSteps(BasicContext<Real>& context,int steps){
+    const float dt=0.2f;
+    for (int s=0;s<5;s++){context.updatePhysicalSystem(dt);}
+    auto start=std::chrono::steady_clock::now();
+    for (int s=0;s<steps;s++){context.updatePhysicalSystem(dt);}
+    return elapsedMs(start)/steps;
+}
+
+template <class Real>
+static LatticeResult runCase(std::size_t side,int steps,unsigned threads,SolverMode solver,const XPBDSettings& xpbd){
+    LatticeResult r;
+
+    // Grille seule, puis liens ajoutés en un lot: mêmes liens que emitLattice
+    BasicContext<Real> context;
+    setupContext(context,side,threads,solver,xpbd);
+    context.emitGrid(20+radius,20+radius,side,side,spacing,radius,mass);
+    std::vector<BasicDistanceConstraint<Real>> links;
+    links.reserve(4*side*side);
+    auto handle=[&](std::size_t row,std::size_t col){return context.particles.handleAt(row*side+col);};
+    BasicDistanceConstraint<Real> link;
+    for (std::size_t row=0;row<side;row++){
+        for (std::size_t col=0;col<side;col++){
+            link.first=handle(row,col);
+            if (col+1<side){link.second=handle(row,col+1);links.push_back(link);}
+            if (row+1<side){link.second=handle(row+1,col);links.push_back(link);}
+            if (col+1<side && row+1<side){link.second=handle(row+1,col+1);links.push_back(link);}
+            if (col>0 && row+1<side){link.second=handle(row+1,col-1);links.push_back(link);}
+        }
+    }
+    auto start=std::chrono::steady_clock::now();
+    r.links=context.distances.add(links,context.particles);
+    r.add_ms=elapsedMs(start);
+    r.particles=context.particles.size();
+
+    r.step_ms=timeSteps(context,steps);
+    r.colors=context.distances.color_offsets.size()-1;
+    for (std::size_t k=0;k<context.distances.size();k++){
+        std::size_t i=context.particles.indexOf(context.distances.first[k]);
+        std::size_t j=context.particles.indexOf(context.distances.second[k]);
+        double dx=context.particles.x[j]-context.particles.x[i];
+        double dy=context.particles.y[j]-context.particles.y[i];
+        r.max_stretch=std::max(r.max_stretch,std::abs(std::sqrt(dx*dx+dy*dy)/context.distances.rest_length[k]-1));
+    }
+
+    // Suppressions par lots: une ligne du milieu, puis un lien sur sept
+    std::vector<ParticleHandle> row;
+    for (std::size_t col=0;col<side;col++){row.push_back(handle(side/2,col));}
+    start=std::chrono::steady_clock::now();
+    context.distances.removeAttached(row);
+    r.remove_row_ms=elapsedMs(start);
+    std::vector<std::uint32_t> every;
+    for (std::uint32_t k=0;k<context.distances.size();k+=7){every.push_back(k);}
+    start=std::chrono::steady_clock::now();
+    context.distances.remove(every);
+    r.remove_every_ms=elapsedMs(start);
+
+    BasicContext<Real> free_grid;
+    setupContext(free_grid,side,threads,solver,xpbd);
+    free_grid.emitGrid(20+radius,20+radius,side,side,spacing,radius,mass);
+    r.step_free_ms=timeSteps(free_grid,steps);
+    return r;
+}
+
+static void usage(){
+    std::fprintf(stderr,"usage: bench_lattice [--quick] [--steps N] [--threads T] "
+                        "[--solver sequential|colored|jacobi] [--xpbd sous_pas,itérations] [--real float|double] [--out fichier.json]\n");
+}
+
+int main(int argc,char* argv[]){
+    bool quick=false;
+    int steps=0;
+    unsigned threads=1;
+    SolverMode solver=SolverMode::Sequential;
+    const char* solver_name="sequential";
+    const char* out_path=nullptr;
+    XPBDSettings xpbd;
+    xpbd.enabled=true;
+    bool real_float=false;
+
+    for (int a=1;a<argc;a++){
+        const char* option=argv[a];
+        if (std::strcmp(option,"--quick")==0){quick=true;continue;}
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){usage(); return 2;}
+        a++;
+        if (std::strcmp(option,"--steps")==0){steps=std::atoi(value);}
+        else if (std::strcmp(option,"--threads")==0){threads=(unsigned)std::atoi(value);}
+        else if (std::strcmp(option,"--out")==0){out_path=value;}
+        else if (std::strcmp(option,"--xpbd")==0){
+            if (std::sscanf(value,"%u,%u",&xpbd.substeps,&xpbd.iterations)!=2){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){real_float=true;}
+            else if (std::strcmp(value,"double")==0){real_float=false;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--solver")==0){
+            solver_name=value;
+            if (std::strcmp(value,"sequential")==0){solver=SolverMode::Sequential;}
+            else if (std::strcmp(value,"colored")==0){solver=SolverMode::Colored;}
+            else if (std::strcmp(value,"jacobi")==0){solver=SolverMode::Jacobi;}
+            else {usage(); return 2;}
+        }
+        else {usage(); return 2;}
+    }
+
+    std::vector<std::size_t> sides=quick?std::vector<std::size_t>{50,100}:std::vector<std::size_t>{50,100,200,500};
+
+    FILE* out=out_path?std::fopen(out_path,"w"):stdout;
+    if (!out){
+        std::fprintf(stderr,"bench_lattice: impossible d'écrire %s\n",out_path);
+        return 1;
+    }
+    std::fprintf(out,"{\n  \"benchmark\": \"bench_lattice\",\n  \"simd\": \"%s\",\n  \"real\": \"%s\",\n  \"threads\": %u,\n  \"solver\": \"%s\",\n"
+                     "  \"xpbd\": {\"substeps\": %u, \"iterations\": %u},\n  \"cases\": [\n",
+                 stageKernels().name,real_float?"float":"double",threads,solver_name,xpbd.substeps,xpbd.iterations);
+    std::fprintf(stderr,"%9s %9s %6s %10s %10s %10s %10s %10s %10s %10s\n","particles","links","colors",
+                 "add (ms)","cut row","cut 1/7","step (ms)","no links","links (ms)","stretch");
+    for (std::size_t k=0;k<sides.size();k++){
+        std::size_t side=sides[k];
+        int n_steps=steps>0?steps:(int)std::max<std::size_t>(5,2000000/(side*side)/4);
+        LatticeResult r=real_float?runCase<float>(side,n_steps,threads,solver,xpbd):runCase<double>(side,n_steps,threads,solver,xpbd);
+        // Coût des liens: écart avec le même pas sans lien (les contacts diffèrent un peu: le treillis ne s'affaisse pas comme la grille)
+        std::fprintf(stderr,"%9zu %9zu %6zu %10.3f %10.3f %10.3f %10.3f %10.3f %10.3f %10.2g\n",r.particles,r.links,r.colors,
+                     r.add_ms,r.remove_row_ms,r.remove_every_ms,r.step_ms,r.step_free_ms,r.step_ms-r.step_free_ms,r.max_stretch);
+        std::fprintf(out,"    {\"particles\": %zu, \"links\": %zu, \"colors\": %zu, \"steps\": %d,\n"
+                         "     \"add_ms\": %.6f, \"remove_row_ms\": %.6f, \"remove_every_7_ms\": %.6f,\n"
+                         "     \"step_ms\": %.6f, \"step_without_links_ms\": %.6f, \"max_stretch\": %.6g}%s\n",
+                     r.particles,r.links,r.colors,n_steps,r.add_ms,r.remove_row_ms,r.remove_every_ms,
+                     r.step_ms,r.step_free_ms,r.max_stretch,k+1<sides.size()?",":"");
+    }
+    std::fprintf(out,"  ]\n}\n");
+    if (out!=stdout){std::fclose(out);}
+    return 0;
+}
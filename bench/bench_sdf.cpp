@@ -0,0 +1,165 @@
+/******************************************************************************
+ * @file bench_sdf.cpp
+ * @brief Compare la détection des contacts statiques exacte (collider par collider) et par la grille
+ * de distances (ColliderSDF), de 8 à 4 096 colliders.
+ *
+ * Chaque cas tire des plans et des sphères au hasard (graine fixe) dans une boîte remplie de particules
+ * immobiles. On mesure:
+ * - le calcul de la grille et sa taille;
+ * - le temps moyen de addStaticContactConstraints sur les mêmes positions, sans puis avec la grille,
+ *   et le nombre de contraintes trouvées par chaque méthode;
+ * - l'écart de la grille au calcul exact (ColliderSDF::measureError): le cas échoue (code de retour 1)
+ *   si un écart de distance dépasse la borne cell_size/√2.
+ * Les résultats sont écrits en JSON (le texte lisible va sur la sortie d'erreur).
+ *
+ * Le pas de la grille est de 2 par défaut (la boîte fait 3 000 de côté).
+ *
+ * Usage: bench_sdf [--quick] [--steps N] [--cell pas] [--real float|double] [--out fichier.json]
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+#include "../Context.h"
+
+/**
+ * @struct SDFResult
+ * @brief Mesures sur un nombre de colliders.
+ */
+struct SDFResult {
+    std::size_t particles=0;
+    std::size_t colliders=0;
+    std::size_t nodes=0;
+    double memory_mb=0;
+    double bake_ms=0;       /**< Calcul de la grille */
+    double exact_ms=0;      /**< addStaticContactConstraints sans la grille */
+    double sdf_ms=0;        /**< addStaticContactConstraints avec la grille */
+    std::size_t exact_constraints=0;
+    std::size_t sdf_constraints=0;
+    SDFError error;
+};
+
+static const double radius=5,mass=1,side=3000;
+
+static double elapsedMs(std::chrono::steady_clock::time_point start){
+    return std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+}
+
+/**
+* @brief Temps moyen (en ms) de la détection des contacts statiques, et nombre de contraintes trouvées
+*/
+template <class Real>
+static double timeStaticContacts(BasicContext<Real>& context,int steps,std::size_t& constraints){
+    context.addStaticContactConstraints();
+    constraints=context.S_Constraints.size();
+    context.deleteContactConstraints();
+    double total=0;
+    for (int s=0;s<steps;s++){
+        auto start=std::chrono::steady_clock::now();
+        context.addStaticContactConstraints();
+        total+=elapsedMs(start);
+        context.deleteContactConstraints();
+    }
+    return total/steps;
+}
+
+template <class Real>
+static SDFResult runCase(std::size_t n_colliders,std::size_t n_particles,int steps,double cell){
+    SDFResult r;
+    BasicContext<Real> context;
+    context.width=(int)side;
+    context.height=(int)side;
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<double> position(0,side),angle(-M_PI,M_PI),length(20,60),sphere(10,30);
+    for (std::size_t k=0;k<n_colliders;k++){
+        if (k%2==0){context.addCollider(basic_plancollider<Real>(std::make_pair(position(rng),position(rng)),length(rng),angle(rng)));}
+        else {context.addCollider(basic_spherecollider<Real>(std::make_pair(position(rng),position(rng)),sphere(rng)));}
+    }
+    context.emitRandom(0,0,side,side,n_particles,radius,mass,7);
+    r.particles=context.particles.size();
+    r.colliders=context.colliders.size();
+    // Positions prédites sans gravité: les particules restent où elles ont été tirées
+    context.champ_de_force={0,0};
+    context.applyExternalForceAndPredict(0.2f);
+
+    r.exact_ms=timeStaticContacts(context,steps,r.exact_constraints);
+
+    ColliderSDFSettings settings;
+    settings.enabled=true;
+    settings.cell_size=cell;
+    context.setColliderSDF(settings);
+    auto start=std::chrono::steady_clock::now();
+    const BasicColliderSDF<Real>& sdf=context.bakeColliderSDF();
+    r.bake_ms=elapsedMs(start);
+    r.nodes=sdf.columns()*sdf.rows();
+    r.memory_mb=sdf.memoryBytes()/1e6;
+    r.sdf_ms=timeStaticContacts(context,steps,r.sdf_constraints);
+    r.error=sdf.measureError(context.colliders,radius,20000,11);
+    return r;
+}
+
+static void usage(){
+    std::fprintf(stderr,"usage: bench_sdf [--quick] [--steps N] [--cell pas] [--real float|double] [--out fichier.json]\n");
+}
+
+int main(int argc,char* argv[]){
+    bool quick=false;
+    int steps=20;
+    double cell=2;
+    const char* out_path=nullptr;
+    bool real_float=false;
+
+    for (int a=1;a<argc;a++){
+        const char* option=argv[a];
+        if (std::strcmp(option,"--quick")==0){quick=true;continue;}
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){usage(); return 2;}
+        a++;
+        if (std::strcmp(option,"--steps")==0){steps=std::max(1,std::atoi(value));}
+        else if (std::strcmp(option,"--cell")==0){cell=std::atof(value);}
+        else if (std::strcmp(option,"--out")==0){out_path=value;}
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){real_float=true;}
+            else if (std::strcmp(value,"double")==0){real_float=false;}
+            else {usage(); return 2;}
+        }
+        else {usage(); return 2;}
+    }
+    if (!(cell>0)){usage(); return 2;}
+
+    std::vector<std::size_t> counts=quick?std::vector<std::size_t>{8,64,512}:std::vector<std::size_t>{8,64,512,4096};
+    const std::size_t n_particles=quick?20000:50000;
+
+    FILE* out=out_path?std::fopen(out_path,"w"):stdout;
+    if (!out){
+        std::fprintf(stderr,"bench_sdf: impossible d'écrire %s\n",out_path);
+        return 1;
+    }
+    std::fprintf(out,"{\n  \"benchmark\": \"bench_sdf\",\n  \"real\": \"%s\",\n  \"cell_size\": %g,\n  \"cases\": [\n",real_float?"float":"double",cell);
+    std::fprintf(stderr,"%9s %9s %9s %8s %9s %10s %10s %9s %9s %10s %10s %7s %7s\n","colliders","particles","nodes","MB",
+                 "bake (ms)","exact (ms)","sdf (ms)","exact","sdf","max error","bound","missed","extra");
+    bool within_bound=true;
+    for (std::size_t k=0;k<counts.size();k++){
+        SDFResult r=real_float?runCase<float>(counts[k],n_particles,steps,cell):runCase<double>(counts[k],n_particles,steps,cell);
+        within_bound=within_bound && r.error.over_bound==0;
+        std::fprintf(stderr,"%9zu %9zu %9zu %8.1f %9.2f %10.3f %10.3f %9zu %9zu %10.4g %10.4g %7zu %7zu\n",r.colliders,r.particles,r.nodes,r.memory_mb,
+                     r.bake_ms,r.exact_ms,r.sdf_ms,r.exact_constraints,r.sdf_constraints,r.error.max_distance,r.error.bound,r.error.missed,r.error.extra);
+        std::fprintf(out,"    {\"colliders\": %zu, \"particles\": %zu, \"nodes\": %zu, \"memory_mb\": %.3f, \"bake_ms\": %.6f,\n"
+                         "     \"exact_ms\": %.6f, \"sdf_ms\": %.6f, \"exact_constraints\": %zu, \"sdf_constraints\": %zu,\n"
+                         "     \"error\": {\"samples\": %zu, \"bound\": %.6g, \"max_distance\": %.6g, \"mean_distance\": %.6g, \"over_bound\": %zu,\n"
+                         "               \"mean_angle\": %.6g, \"smooth_angle\": %.6g, \"contacts\": %zu, \"missed\": %zu, \"extra\": %zu, \"max_depth\": %.6g}}%s\n",
+                     r.colliders,r.particles,r.nodes,r.memory_mb,r.bake_ms,r.exact_ms,r.sdf_ms,r.exact_constraints,r.sdf_constraints,
+                     r.error.samples,r.error.bound,r.error.max_distance,r.error.mean_distance,r.error.over_bound,
+                     r.error.mean_angle,r.error.smooth_angle,r.error.contacts,r.error.missed,r.error.extra,r.error.max_depth,
+                     k+1<counts.size()?",":"");
+    }
+    std::fprintf(out,"  ]\n}\n");
+    if (out!=stdout){std::fclose(out);}
+    if (!within_bound){std::fprintf(stderr,"bench_sdf: écart de la grille de distances au-delà de la borne\n");}
+    return within_bound?0:1;
+}
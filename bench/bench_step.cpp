@@ -0,0 +1,240 @@
+/******************************************************************************
+ * @file bench_step.cpp
+ * @brief Mesure le temps de chaque étape de Context::updatePhysicalSystem et d'un pas complet.
+ *
+ * Chaque cas combine un nombre de particules, un nombre de colliders et une densité:
+ * - gas: particules espacées de 8 rayons, vitesses aléatoires, sans gravité (peu de contacts);
+ * - pile: particules espacées d'un peu plus d'un diamètre, posées au fond de la boîte sous gravité.
+ * Après quelques pas de mise en route, on exécute les étapes une à une en chronométrant chacune,
+ * puis on chronomètre autant de pas complets (le tas a continué à se tasser entre temps, les deux
+ * mesures ne portent donc pas exactement sur le même état). Les résultats sont écrits en JSON pour être comparés
+ * d'une version à l'autre (le texte lisible va sur la sortie d'erreur).
+ *
+ * Avec --xpbd, les pas utilisent le solveur XPBD: seuls les pas complets sont chronométrés (les
+ * étapes séparées sont celles de la méthode d'origine) et le nombre moyen d'itérations est ajouté.
+ * Avec --real float, les cas sont simulés en simple précision (ContextF), sur la même scène.
+ *
+ * Usage: bench_step [--quick] [--steps N] [--threads T] [--solver sequential|colored|jacobi]
+ *                   [--xpbd sous_pas,itérations] [--real float|double] [--out fichier.json]
+ ******************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Context.h"
+#include "../kernels.h"
+
+/**
+ * @struct BenchCase
+ * @brief Paramètres d'un cas mesuré.
+ */
+struct BenchCase {
+    std::size_t particles;
+    std::size_t colliders;
+    const char* density; /**< "gas" ou "pile" */
+};
+
+/**
+ * @struct BenchResult
+ * @brief Temps moyens par pas (en ms) de chaque étape et du pas complet.
+ */
+struct BenchResult {
+    double force_predict=0,static_contacts=0,dynamic_contacts=0,project=0,delete_contacts=0,friction_update=0;
+    double step_mean=0,step_min=0;
+    double static_per_step=0,dynamic_per_step=0; /**< Nombre moyen de contraintes par pas */
+    double iterations_per_step=0; /**< Nombre moyen d'itérations XPBD par pas */
+    bool finite=true; /**< Faux si une position n'est plus finie à la fin du cas */
+};
+
+static const double radius=10,mass=2;
+
+/**
+* @brief Construit la scène d'un cas: boîte, particules et colliders tirés au hasard (graine fixe)
+*/
+template <class Real>
+static void buildCase(BasicContext<Real>& context,const BenchCase& c){
+    std::mt19937 rng(1234);
+    bool pile=std::strcmp(c.density,"pile")==0;
+    double spacing=pile?2.1*radius:8*radius;
+    std::size_t cols=(std::size_t)std::ceil(std::sqrt((double)c.particles));
+    std::size_t rows=(c.particles+cols-1)/std::max<std::size_t>(cols,1);
+    // Le tas occupe le bas d'une boîte carrée, le gaz la remplit
+    context.width=(int)(cols*spacing+40);
+    context.height=pile?(int)(std::max(cols,rows)*spacing*2+40):(int)(rows*spacing+40);
+    context.champ_de_force={0,Real(pile?9.81/2:0)};
+
+    // Léger décalage pour que les colonnes du tas ne soient pas parfaitement alignées
+    std::uniform_real_distribution<double> velocity(-1,1),jitter(-0.05*radius,0.05*radius);
+    context.particles.reserve(c.particles);
+    for (std::size_t k=0;k<c.particles;k++){
+        basic_particle<Real> p;
+        double y=20+radius+(k/cols)*spacing;
+        p.pos={Real(20+radius+(k%cols)*spacing+jitter(rng)),Real(pile?context.height-y:y)};
+        if (!pile){p.velocity={Real(velocity(rng)),Real(velocity(rng))};}
+        p.radius=radius;
+        p.mass=mass;
+        context.particles.add(p);
+    }
+
+    std::uniform_real_distribution<double> x(0,context.width),y(0,context.height);
+    std::uniform_real_distribution<double> angle(-M_PI,M_PI),length(20,60),sphere(10,30);
+    for (std::size_t k=0;k<c.colliders;k++){
+        if (k%2==0){context.addCollider(basic_plancollider<Real>(std::make_pair(x(rng),y(rng)),length(rng),angle(rng)));}
+        else {context.addCollider(basic_spherecollider<Real>(std::make_pair(x(rng),y(rng)),sphere(rng)));}
+    }
+}
+
+/**
+* @brief Temps écoulé (en ms) depuis start, start étant remis à maintenant
+*/
+static double lap(std::chrono::steady_clock::time_point& start){
+    auto now=std::chrono::steady_clock::now();
+    double ms=std::chrono::duration<double,std::milli>(now-start).count();
+    start=now;
+    return ms;
+}
+
+template <class Real>
+static BenchResult runCase(const BenchCase& c,int steps,unsigned threads,SolverMode solver,const XPBDSettings& xpbd){
+    const float dt=0.2f;
+    BasicContext<Real> context;
+    context.setThreadCount(threads);
+    context.setSolverMode(solver);
+    context.setXPBD(xpbd);
+    buildCase(context,c);
+    BenchResult r;
+
+    for (int s=0;s<10;s++){context.updatePhysicalSystem(dt);}
+
+    // Étapes séparées, dans l'ordre de updatePhysicalSystem
+    for (int s=0;s<(xpbd.enabled?0:steps);s++){
+        auto t=std::chrono::steady_clock::now();
+        context.applyExternalForceAndPredict(dt);
+        r.force_predict+=lap(t);
+        context.addStaticContactConstraints();
+        r.static_contacts+=lap(t);
+        context.addDynamicContactConstraints();
+        r.dynamic_contacts+=lap(t);
+        r.static_per_step+=context.S_Constraints.size();
+        r.dynamic_per_step+=context.D_Constraints.size();
+        context.projectConstraints();
+        r.project+=lap(t);
+        context.deleteContactConstraints();
+        r.delete_contacts+=lap(t);
+        context.applyFrictionAndUpdate(dt);
+        r.friction_update+=lap(t);
+    }
+    for (double* v:{&r.force_predict,&r.static_contacts,&r.dynamic_contacts,&r.project,&r.delete_contacts,
+                    &r.friction_update,&r.static_per_step,&r.dynamic_per_step}){*v/=steps;}
+
+    // Pas complets
+    r.step_min=1e300;
+    double total=0;
+    for (int s=0;s<steps;s++){
+        auto t=std::chrono::steady_clock::now();
+        context.updatePhysicalSystem(dt);
+        double ms=lap(t);
+        r.iterations_per_step+=context.lastSolverIterations();
+        total+=ms;
+        r.step_min=std::min(r.step_min,ms);
+    }
+    r.step_mean=total/steps;
+    r.iterations_per_step/=steps;
+
+    for (std::size_t i=0;i<context.particles.size();i++){
+        if (!std::isfinite(context.particles.x[i]) || !std::isfinite(context.particles.y[i])){r.finite=false;}
+    }
+    return r;
+}
+
+static void usage(){
+    std::fprintf(stderr,"usage: bench_step [--quick] [--steps N] [--threads T] "
+                        "[--solver sequential|colored|jacobi] [--xpbd sous_pas,itérations] [--real float|double] [--out fichier.json]\n");
+}
+
+int main(int argc,char* argv[]){
+    bool quick=false;
+    int steps=0;
+    unsigned threads=1;
+    SolverMode solver=SolverMode::Sequential;
+    const char* solver_name="sequential";
+    const char* out_path=nullptr;
+    XPBDSettings xpbd;
+    bool real_float=false;
+
+    for (int a=1;a<argc;a++){
+        const char* option=argv[a];
+        if (std::strcmp(option,"--quick")==0){quick=true;continue;}
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){usage(); return 2;}
+        a++;
+        if (std::strcmp(option,"--steps")==0){steps=std::atoi(value);}
+        else if (std::strcmp(option,"--threads")==0){threads=(unsigned)std::atoi(value);}
+        else if (std::strcmp(option,"--out")==0){out_path=value;}
+        else if (std::strcmp(option,"--xpbd")==0){
+            if (std::sscanf(value,"%u,%u",&xpbd.substeps,&xpbd.iterations)!=2){usage(); return 2;}
+            xpbd.enabled=true;
+        }
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){real_float=true;}
+            else if (std::strcmp(value,"double")==0){real_float=false;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--solver")==0){
+            solver_name=value;
+            if (std::strcmp(value,"sequential")==0){solver=SolverMode::Sequential;}
+            else if (std::strcmp(value,"colored")==0){solver=SolverMode::Colored;}
+            else if (std::strcmp(value,"jacobi")==0){solver=SolverMode::Jacobi;}
+            else {usage(); return 2;}
+        }
+        else {usage(); return 2;}
+    }
+
+    std::vector<BenchCase> cases;
+    std::vector<std::size_t> counts=quick?std::vector<std::size_t>{1000,10000}:std::vector<std::size_t>{1000,10000,100000};
+    for (std::size_t n:counts){
+        for (std::size_t m:{0,16,256}){
+            for (const char* density:{"gas","pile"}){cases.push_back({n,m,density});}
+        }
+    }
+
+    FILE* out=out_path?std::fopen(out_path,"w"):stdout;
+    if (!out){
+        std::fprintf(stderr,"bench_step: impossible d'écrire %s\n",out_path);
+        return 1;
+    }
+    std::fprintf(out,"{\n  \"benchmark\": \"bench_step\",\n  \"simd\": \"%s\",\n  \"real\": \"%s\",\n  \"threads\": %u,\n  \"solver\": \"%s\",\n"
+                     "  \"xpbd\": {\"enabled\": %s, \"substeps\": %u, \"iterations\": %u},\n  \"cases\": [\n",
+                 stageKernels().name,real_float?"float":"double",threads,solver_name,xpbd.enabled?"true":"false",xpbd.substeps,xpbd.iterations);
+    std::fprintf(stderr,"%9s %9s %6s %9s %9s %9s %9s %9s %9s %10s %10s %6s\n","particles","colliders","dens",
+                 "force+prd","static","dynamic","project","delete","frict+upd","step (ms)","steps/s","iters");
+    bool all_finite=true;
+    for (std::size_t k=0;k<cases.size();k++){
+        const BenchCase& c=cases[k];
+        int n_steps=steps>0?steps:(int)std::max<std::size_t>(5,2000000/std::max<std::size_t>(c.particles,1)/10);
+        BenchResult r=real_float?runCase<float>(c,n_steps,threads,solver,xpbd):runCase<double>(c,n_steps,threads,solver,xpbd);
+        all_finite=all_finite && r.finite;
+        std::fprintf(stderr,"%9zu %9zu %6s %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %10.3f %10.1f %6.1f%s\n",c.particles,c.colliders,c.density,
+                     r.force_predict,r.static_contacts,r.dynamic_contacts,r.project,r.delete_contacts,r.friction_update,
+                     r.step_mean,1000/r.step_mean,r.iterations_per_step,r.finite?"":" (non fini)");
+        std::fprintf(out,"    {\"particles\": %zu, \"colliders\": %zu, \"density\": \"%s\", \"steps\": %d,\n"
+                         "     \"stages_ms\": {\"force_predict\": %.6f, \"static_contacts\": %.6f, \"dynamic_contacts\": %.6f, "
+                         "\"project\": %.6f, \"delete_contacts\": %.6f, \"friction_update\": %.6f},\n"
+                         "     \"step_ms\": {\"mean\": %.6f, \"min\": %.6f}, \"steps_per_second\": %.3f,\n"
+                         "     \"static_constraints\": %.1f, \"dynamic_constraints\": %.1f, \"iterations\": %.2f, \"finite\": %s}%s\n",
+                     c.particles,c.colliders,c.density,n_steps,
+                     r.force_predict,r.static_contacts,r.dynamic_contacts,r.project,r.delete_contacts,r.friction_update,
+                     r.step_mean,r.step_min,1000/r.step_mean,r.static_per_step,r.dynamic_per_step,r.iterations_per_step,
+                     r.finite?"true":"false",k+1<cases.size()?",":"");
+    }
+    std::fprintf(out,"  ]\n}\n");
+    if (out!=stdout){std::fclose(out);}
+    return all_finite?0:1;
+}
@@ -0,0 +1,227 @@
+/******************************************************************************
+ * @file broadphase.cpp
+ * @brief Implémentation des méthodes de la classe Broadphase définies dans broadphase.h
+ ******************************************************************************/
+
+#include "broadphase.h"
+#include "stepbuffers.h"
+#include <algorithm>
+#include <cmath>
+
+/**
+* @brief Nombre maximal de cellules de la grille construite sur n particules
+*/
+static double maxCells(std::size_t n){return 4.0*n+64;}
+
+/**
+* @brief Test de chevauchement de deux particules, identique pour les deux méthodes
+*/
+template <class Real>
+static inline bool overlap(const Real* px,const Real* py,const Real* radius,std::size_t i,std::size_t j,Real margin){
+    Real deltaX=px[j]-px[i];
+    Real deltaY=py[j]-py[i];
+    Real distance=std::sqrt(deltaX*deltaX+deltaY*deltaY);
+    return distance<radius[i]+radius[j]+margin;
+}
+
+template <class Real>
+void Broadphase::findContacts(const BasicParticleStore<Real>& particles,std::vector<ContactPair>& pairs,std::size_t active){
+    pairs.clear();
+    active=std::min(active,particles.size());
+    if (particles.size()<2 || active==0){return;}
+    if (mode==BroadphaseMode::BruteForce){bruteForce(particles,pairs,active);}
+    else{uniformGrid(particles,pairs,active);}
+}
+
+template <class Real>
+void Broadphase::bruteForce(const BasicParticleStore<Real>& particles,std::vector<ContactPair>& pairs,std::size_t active){
+    const Real* px=particles.px.data();
+    const Real* py=particles.py.data();
+    const Real* radius=particles.radius.data();
+    const Real m=(Real)margin;
+    const std::size_t n=particles.size();
+    for (std::size_t i=0;i<active;++i) {
+        for (std::size_t j=i+1;j<n;++j) {
+            if (overlap(px,py,radius,i,j,m)){pairs.push_back({(std::uint32_t)i,(std::uint32_t)j});}
+        }
+    }
+}
+
+/**
+* @brief Construit la grille des particules [first,last) par tri par comptage selon leur cellule.
+* Les cellules ont pour côté le plus grand diamètre: deux particules en contact sont
+* donc toujours dans des cellules voisines. Si la zone occupée est très étendue par rapport
+* au nombre de particules, on agrandit les cellules pour borner la mémoire de la grille (au plus max_cells cellules,
+* borne sur laquelle reserve s'appuie).
+*/
+template <class Real>
+void Broadphase::buildGrid(Grid& grid,const BasicParticleStore<Real>& particles,std::size_t first,std::size_t last){
+    const Real* px=particles.px.data();
+    const Real* py=particles.py.data();
+    const std::size_t n=last-first;
+    grid.first=first;
+    grid.last=last;
+    if (n==0){
+        grid.nx=grid.ny=0;
+        grid.max_radius=0;
+        assignStepBuffer(grid.cell_start,1,0);
+        grid.sorted.clear();
+        return;
+    }
+
+    double max_radius=0;
+    double min_x=px[first];
+    double min_y=py[first];
+    double max_x=px[first];
+    double max_y=py[first];
+    for (std::size_t i=first;i<last;i++){
+        max_radius=std::max<double>(max_radius,particles.radius[i]);
+        min_x=std::min<double>(min_x,px[i]);
+        max_x=std::max<double>(max_x,px[i]);
+        min_y=std::min<double>(min_y,py[i]);
+        max_y=std::max<double>(max_y,py[i]);
+    }
+    double cell_size=std::max(2*max_radius+margin,1e-9);
+    const double max_cells=maxCells(n);
+    auto cellCount=[&](){return (std::floor((max_x-min_x)/cell_size)+1)*(std::floor((max_y-min_y)/cell_size)+1);};
+    double cells=cellCount();
+    if (cells>max_cells){cell_size*=std::sqrt(cells/max_cells)*1.01;}
+    // Une zone très allongée (une seule ligne de cellules) dépasse encore la borne après la première correction
+    while (cellCount()>max_cells){cell_size*=1.1;}
+    const std::int64_t nx=(std::int64_t)std::floor((max_x-min_x)/cell_size)+1;
+    const std::int64_t ny=(std::int64_t)std::floor((max_y-min_y)/cell_size)+1;
+    grid.cell_size=cell_size;
+    grid.min_x=min_x;
+    grid.min_y=min_y;
+    grid.max_radius=max_radius;
+    grid.nx=nx;
+    grid.ny=ny;
+
+    // Comptage du nombre de particules par cellule
+    std::vector<std::uint32_t>& cell_start=grid.cell_start;
+    std::vector<std::uint32_t>& particle_cell=grid.particle_cell;
+    assignStepBuffer(cell_start,nx*ny+1,0);
+    resizeStepBuffer(particle_cell,n);
+    for (std::size_t i=first;i<last;i++){
+        std::int64_t cx=std::min((std::int64_t)((px[i]-min_x)/cell_size),nx-1);
+        std::int64_t cy=std::min((std::int64_t)((py[i]-min_y)/cell_size),ny-1);
+        particle_cell[i-first]=(std::uint32_t)(cy*nx+cx);
+        cell_start[particle_cell[i-first]+1]++;
+    }
+    // Somme préfixe puis placement de chaque particule dans sa cellule
+    for (std::size_t c=1;c<cell_start.size();c++){cell_start[c]+=cell_start[c-1];}
+    resizeStepBuffer(grid.sorted,n);
+    // Le tampon candidates sert ici de curseur d'écriture pour chaque cellule
+    std::vector<std::uint32_t>& fill=candidates;
+    copyStepBuffer(fill,cell_start.begin(),cell_start.end()-1);
+    for (std::size_t i=first;i<last;i++){grid.sorted[fill[particle_cell[i-first]]++]=(std::uint32_t)i;}
+}
+
+/**
+* @brief Reconstruit la grille des particules éveillées [0,active), et celle des particules endormies [active,n)
+* seulement si elles ont changé depuis sa construction
+*/
+template <class Real>
+void Broadphase::buildGrids(const BasicParticleStore<Real>& particles,std::size_t active){
+    const std::size_t n=particles.size();
+    active=std::min(active,n);
+    buildGrid(awake,particles,0,active);
+    if (!sleepers_valid || asleep.first!=active || asleep.last!=n){
+        buildGrid(asleep,particles,active,n);
+        sleepers_valid=true;
+    }
+}
+
+/**
+* @brief Appelle visit(c) pour chaque cellule de la grille qui recouvre box
+*/
+template <class Visit>
+void Broadphase::Grid::visitCells(const AABB& box,Visit visit) const {
+    if (nx==0 || ny==0){return;}
+    // Cellules limitées à la grille: les particules sont toutes dedans
+    std::int64_t x0=(std::int64_t)std::max(0.0,std::floor((box.min_x-min_x)/cell_size));
+    std::int64_t y0=(std::int64_t)std::max(0.0,std::floor((box.min_y-min_y)/cell_size));
+    std::int64_t x1=(std::int64_t)std::min((double)(nx-1),std::floor((box.max_x-min_x)/cell_size));
+    std::int64_t y1=(std::int64_t)std::min((double)(ny-1),std::floor((box.max_y-min_y)/cell_size));
+    for (std::int64_t y=y0;y<=y1;y++){
+        for (std::int64_t x=x0;x<=x1;x++){visit(y*nx+x);}
+    }
+}
+
+template <class Real>
+void Broadphase::uniformGrid(const BasicParticleStore<Real>& particles,std::vector<ContactPair>& pairs,std::size_t active){
+    buildGrids(particles,active);
+    const Real* px=particles.px.data();
+    const Real* py=particles.py.data();
+    const Real* radius=particles.radius.data();
+    const Real m=(Real)margin;
+    const std::int64_t nx=awake.nx;
+    const std::int64_t ny=awake.ny;
+
+    // Les particules d'indice supérieur ou égal à active ne cherchent pas leurs voisins:
+    // une paire dont l'une est active est trouvée depuis celle-ci, qui a le plus petit indice
+    for (std::size_t i=0;i<active;i++){
+        std::int64_t cx=awake.particle_cell[i]%nx;
+        std::int64_t cy=awake.particle_cell[i]/nx;
+        candidates.clear();
+        // On parcourt les 9 cellules voisines et on ne garde que les voisins d'indice plus grand
+        for (std::int64_t y=std::max<std::int64_t>(cy-1,0);y<=std::min(cy+1,ny-1);y++){
+            for (std::int64_t x=std::max<std::int64_t>(cx-1,0);x<=std::min(cx+1,nx-1);x++){
+                std::int64_t c=y*nx+x;
+                for (std::uint32_t k=awake.cell_start[c];k<awake.cell_start[c+1];k++){
+                    std::uint32_t j=awake.sorted[k];
+                    if (j>i && overlap(px,py,radius,i,j,m)){candidates.push_back(j);}
+                }
+            }
+        }
+        // Les particules endormies, d'indices tous plus grands, sont cherchées dans leur grille autour de la particule:
+        // ses cellules peuvent être plus petites que le diamètre de la particule éveillée
+        const double reach=radius[i]+asleep.max_radius+margin;
+        asleep.visitCells(AABB{px[i]-reach,py[i]-reach,px[i]+reach,py[i]+reach},[&](std::int64_t c){
+            for (std::uint32_t k=asleep.cell_start[c];k<asleep.cell_start[c+1];k++){
+                std::uint32_t j=asleep.sorted[k];
+                if (overlap(px,py,radius,i,j,m)){candidates.push_back(j);}
+            }
+        });
+        // Même ordre que la méthode exhaustive
+        std::sort(candidates.begin(),candidates.end());
+        for (std::uint32_t j:candidates){pairs.push_back({(std::uint32_t)i,j});}
+    }
+}
+
+template <class Real>
+void Broadphase::build(const BasicParticleStore<Real>& particles,std::size_t active){
+    buildGrids(particles,active);
+}
+
+void Broadphase::query(const AABB& box,std::vector<std::uint32_t>& out) const {
+    out.clear();
+    for (const Grid* grid:{&awake,&asleep}){
+        grid->visitCells(box,[&](std::int64_t c){
+            out.insert(out.end(),grid->sorted.begin()+grid->cell_start[c],grid->sorted.begin()+grid->cell_start[c+1]);
+        });
+    }
+}
+
+std::size_t Broadphase::Grid::reservedBytes() const {
+    return stepBufferBytes(cell_start)+stepBufferBytes(sorted)+stepBufferBytes(particle_cell);
+}
+
+void Broadphase::reserve(std::size_t n){
+    const std::size_t cells=(std::size_t)maxCells(n);
+    for (Grid* grid:{&awake,&asleep}){
+        reserveStepBuffer(grid->cell_start,cells+1);
+        reserveStepBuffer(grid->sorted,n);
+        reserveStepBuffer(grid->particle_cell,n);
+    }
+    reserveStepBuffer(candidates,cells);
+}
+
+std::size_t Broadphase::reservedBytes() const {
+    return awake.reservedBytes()+asleep.reservedBytes()+stepBufferBytes(candidates);
+}
+
+template void Broadphase::findContacts<float>(const BasicParticleStore<float>&,std::vector<ContactPair>&,std::size_t);
+template void Broadphase::findContacts<double>(const BasicParticleStore<double>&,std::vector<ContactPair>&,std::size_t);
+template void Broadphase::build<float>(const BasicParticleStore<float>&,std::size_t);
+template void Broadphase::build<double>(const BasicParticleStore<double>&,std::size_t);
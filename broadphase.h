@@ -0,0 +1,136 @@
+/******************************************************************************
+ * @file broadphase.h
+ * @brief Définition de la classe Broadphase qui recherche les paires de particules en contact.
+ *
+ * Deux méthodes sont disponibles: le test de toutes les paires (O(n²), conservé pour
+ * la validation) et une grille uniforme reconstruite à chaque pas par tri par comptage,
+ * dont la taille des cellules dépend du plus grand rayon des particules. Les particules endormies
+ * ont leur propre grille, reconstruite seulement quand l'ensemble des particules endormies change.
+ * Les deux méthodes renvoient exactement les mêmes paires, dans le même ordre.
+ ******************************************************************************/
+
+#ifndef BROADPHASE_H
+#define BROADPHASE_H
+
+#include <cstdint>
+#include <vector>
+#include "collider.h"
+#include "particlestore.h"
+
+/**
+ * @enum BroadphaseMode
+ * @brief Méthode de recherche des paires de particules en contact.
+ */
+enum class BroadphaseMode {
+    BruteForce, /**< Test de toutes les paires de particules. */
+    UniformGrid /**< Grille uniforme: seules les particules des cellules voisines sont testées. */
+};
+
+/**
+ * @struct ContactPair
+ * @brief Paire d'indices de particules qui se chevauchent, avec i<j.
+ */
+struct ContactPair {
+    std::uint32_t i; /**< Indice de la première particule. */
+    std::uint32_t j; /**< Indice de la seconde particule. */
+
+    bool operator==(const ContactPair& other) const {return i==other.i && j==other.j;}
+};
+
+/**
+ * @class Broadphase
+ * @brief Recherche des paires de particules dont les positions futures se chevauchent.
+ *
+ * Les paires sont renvoyées triées par i puis par j, quelle que soit la méthode:
+ * c'est l'ordre de l'ancienne double boucle de Context::addDynamicContactConstraints.
+ */
+class Broadphase {
+public:
+    BroadphaseMode mode=BroadphaseMode::UniformGrid; /**< Méthode utilisée par findContacts. */
+    double margin=0; /**< Les paires dont la distance est inférieure à la somme des rayons plus margin sont renvoyées. */
+
+    /**
+     * @brief Remplit pairs avec toutes les paires de particules qui se chevauchent.
+     * @param particles Les particules (on utilise les positions futures px, py).
+     * @param pairs Vecteur de sortie, vidé avant d'être rempli.
+     * @param active Seules les paires dont la première particule a un indice inférieur à active sont
+     * renvoyées: avec les particules endormies rangées après les autres (voir Context::setSleep),
+     * les paires entre deux particules endormies sont ignorées. La grille uniforme n'est reconstruite que sur
+     * les active premières particules; les suivantes, supposées immobiles, gardent leur grille tant que
+     * invalidateSleepers n'est pas appelée et que active et le nombre de particules ne changent pas.
+     * Instanciée en float et en double: la grille est en double, les tests de recouvrement dans la précision des particules.
+     */
+    template <class Real>
+    void findContacts(const BasicParticleStore<Real>& particles,std::vector<ContactPair>& pairs,std::size_t active=SIZE_MAX);
+
+    /**
+     * @brief Construit la grille uniforme sur les positions futures, sans chercher les paires, pour des requêtes par query.
+     * findContacts la reconstruit à chaque appel (grille uniforme).
+     * @param active Comme pour findContacts: les particules suivantes gardent la grille des particules endormies.
+     */
+    template <class Real>
+    void build(const BasicParticleStore<Real>& particles,std::size_t active=SIZE_MAX);
+
+    /**
+     * @brief Ajoute à out les particules des cellules qui recouvrent box dans la dernière grille construite, cellule par cellule
+     * (particules éveillées puis endormies): toute particule dont la position future est dans box en fait partie.
+     * @param out Vecteur de sortie, vidé avant d'être rempli.
+     */
+    void query(const AABB& box,std::vector<std::uint32_t>& out) const;
+
+    /**
+     * @brief Signale que l'ensemble des particules endormies (indices et positions) a changé:
+     * leur grille sera reconstruite au prochain appel.
+     */
+    void invalidateSleepers(){sleepers_valid=false;}
+
+    /**
+     * @brief Réserve les deux grilles et leurs tampons pour n particules: une grille n'a jamais plus de 4n+64 cellules,
+     * si bien qu'aucune construction sur au plus n particules n'alloue ensuite.
+     */
+    void reserve(std::size_t n);
+
+    /**
+     * @brief Mémoire réservée par la grille et ses tampons, en octets: le maximum atteint depuis la création.
+     */
+    std::size_t reservedBytes() const;
+
+private:
+    /**
+     * @struct Grid
+     * @brief Grille uniforme sur les particules d'indices [first,last).
+     */
+    struct Grid {
+        double cell_size=1;  /**< Côté d'une cellule de la grille. */
+        double min_x=0;      /**< Abscisse du coin de la grille. */
+        double min_y=0;      /**< Ordonnée du coin de la grille. */
+        double max_radius=0; /**< Plus grand rayon des particules de la grille. */
+        std::int64_t nx=0;   /**< Nombre de cellules selon x (0 si la grille est vide). */
+        std::int64_t ny=0;   /**< Nombre de cellules selon y. */
+        std::size_t first=0; /**< Indice de la première particule. */
+        std::size_t last=0;  /**< Indice suivant la dernière particule. */
+        std::vector<std::uint32_t> cell_start;    /**< Début de chaque cellule dans sorted (taille nx*ny+1). */
+        std::vector<std::uint32_t> sorted;        /**< Indices des particules triés par cellule. */
+        std::vector<std::uint32_t> particle_cell; /**< Cellule de chaque particule, à l'indice i-first. */
+
+        template <class Visit>
+        void visitCells(const AABB& box,Visit visit) const;
+        std::size_t reservedBytes() const;
+    };
+
+    Grid awake;                 /**< Grille des particules éveillées, reconstruite à chaque appel. */
+    Grid asleep;                /**< Grille des particules endormies, reconstruite quand elles changent. */
+    bool sleepers_valid=false;  /**< Faux si asleep doit être reconstruite (voir invalidateSleepers). */
+    std::vector<std::uint32_t> candidates;    /**< Voisins d'une particule, triés avant l'ajout des paires. */
+
+    template <class Real>
+    void bruteForce(const BasicParticleStore<Real>& particles,std::vector<ContactPair>& pairs,std::size_t active);
+    template <class Real>
+    void buildGrid(Grid& grid,const BasicParticleStore<Real>& particles,std::size_t first,std::size_t last);
+    template <class Real>
+    void buildGrids(const BasicParticleStore<Real>& particles,std::size_t active);
+    template <class Real>
+    void uniformGrid(const BasicParticleStore<Real>& particles,std::vector<ContactPair>& pairs,std::size_t active);
+};
+
+#endif // BROADPHASE_H
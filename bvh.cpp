@@ -0,0 +1,88 @@
+/******************************************************************************
+ * @file bvh.cpp
+ * @brief Implémentation des méthodes de la classe ColliderBVH définies dans bvh.h
+ ******************************************************************************/
+
+#include "bvh.h"
+#include <algorithm>
+
+/**
+* @brief Nombre maximal de colliders dans une feuille
+*/
+static const std::uint32_t max_leaf_size=4;
+
+template <class Real>
+void ColliderBVH::build(const BasicColliderSet<Real>& colliders){
+    nodes.clear();
+    boxes.resize(colliders.size());
+    leaf_colliders.resize(colliders.size());
+    for (std::uint32_t c=0;c<colliders.size();c++){
+        boxes[c]=colliders.boundingBox(c);
+        leaf_colliders[c]=c;
+    }
+    if (colliders.empty()){return;}
+    nodes.reserve(2*colliders.size());
+    nodes.push_back(Node{AABB{},0,(std::uint32_t)colliders.size()});
+    subdivide(0);
+}
+
+void ColliderBVH::subdivide(std::uint32_t node){
+    // Boîte englobante des colliders du noeud
+    std::uint32_t first=nodes[node].first;
+    std::uint32_t count=nodes[node].count;
+    AABB box=boxes[leaf_colliders[first]];
+    for (std::uint32_t k=first+1;k<first+count;k++){
+        const AABB& b=boxes[leaf_colliders[k]];
+        box.min_x=std::min(box.min_x,b.min_x);
+        box.min_y=std::min(box.min_y,b.min_y);
+        box.max_x=std::max(box.max_x,b.max_x);
+        box.max_y=std::max(box.max_y,b.max_y);
+    }
+    nodes[node].box=box;
+    if (count<=max_leaf_size){return;}
+
+    // On coupe à la médiane des centres selon le plus grand axe
+    bool split_x=(box.max_x-box.min_x)>=(box.max_y-box.min_y);
+    auto center=[&](std::uint32_t c){
+        const AABB& b=boxes[c];
+        return split_x?b.min_x+b.max_x:b.min_y+b.max_y;
+    };
+    std::uint32_t half=count/2;
+    std::nth_element(leaf_colliders.begin()+first,leaf_colliders.begin()+first+half,leaf_colliders.begin()+first+count,
+                     [&](std::uint32_t a,std::uint32_t b){return center(a)<center(b);});
+
+    std::uint32_t left=(std::uint32_t)nodes.size();
+    nodes.push_back(Node{AABB{},first,half});
+    nodes.push_back(Node{AABB{},first+half,count-half});
+    nodes[node].first=left;
+    nodes[node].count=0;
+    subdivide(left);
+    subdivide(left+1);
+}
+
+void ColliderBVH::query(const AABB& box,std::vector<std::uint32_t>& out) const{
+    out.clear();
+    if (nodes.empty()){return;}
+
+    // Parcours en profondeur avec une pile de taille fixe (la hiérarchie est équilibrée)
+    std::uint32_t stack[64];
+    int top=0;
+    stack[top++]=0;
+    while (top>0){
+        const Node& node=nodes[stack[--top]];
+        if (!node.box.overlaps(box)){continue;}
+        if (node.count>0){
+            for (std::uint32_t k=node.first;k<node.first+node.count;k++){
+                if (boxes[leaf_colliders[k]].overlaps(box)){out.push_back(leaf_colliders[k]);}
+            }
+        }else{
+            stack[top++]=node.first;
+            stack[top++]=node.first+1;
+        }
+    }
+    // Même ordre que le parcours de tous les colliders
+    std::sort(out.begin(),out.end());
+}
+
+template void ColliderBVH::build<float>(const BasicColliderSet<float>&);
+template void ColliderBVH::build<double>(const BasicColliderSet<double>&);
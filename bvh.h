@@ -0,0 +1,65 @@
+/******************************************************************************
+ * @file bvh.h
+ * @brief Définition de la classe ColliderBVH, une hiérarchie de boîtes englobantes
+ * construite sur les colliders statiques.
+ *
+ * Une particule n'a ainsi à tester que les colliders dont la boîte englobante
+ * recouvre la sienne, au lieu de tous les colliders de la scène.
+ ******************************************************************************/
+
+#ifndef BVH_H
+#define BVH_H
+
+#include <cstdint>
+#include <vector>
+#include "collider.h"
+
+/**
+ * @class ColliderBVH
+ * @brief Hiérarchie de boîtes englobantes (AABB) sur un ensemble de colliders.
+ *
+ * Les noeuds sont rangés dans un tableau: les deux enfants d'un noeud interne sont
+ * contigus, et une feuille désigne une plage de leaf_colliders.
+ * La hiérarchie est construite en coupant à la médiane selon le plus grand axe.
+ */
+class ColliderBVH {
+public:
+    /**
+     * @brief Construit la hiérarchie sur les colliders donnés.
+     * @param colliders Les colliders du contexte (la hiérarchie en garde les identifiants, voir ColliderSet).
+     * Instanciée en float et en double; les boîtes sont toujours en double.
+     */
+    template <class Real>
+    void build(const BasicColliderSet<Real>& colliders);
+
+    /**
+     * @brief Nombre de colliders sur lesquels la hiérarchie a été construite.
+     */
+    std::size_t colliderCount() const {return leaf_colliders.size();}
+
+    /**
+     * @brief Ajoute à out les identifiants des colliders dont la boîte recouvre box, par ordre croissant.
+     * @param box Boîte à tester (typiquement la boîte d'une particule).
+     * @param out Vecteur de sortie, vidé avant d'être rempli.
+     */
+    void query(const AABB& box,std::vector<std::uint32_t>& out) const;
+
+private:
+    /**
+     * @struct Node
+     * @brief Noeud de la hiérarchie: feuille si count>0, sinon first est l'indice du premier enfant.
+     */
+    struct Node {
+        AABB box;            /**< Boîte englobant tous les colliders du noeud. */
+        std::uint32_t first; /**< Premier collider (feuille) ou premier enfant (noeud interne). */
+        std::uint32_t count; /**< Nombre de colliders de la feuille, 0 pour un noeud interne. */
+    };
+
+    std::vector<Node> nodes;                  /**< Noeuds, la racine en premier. */
+    std::vector<std::uint32_t> leaf_colliders; /**< Identifiants des colliders, regroupés par feuille. */
+    std::vector<AABB> boxes;                  /**< Boîte de chaque collider, par identifiant de collider. */
+
+    void subdivide(std::uint32_t node);
+};
+
+#endif // BVH_H
@@ -0,0 +1,518 @@
+/******************************************************************************
+ * @file checkpoint.cpp
+ * @brief Implémentation des fonctions de point de reprise définies dans checkpoint.h,
+ * instanciées pour Context et ContextF
+ ******************************************************************************/
+
+#include "checkpoint.h"
+#include "hash64.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char checkpoint_magic[8]={'P','B','D','C','K','P','T','\0'};
+const std::uint32_t byte_order_mark=0x01020304;
+const std::size_t block_alignment=64;
+const std::size_t checksum_start=24; /**< Les octets qui précèdent (magie, version, ordre, somme) ne sont pas couverts */
+
+/**
+ * @struct CheckpointHeader
+ * @brief En-tête du fichier, suivi de block_count entrées BlockEntry.
+ */
+struct CheckpointHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t checksum; /**< Somme de contrôle des octets [checksum_start, file_size) */
+    std::uint64_t file_size;
+    std::uint64_t particle_count;
+    std::uint64_t handle_slot_count;
+    std::uint64_t free_slot_count;
+    std::uint64_t plane_count;
+    std::uint64_t sphere_count;
+    double force_x;
+    double force_y;
+    double alpha;
+    std::int32_t width;
+    std::int32_t height;
+    std::uint32_t block_count;
+    std::uint32_t link_count; /**< Nombre de liens de distance (version 3, champ réservé nul avant) */
+};
+static_assert(sizeof(CheckpointHeader)==112,"l'en-tête fait partie du format");
+
+/**
+ * @enum BlockId
+ * @brief Contenu d'un bloc. Un lecteur ignore les blocs qu'il ne connaît pas.
+ */
+enum BlockId : std::uint32_t {
+    BlockX=1, /**< Blocs BlockX à BlockInvMass, BlockRestX et BlockRestY: un réel par particule, de 4 (float) ou 8 (double) octets */
+    BlockY, BlockPX, BlockPY, BlockVX, BlockVY, BlockRadius, BlockInvMass,
+    BlockSlotIndex, BlockSlotGeneration, BlockIndexSlot, BlockFreeSlots,
+    BlockPlanes,  /**< 5 doubles par plan: origine x, origine y, demi-longueur, normale x, normale y */
+    BlockSpheres, /**< 3 doubles par sphère: centre x, centre y, rayon */
+    BlockRestFrames, BlockRestX, BlockRestY, /**< État de sommeil, facultatif: absent, toutes les particules sont éveillées */
+    BlockLinkFirst, BlockLinkSecond, /**< Extrémités des liens de distance (poignées: emplacement, génération), facultatifs sans lien */
+    BlockLinkRest, BlockLinkCompliance, /**< Longueur au repos et souplesse des liens, un réel par lien */
+    BlockStreams, /**< Sources continues (version 4), un StreamRecord par source: le nombre d'éléments est celui du bloc */
+    BlockLast=BlockStreams
+};
+static_assert(sizeof(ParticleHandle)==8,"les poignées font partie du format");
+
+/**
+ * @struct StreamRecord
+ * @brief Une source continue telle qu'elle est écrite: tous les champs de ParticleStream, les compteurs sur 64 bits.
+ */
+struct StreamRecord {
+    double x,y,vx,vy,rate,width,radius,mass;
+    std::uint64_t max_particles;
+    std::uint64_t emitted;
+    double pending;
+};
+static_assert(sizeof(StreamRecord)==88,"les sources font partie du format");
+
+struct BlockEntry {
+    std::uint32_t id;
+    std::uint32_t element_size; /**< Taille d'un élément en octets */
+    std::uint64_t offset; /**< Position du bloc dans le fichier, multiple de block_alignment */
+    std::uint64_t count; /**< Nombre d'éléments */
+};
+static_assert(sizeof(BlockEntry)==24,"les entrées de bloc font partie du format");
+
+std::size_t alignUp(std::size_t n){return (n+block_alignment-1)/block_alignment*block_alignment;}
+
+/**
+ * @brief Indique si le bloc contient un réel par particule, dans la précision du contexte sauvegardé.
+ */
+bool isRealBlock(std::uint32_t id){return (id>=BlockX && id<=BlockInvMass) || id==BlockRestX || id==BlockRestY || id==BlockLinkRest || id==BlockLinkCompliance;}
+
+/**
+ * @class MappedFile
+ * @brief Fichier projeté en mémoire en lecture seule.
+ */
+class MappedFile {
+private:
+#ifdef _WIN32
+    HANDLE file=INVALID_HANDLE_VALUE;
+    HANDLE mapping=nullptr;
+#else
+    int fd=-1;
+#endif
+    void* view=nullptr;
+    std::size_t length=0;
+
+public:
+    MappedFile()=default;
+    MappedFile(const MappedFile&)=delete;
+    MappedFile& operator=(const MappedFile&)=delete;
+
+    bool open(const std::string& path){
+#ifdef _WIN32
+        file=CreateFileA(path.c_str(),GENERIC_READ,FILE_SHARE_READ,nullptr,OPEN_EXISTING,FILE_ATTRIBUTE_NORMAL,nullptr);
+        if (file==INVALID_HANDLE_VALUE){return false;}
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file,&size) || size.QuadPart==0){return false;}
+        length=(std::size_t)size.QuadPart;
+        mapping=CreateFileMappingA(file,nullptr,PAGE_READONLY,0,0,nullptr);
+        if (!mapping){return false;}
+        view=MapViewOfFile(mapping,FILE_MAP_READ,0,0,0);
+        return view!=nullptr;
+#else
+        fd=::open(path.c_str(),O_RDONLY);
+        if (fd<0){return false;}
+        struct stat st;
+        if (fstat(fd,&st)!=0 || st.st_size==0){return false;}
+        length=(std::size_t)st.st_size;
+        int flags=MAP_PRIVATE;
+#ifdef MAP_POPULATE
+        // Le fichier est lu en entier: on charge toutes les pages d'un coup plutôt qu'une faute de page par page
+        flags|=MAP_POPULATE;
+#endif
+        void* p=mmap(nullptr,length,PROT_READ,flags,fd,0);
+        if (p==MAP_FAILED){return false;}
+        view=p;
+        madvise(view,length,MADV_SEQUENTIAL);
+        return true;
+#endif
+    }
+
+    ~MappedFile(){
+#ifdef _WIN32
+        if (view){UnmapViewOfFile(view);}
+        if (mapping){CloseHandle(mapping);}
+        if (file!=INVALID_HANDLE_VALUE){CloseHandle(file);}
+#else
+        if (view){munmap(view,length);}
+        if (fd>=0){::close(fd);}
+#endif
+    }
+
+    const unsigned char* data() const {return static_cast<const unsigned char*>(view);}
+    std::size_t size() const {return length;}
+};
+
+void setError(std::string* error,const std::string& message){if (error){*error=message;}}
+
+/**
+ * @brief Vérifie que les tables de poignées lues dans le fichier sont cohérentes, pour que indexOf et remove
+ * n'indexent jamais hors des tableaux: chaque particule a un emplacement vivant qui la désigne, chaque emplacement
+ * vivant désigne une particule qui le désigne, et les emplacements libres sont exactement les autres, une fois chacun.
+ */
+bool validHandleTables(const std::uint32_t* slot_index,std::size_t slot_count,const std::uint32_t* index_slot,std::size_t n,
+                       const std::uint32_t* free_slots,std::size_t free_count){
+    if (free_count+n!=slot_count){return false;}
+    for (std::size_t i=0;i<n;i++){
+        if (index_slot[i]>=slot_count || slot_index[index_slot[i]]!=i){return false;}
+    }
+    std::size_t live=0;
+    for (std::size_t slot=0;slot<slot_count;slot++){
+        if (slot_index[slot]==UINT32_MAX){continue;}
+        if (slot_index[slot]>=n || index_slot[slot_index[slot]]!=slot){return false;}
+        live++;
+    }
+    if (live!=n){return false;}
+    std::vector<bool> seen(slot_count,false);
+    for (std::size_t k=0;k<free_count;k++){
+        const std::uint32_t slot=free_slots[k];
+        if (slot>=slot_count || slot_index[slot]!=UINT32_MAX || seen[slot]){return false;}
+        seen[slot]=true;
+    }
+    return true;
+}
+
+} // namespace
+
+/**
+ * @struct CheckpointAccess
+ * @brief Accès aux tables de poignées privées du ParticleStore.
+ */
+struct CheckpointAccess {
+    template <class Real> static const std::vector<std::uint32_t>& slotIndex(const BasicParticleStore<Real>& s){return s.slot_index;}
+    template <class Real> static const std::vector<std::uint32_t>& slotGeneration(const BasicParticleStore<Real>& s){return s.slot_generation;}
+    template <class Real> static const std::vector<std::uint32_t>& indexSlot(const BasicParticleStore<Real>& s){return s.index_slot;}
+    template <class Real> static const std::vector<std::uint32_t>& freeSlots(const BasicParticleStore<Real>& s){return s.free_slots;}
+    template <class Real> static std::vector<std::uint32_t>& slotIndex(BasicParticleStore<Real>& s){return s.slot_index;}
+    template <class Real> static std::vector<std::uint32_t>& slotGeneration(BasicParticleStore<Real>& s){return s.slot_generation;}
+    template <class Real> static std::vector<std::uint32_t>& indexSlot(BasicParticleStore<Real>& s){return s.index_slot;}
+    template <class Real> static std::vector<std::uint32_t>& freeSlots(BasicParticleStore<Real>& s){return s.free_slots;}
+};
+
+template <class Real>
+bool saveCheckpoint(const BasicContext<Real>& context,const std::string& path,std::string* error){
+    const BasicParticleStore<Real>& particles=context.particles;
+    const BasicDistanceConstraints<Real>& links=context.distances;
+    const std::size_t n=particles.size();
+    const std::uint32_t real_size=sizeof(Real);
+    if (links.size()>UINT32_MAX){
+        setError(error,path+": trop de liens de distance");
+        return false;
+    }
+
+    // Colliders mis à plat, dans l'ordre de leurs numéros (en double quelle que soit la précision)
+    std::vector<double> planes,spheres;
+    planes.reserve(context.colliders.planes.size()*5);
+    for (const basic_plancollider<Real>& plan:context.colliders.planes){
+        planes.insert(planes.end(),{plan.origin.first,plan.origin.second,plan.length,plan.normal[0],plan.normal[1]});
+    }
+    spheres.reserve(context.colliders.spheres.size()*3);
+    for (const basic_spherecollider<Real>& sphere:context.colliders.spheres){
+        spheres.insert(spheres.end(),{sphere.origin.first,sphere.origin.second,sphere.radius});
+    }
+
+    std::vector<StreamRecord> streams;
+    streams.reserve(context.streams.size());
+    for (const ParticleStream& s:context.streams){
+        streams.push_back({s.x,s.y,s.vx,s.vy,s.rate,s.width,s.radius,s.mass,s.max_particles,s.emitted,s.pending});
+    }
+
+    struct Source {BlockId id; std::uint32_t element_size; std::size_t count; const void* data;};
+    const std::vector<Source> sources={
+        {BlockX,real_size,n,particles.x.data()},
+        {BlockY,real_size,n,particles.y.data()},
+        {BlockPX,real_size,n,particles.px.data()},
+        {BlockPY,real_size,n,particles.py.data()},
+        {BlockVX,real_size,n,particles.vx.data()},
+        {BlockVY,real_size,n,particles.vy.data()},
+        {BlockRadius,real_size,n,particles.radius.data()},
+        {BlockInvMass,real_size,n,particles.inv_mass.data()},
+        {BlockSlotIndex,4,CheckpointAccess::slotIndex(particles).size(),CheckpointAccess::slotIndex(particles).data()},
+        {BlockSlotGeneration,4,CheckpointAccess::slotGeneration(particles).size(),CheckpointAccess::slotGeneration(particles).data()},
+        {BlockIndexSlot,4,CheckpointAccess::indexSlot(particles).size(),CheckpointAccess::indexSlot(particles).data()},
+        {BlockFreeSlots,4,CheckpointAccess::freeSlots(particles).size(),CheckpointAccess::freeSlots(particles).data()},
+        {BlockPlanes,40,context.colliders.planes.size(),planes.data()},
+        {BlockSpheres,24,context.colliders.spheres.size(),spheres.data()},
+        {BlockRestFrames,4,n,particles.rest_frames.data()},
+        {BlockRestX,real_size,n,particles.rest_x.data()},
+        {BlockRestY,real_size,n,particles.rest_y.data()},
+        {BlockLinkFirst,8,links.size(),links.first.data()},
+        {BlockLinkSecond,8,links.size(),links.second.data()},
+        {BlockLinkRest,real_size,links.size(),links.rest_length.data()},
+        {BlockLinkCompliance,real_size,links.size(),links.compliance.data()},
+        {BlockStreams,sizeof(StreamRecord),streams.size(),streams.data()},
+    };
+
+    CheckpointHeader header{};
+    std::memcpy(header.magic,checkpoint_magic,8);
+    header.version=checkpoint_version;
+    header.byte_order=byte_order_mark;
+    header.particle_count=n;
+    header.handle_slot_count=CheckpointAccess::slotIndex(particles).size();
+    header.free_slot_count=CheckpointAccess::freeSlots(particles).size();
+    header.plane_count=context.colliders.planes.size();
+    header.sphere_count=context.colliders.spheres.size();
+    header.force_x=context.champ_de_force.size()>0?context.champ_de_force[0]:0;
+    header.force_y=context.champ_de_force.size()>1?context.champ_de_force[1]:0;
+    header.alpha=context.alpha;
+    header.width=context.width;
+    header.height=context.height;
+    header.block_count=(std::uint32_t)sources.size();
+    header.link_count=(std::uint32_t)links.size();
+
+    std::vector<BlockEntry> table(sources.size());
+    std::size_t offset=alignUp(sizeof(CheckpointHeader)+table.size()*sizeof(BlockEntry));
+    for (std::size_t b=0;b<sources.size();b++){
+        table[b]={sources[b].id,sources[b].element_size,offset,sources[b].count};
+        offset=alignUp(offset+sources[b].count*sources[b].element_size);
+    }
+    header.file_size=offset;
+
+    FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file){
+        setError(error,path+": impossible d'écrire le fichier");
+        return false;
+    }
+    Hash64 checksum;
+    static const unsigned char zeros[block_alignment]={};
+    std::size_t written=0;
+    bool ok=true;
+    // Écrit des octets en les ajoutant à la somme de contrôle (sauf le début de l'en-tête)
+    auto put=[&](const void* data,std::size_t bytes){
+        if (bytes==0){return;}
+        ok=ok && std::fwrite(data,1,bytes,file)==bytes;
+        const unsigned char* p=static_cast<const unsigned char*>(data);
+        std::size_t skip=written<checksum_start?std::min(bytes,checksum_start-written):0;
+        checksum.add(p+skip,bytes-skip);
+        written+=bytes;
+    };
+    auto pad=[&](){put(zeros,alignUp(written)-written);};
+
+    put(&header,sizeof(header));
+    put(table.data(),table.size()*sizeof(BlockEntry));
+    pad();
+    for (const Source& source:sources){
+        put(source.data,source.count*source.element_size);
+        pad();
+    }
+    header.checksum=checksum.result();
+    ok=ok && std::fseek(file,offsetof(CheckpointHeader,checksum),SEEK_SET)==0;
+    ok=ok && std::fwrite(&header.checksum,sizeof(header.checksum),1,file)==1;
+    ok=(std::fclose(file)==0) && ok;
+    if (!ok){setError(error,path+": erreur d'écriture");}
+    return ok;
+}
+
+template <class Real>
+bool loadCheckpoint(const std::string& path,BasicContext<Real>& context,std::string* error,bool verify_checksum){
+    MappedFile file;
+    if (!file.open(path)){
+        setError(error,path+": impossible de lire le fichier");
+        return false;
+    }
+    const unsigned char* data=file.data();
+    CheckpointHeader header;
+    if (file.size()<sizeof(header) || std::memcmp(data,checkpoint_magic,8)!=0){
+        setError(error,path+": ce n'est pas un point de reprise");
+        return false;
+    }
+    std::memcpy(&header,data,sizeof(header));
+    if (header.byte_order!=byte_order_mark){
+        setError(error,path+": écrit sur une machine d'ordre des octets différent");
+        return false;
+    }
+    // Avant la version 3, link_count était un champ réservé, toujours nul
+    if (header.version<checkpoint_oldest_version || header.version>checkpoint_version
+        || (header.version<3 && header.link_count!=0)){
+        setError(error,path+": version "+std::to_string(header.version)+" non prise en charge");
+        return false;
+    }
+    if (header.file_size!=file.size()
+        || header.block_count>(file.size()-sizeof(header))/sizeof(BlockEntry)){
+        setError(error,path+": fichier tronqué");
+        return false;
+    }
+    if (verify_checksum){
+        Hash64 checksum;
+        checksum.add(data+checksum_start,file.size()-checksum_start);
+        if (checksum.result()!=header.checksum){
+            setError(error,path+": somme de contrôle incorrecte");
+            return false;
+        }
+    }
+
+    // On vérifie tous les blocs attendus avant de toucher au contexte
+    const unsigned char* blocks[BlockLast+1]={};
+    const std::uint64_t expected[BlockLast+1]={0,
+        header.particle_count,header.particle_count,header.particle_count,header.particle_count,
+        header.particle_count,header.particle_count,header.particle_count,header.particle_count,
+        header.handle_slot_count,header.handle_slot_count,header.particle_count,header.free_slot_count,
+        header.plane_count,header.sphere_count,
+        header.particle_count,header.particle_count,header.particle_count,
+        header.link_count,header.link_count,header.link_count,header.link_count,0};
+    const std::uint32_t r=sizeof(Real);
+    const std::uint32_t element_size[BlockLast+1]={0,r,r,r,r,r,r,r,r,4,4,4,4,40,24,4,r,r,8,8,r,r,sizeof(StreamRecord)};
+    std::uint64_t stream_count=0;
+    for (std::uint32_t b=0;b<header.block_count;b++){
+        BlockEntry entry;
+        std::memcpy(&entry,data+sizeof(header)+b*sizeof(BlockEntry),sizeof(entry));
+        if (entry.id<BlockX || entry.id>BlockLast){continue;}
+        // Les particules sont restaurées au bit près: pas de conversion entre float et double
+        if (isRealBlock(entry.id) && entry.element_size!=r && (entry.element_size==4 || entry.element_size==8)){
+            setError(error,path+": point de reprise en "+(entry.element_size==4?"float":"double")+", contexte en "+(r==4?"float":"double"));
+            return false;
+        }
+        // Le nombre de sources n'est pas dans l'en-tête: c'est celui du bloc
+        if (entry.id==BlockStreams){stream_count=entry.count;}
+        if (entry.element_size!=element_size[entry.id] || entry.count!=(entry.id==BlockStreams?stream_count:expected[entry.id])
+            || entry.offset%block_alignment!=0 || entry.offset>file.size()
+            || entry.count>(file.size()-entry.offset)/entry.element_size){
+            setError(error,path+": bloc "+std::to_string(entry.id)+" invalide");
+            return false;
+        }
+        blocks[entry.id]=data+entry.offset;
+    }
+    for (std::uint32_t id=BlockX;id<=BlockLast;id++){
+        // Le sommeil est facultatif, les liens ne le sont que s'il n'y en a pas, les sources avant la version 4
+        bool optional=(id>=BlockRestFrames && id<=BlockRestY) || (id>=BlockLinkFirst && id<=BlockLinkCompliance && header.link_count==0)
+                      || (id==BlockStreams && header.version<4);
+        if (!blocks[id] && !optional){
+            setError(error,path+": bloc "+std::to_string(id)+" manquant");
+            return false;
+        }
+    }
+
+    // Un fichier forgé (ou lu sans somme de contrôle) ne doit pas faire sortir les poignées des tableaux
+    if (!validHandleTables(reinterpret_cast<const std::uint32_t*>(blocks[BlockSlotIndex]),header.handle_slot_count,
+                           reinterpret_cast<const std::uint32_t*>(blocks[BlockIndexSlot]),header.particle_count,
+                           reinterpret_cast<const std::uint32_t*>(blocks[BlockFreeSlots]),header.free_slot_count)){
+        setError(error,path+": tables de poignées incohérentes");
+        return false;
+    }
+    std::vector<ParticleStream> streams(stream_count);
+    for (std::uint64_t k=0;k<stream_count;k++){
+        StreamRecord s;
+        std::memcpy(&s,blocks[BlockStreams]+k*sizeof(StreamRecord),sizeof(s));
+        bool finite=true;
+        for (double v:{s.x,s.y,s.vx,s.vy,s.rate,s.width,s.radius,s.mass,s.pending}){finite=finite && std::isfinite(v);}
+        if (!finite || s.rate<0 || s.pending<0 || (s.max_particles>0 && s.emitted>s.max_particles)){
+            setError(error,path+": source "+std::to_string(k)+" invalide");
+            return false;
+        }
+        ParticleStream& stream=streams[k];
+        stream.x=s.x; stream.y=s.y; stream.vx=s.vx; stream.vy=s.vy;
+        stream.rate=s.rate; stream.width=s.width; stream.radius=s.radius; stream.mass=s.mass;
+        stream.max_particles=(std::size_t)s.max_particles;
+        stream.emitted=(std::size_t)s.emitted;
+        stream.pending=s.pending;
+    }
+
+    // Les blocs sont alignés: copie directe dans les tableaux
+    const std::size_t n=header.particle_count;
+    auto copy=[&](std::uint32_t id,auto& target){
+        using T=typename std::decay_t<decltype(target)>::value_type;
+        const T* p=reinterpret_cast<const T*>(blocks[id]);
+        target.assign(p,p+expected[id]);
+    };
+    BasicParticleStore<Real>& particles=context.particles;
+    particles.clear();
+    particles.reserve(n);
+    copy(BlockX,particles.x);
+    copy(BlockY,particles.y);
+    copy(BlockPX,particles.px);
+    copy(BlockPY,particles.py);
+    copy(BlockVX,particles.vx);
+    copy(BlockVY,particles.vy);
+    copy(BlockRadius,particles.radius);
+    copy(BlockInvMass,particles.inv_mass);
+    copy(BlockSlotIndex,CheckpointAccess::slotIndex(particles));
+    copy(BlockSlotGeneration,CheckpointAccess::slotGeneration(particles));
+    copy(BlockIndexSlot,CheckpointAccess::indexSlot(particles));
+    copy(BlockFreeSlots,CheckpointAccess::freeSlots(particles));
+    if (blocks[BlockRestFrames] && blocks[BlockRestX] && blocks[BlockRestY]){
+        copy(BlockRestFrames,particles.rest_frames);
+        copy(BlockRestX,particles.rest_x);
+        copy(BlockRestY,particles.rest_y);
+    }else{
+        particles.rest_frames.assign(n,0);
+        particles.rest_x=particles.x;
+        particles.rest_y=particles.y;
+    }
+
+    context.colliders=BasicColliderSet<Real>();
+    const double* planes=reinterpret_cast<const double*>(blocks[BlockPlanes]);
+    for (std::uint64_t k=0;k<header.plane_count;k++,planes+=5){
+        basic_plancollider<Real> plan(std::make_pair(planes[0],planes[1]),planes[2],0);
+        plan.normal={Real(planes[3]),Real(planes[4])};
+        context.addCollider(plan);
+    }
+    const double* spheres=reinterpret_cast<const double*>(blocks[BlockSpheres]);
+    for (std::uint64_t k=0;k<header.sphere_count;k++,spheres+=3){
+        context.addCollider(basic_spherecollider<Real>(std::make_pair(spheres[0],spheres[1]),spheres[2]));
+    }
+
+    // Les poignées viennent d'être restaurées: tous les liens sont valides
+    std::vector<BasicDistanceConstraint<Real>> links(header.link_count);
+    for (std::uint32_t k=0;k<header.link_count;k++){
+        std::memcpy(&links[k].first,blocks[BlockLinkFirst]+k*sizeof(ParticleHandle),sizeof(ParticleHandle));
+        std::memcpy(&links[k].second,blocks[BlockLinkSecond]+k*sizeof(ParticleHandle),sizeof(ParticleHandle));
+        std::memcpy(&links[k].rest_length,blocks[BlockLinkRest]+k*sizeof(Real),sizeof(Real));
+        std::memcpy(&links[k].compliance,blocks[BlockLinkCompliance]+k*sizeof(Real),sizeof(Real));
+    }
+    context.distances.clear();
+    context.distances.add(links,particles);
+
+    // Avant la version 4, les sources n'étaient pas sauvegardées: celles du contexte sont gardées
+    if (header.version>=4){
+        context.streams.clear();
+        for (const ParticleStream& stream:streams){context.addStream(stream);}
+    }
+
+    context.champ_de_force={Real(header.force_x),Real(header.force_y)};
+    context.alpha=header.alpha;
+    context.width=header.width;
+    context.height=header.height;
+    context.deleteContactConstraints();
+    context.reserveStepBuffers();
+    return true;
+}
+
+template bool saveCheckpoint<float>(const ContextF&,const std::string&,std::string*);
+template bool saveCheckpoint<double>(const Context&,const std::string&,std::string*);
+template bool loadCheckpoint<float>(const std::string&,ContextF&,std::string*,bool);
+template bool loadCheckpoint<double>(const std::string&,Context&,std::string*,bool);
+
+bool isCheckpoint(const std::string& path){
+    FILE* file=std::fopen(path.c_str(),"rb");
+    if (!file){return false;}
+    char magic[8];
+    bool match=std::fread(magic,1,8,file)==8 && std::memcmp(magic,checkpoint_magic,8)==0;
+    std::fclose(file);
+    return match;
+}
@@ -0,0 +1,67 @@
+/******************************************************************************
+ * @file checkpoint.h
+ * @brief Points de reprise binaires: sauvegarde et restauration de l'état complet d'un Context.
+ *
+ * Le fichier contient un en-tête (version, nombres d'éléments, champ de force, frottement,
+ * bords, somme de contrôle), une table des blocs puis les blocs eux-mêmes: un tableau par
+ * grandeur des particules (SoA, comme le ParticleStore), les tables de poignées, les colliders, les
+ * liens de distance (un tableau par grandeur, comme DistanceConstraints) et les sources continues.
+ * Chaque bloc commence sur un multiple de 64 octets, si bien que la restauration projette le
+ * fichier en mémoire (mmap) et recopie chaque bloc directement dans son tableau.
+ *
+ * Les données sont écrites dans l'ordre des octets de la machine: un fichier écrit sur une machine
+ * d'ordre différent est refusé. Les contraintes de contact ne sont pas sauvegardées, elles sont
+ * recalculées à chaque pas.
+ *
+ * Les grandeurs des particules sont écrites dans la précision du contexte (4 octets pour ContextF, 8 pour
+ * Context) et ne sont relues que dans un contexte de même précision; les colliders, le champ de force et le
+ * frottement sont toujours écrits en double.
+ ******************************************************************************/
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <cstdint>
+#include <string>
+#include "Context.h"
+
+/**
+ * Versions du format: 1 particules, poignées et colliders; 2 ajoute l'état de sommeil; 3 ajoute les liens de distance;
+ * 4 ajoute les sources continues (réglages, particules émises, fraction reportée). Un fichier d'une version antérieure
+ * à 4 laisse les sources du contexte telles quelles.
+ * La version change dès que le format gagne de l'état: un lecteur plus ancien refuse alors le fichier au lieu
+ * d'ignorer les blocs qu'il ne connaît pas et de perdre cet état sans le dire.
+ */
+constexpr std::uint32_t checkpoint_version=4; /**< Version du format écrite par saveCheckpoint */
+constexpr std::uint32_t checkpoint_oldest_version=1; /**< Plus ancienne version lue par loadCheckpoint */
+
+/**
+ * @brief Écrit l'état du contexte dans un point de reprise.
+ * @param context Le contexte à sauvegarder.
+ * @param path Chemin du fichier.
+ * @param error Message d'erreur si l'écriture échoue, peut être nullptr.
+ * @return false si le fichier ne peut être écrit.
+ */
+template <class Real>
+bool saveCheckpoint(const BasicContext<Real>& context,const std::string& path,std::string* error);
+
+/**
+ * @brief Remplace l'état du contexte par celui d'un point de reprise.
+ * Les réglages (solveur, broadphase, threads) ne font pas partie de l'état et sont conservés; les sources continues
+ * en font partie et sont remplacées (à partir de la version 4).
+ * @param path Chemin du fichier.
+ * @param context Le contexte à remplacer.
+ * @param error Message d'erreur si la lecture échoue, peut être nullptr.
+ * @param verify_checksum false pour ne pas vérifier la somme de contrôle (restauration plus rapide).
+ * @return false si le fichier ne peut être lu, n'est pas un point de reprise valide, est corrompu ou d'une autre précision;
+ * le contexte n'est alors pas modifié.
+ */
+template <class Real>
+bool loadCheckpoint(const std::string& path,BasicContext<Real>& context,std::string* error,bool verify_checksum=true);
+
+/**
+ * @brief Indique si un fichier commence comme un point de reprise.
+ */
+bool isCheckpoint(const std::string& path);
+
+#endif // CHECKPOINT_H
@@ -1,4 +1,71 @@
+/******************************************************************************
+ * @file collider.cpp
+ * @brief Implémentation des fonctions de détection par type de collider définies dans collider.h,
+ * instanciées en float et en double
+ ******************************************************************************/
+
 #include "collider.h"
 
-collider::collider() {
+template <class Real>
+void findPlaneContacts(const basic_plancollider<Real>& plan,const Real* px,const Real* py,const Real* radius,std::size_t n,
+                       std::vector<Real>& depth,std::vector<BasicStaticConstraint<Real>>& constraints){
+    const Real nx=plan.normal[0];
+    const Real ny=plan.normal[1];
+    const Real ox=plan.origin.first;
+    const Real oy=plan.origin.second;
+    const Real length=plan.length;
+    depth.resize(n);
+    Real* d=depth.data();
+
+    // Profondeur de pénétration, négative s'il n'y a pas de contact
+    for (std::size_t i=0;i<n;i++){
+        Real d_plan=nx*(px[i]-ox)+ny*(py[i]-oy);
+        Real distance_au_centre=std::abs(ny*(px[i]-ox)-nx*(py[i]-oy));
+        bool contact=distance_au_centre<=length && std::abs(d_plan)<radius[i];
+        d[i]=contact?radius[i]-d_plan:Real(-1);
+    }
+    for (std::size_t i=0;i<n;i++){
+        if (d[i]>0){
+            // Le point d'impact est le projeté orthogonal de la particule sur le plan
+            Real d_plan=radius[i]-d[i];
+            constraints.push_back(BasicStaticConstraint<Real>{(std::uint32_t)i,nx,ny,d[i],px[i]-nx*d_plan,py[i]-ny*d_plan});
+        }
+    }
+}
+
+template <class Real>
+void findSphereContacts(const basic_spherecollider<Real>& sphere,const Real* px,const Real* py,const Real* radius,std::size_t n,
+                        std::vector<Real>& depth,std::vector<BasicStaticConstraint<Real>>& constraints){
+    const Real ox=sphere.origin.first;
+    const Real oy=sphere.origin.second;
+    const Real R=sphere.radius;
+    depth.resize(n);
+    Real* d=depth.data();
+
+    // Profondeur de pénétration, négative s'il n'y a pas de contact
+    for (std::size_t i=0;i<n;i++){
+        Real deltaX=px[i]-ox;
+        Real deltaY=py[i]-oy;
+        Real distance=std::sqrt(deltaX*deltaX+deltaY*deltaY);
+        d[i]=distance<=R+radius[i]?R+radius[i]-distance:Real(-1);
+    }
+    for (std::size_t i=0;i<n;i++){
+        if (d[i]>=0){
+            Real deltaX=px[i]-ox;
+            Real deltaY=py[i]-oy;
+            Real distance=std::sqrt(deltaX*deltaX+deltaY*deltaY);
+            const Real nx=deltaX/distance;
+            const Real ny=deltaY/distance;
+            constraints.push_back(BasicStaticConstraint<Real>{(std::uint32_t)i,nx,ny,d[i],ox+R*nx,oy+R*ny});
+        }
+    }
 }
+
+template void findPlaneContacts<float>(const basic_plancollider<float>&,const float*,const float*,const float*,std::size_t,
+                                       std::vector<float>&,std::vector<BasicStaticConstraint<float>>&);
+template void findPlaneContacts<double>(const basic_plancollider<double>&,const double*,const double*,const double*,std::size_t,
+                                        std::vector<double>&,std::vector<BasicStaticConstraint<double>>&);
+template void findSphereContacts<float>(const basic_spherecollider<float>&,const float*,const float*,const float*,std::size_t,
+                                        std::vector<float>&,std::vector<BasicStaticConstraint<float>>&);
+template void findSphereContacts<double>(const basic_spherecollider<double>&,const double*,const double*,const double*,std::size_t,
+                                         std::vector<double>&,std::vector<BasicStaticConstraint<double>>&);
@@ -5,101 +5,124 @@
  * Ce fichier définit les structures de particules, les contraintes statiques,
  * et les classes abstraites et concrètes pour gérer les collisions
  * (plans et sphères).
+ *
+ * Toutes sont paramétrées par le type des nombres réels (Real): le moteur est instancié
+ * en double (précision d'origine, noms sans suffixe: particle, plancollider...) et en float
+ * (deux fois plus de particules par instruction SIMD et moitié moins de mémoire parcourue).
  ******************************************************************************/
 
 #ifndef COLLIDER_H
 #define COLLIDER_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <optional>
 #include <cmath>
 #include <utility>
 
 /**
- * @struct particle
+ * @struct basic_particle
  * @brief Représente une particule sur un plan avec ses propriétés physiques.
  *
  * Cette structure contient la position actuelle,
  * la position future prédite (qui change à chaque force appliquée à chaque itération),
- * la vitesse_future prédite (qui change aussi régulièrement)
  * la vitesse,le rayon et enfin la masse de la particule.
+ * Elle ne sert plus qu'à décrire une particule (ajout, copie ponctuelle): la simulation
+ * travaille directement sur les tableaux du ParticleStore (voir particlestore.h).
+ * Les champs sont de taille fixe pour qu'aucune copie n'alloue de mémoire.
  */
-struct particle {
-    std::vector<double> pos; /**< Position actuelle de la particule. */
-    std::vector<double> future_pos; /**< Position future calculée de la particule. */
-    std::vector<double> velocity; /**< Vitesse actuelle de la particule. */
-    std::vector<double> future_velocity; /**< Vitesse future calculée de la particule. */
-    double radius; /**< Rayon de la particule. */
-    double mass; /**< Masse de la particule. */
+template <class Real>
+struct basic_particle {
+    std::array<Real,2> pos{}; /**< Position actuelle de la particule. */
+    std::array<Real,2> future_pos{}; /**< Position future calculée de la particule. */
+    std::array<Real,2> velocity{}; /**< Vitesse de la particule. */
+    Real radius=0; /**< Rayon de la particule. */
+    Real mass=0; /**< Masse de la particule. */
 
     /**
      * @brief Opérateur de comparaison pour vérifier l'égalité entre deux particules.
      * @param other L'autre particule à comparer.
      * @return true si les particules sont égales, false sinon.
      */
-    bool operator==(const particle& other) const {
+    bool operator==(const basic_particle& other) const {
         return pos==other.pos && velocity==other.velocity && radius==other.radius && mass==other.mass;}
 };
 
 /**
- * @struct StaticConstraint
+ * @struct BasicStaticConstraint
  * @brief Représente une contrainte statique résultant d'une collision.
  *
- * Cette structure contient les informations sur le point d'impact,
- * la normale de collision et la particule impliquée.
+ * Cette structure contient l'indice de la particule impliquée, la normale de collision,
+ * la profondeur de pénétration le long de cette normale et le point de contact sur le collider:
+ * la résolution replace la particule au point de contact plus son rayon le long de la normale
+ * et fait rebondir sa vitesse.
  * Cette structure est définie dans cette classe et non context.h
  * car les deux fichiers ne peuvent s'inclure l'un et l'autre
  */
-struct StaticConstraint {
-    std::pair<double, double> pt_impact; /**< Point d'impact de la collision. */
-    std::vector<double> normal; /**< Normale de la collision. */
-    particle part; /**< Particule impliquée dans la collision. */
-};
-
-struct DynamicConstraint {
-    std::pair<double,double> pt_impact; /**< Point d'impact de la collision. */
-    particle part1; /**< Première particule impliquée dans la collision. */
-    particle part2; /**< Seconde particule impliquée dans la collision. */
+template <class Real>
+struct BasicStaticConstraint {
+    std::uint32_t index=0; /**< Indice de la particule dans le ParticleStore du contexte. */
+    Real nx=0; /**< Normale de la collision, selon x. */
+    Real ny=0; /**< Normale de la collision, selon y. */
+    Real depth=0; /**< Déplacement à appliquer le long de la normale pour sortir du collider. */
+    Real x=0; /**< Point de contact sur le collider, selon x. */
+    Real y=0; /**< Point de contact sur le collider, selon y. */
 };
 
 /**
- * @class collider
- * @brief Classe abstraite pour représenter un objet pouvant détecter des collisions.
+ * @struct BasicDynamicConstraint
+ * @brief Représente une contrainte dynamique entre deux particules qui se chevauchent.
  *
- * Cette classe définit une méthode virtuelle pure pour vérifier le contact
- * entre une particule et l'objet de collision.
+ * La normale va de la première vers la seconde particule. Les vitesses normales des deux particules
+ * sont mesurées lors de la détection: la résolution donne à chaque particule la vitesse normale que
+ * l'autre avait à ce moment (échange des vitesses normales).
  */
-class collider {
+template <class Real>
+struct BasicDynamicConstraint {
+    std::uint32_t index1=0; /**< Indice de la première particule dans le ParticleStore du contexte. */
+    std::uint32_t index2=0; /**< Indice de la seconde particule dans le ParticleStore du contexte. */
+    Real nx=0; /**< Normale de la collision selon x (de la première vers la seconde particule). */
+    Real ny=0; /**< Normale de la collision selon y. */
+    Real depth=0; /**< Recouvrement des deux particules (somme des rayons moins la distance). */
+    Real vn1=0; /**< Vitesse normale v1.n de la première particule au moment de la détection. */
+    Real vn2=0; /**< Vitesse normale v2.n de la seconde particule au moment de la détection. */
+};
 
-public:
-    /**
-     * @brief Destructeur virtuel par défaut.
-     */
-    virtual ~collider() = default;
+/**
+ * @struct AABB
+ * @brief Boîte englobante alignée sur les axes, en double quelle que soit la précision des particules.
+ */
+struct AABB {
+    double min_x=0; /**< Abscisse minimale. */
+    double min_y=0; /**< Ordonnée minimale. */
+    double max_x=0; /**< Abscisse maximale. */
+    double max_y=0; /**< Ordonnée maximale. */
 
     /**
-     * @brief Vérifie si une particule entre en contact avec cet objet.
-     * @param particle La particule à tester.
-     * @return Une contrainte statique si un contact est détecté, std::nullopt sinon.
+     * @brief Indique si deux boîtes se recouvrent (bords compris).
      */
-    virtual auto checkContact(const particle& particle)-> std::optional<StaticConstraint> = 0;
+    bool overlaps(const AABB& other) const {
+        return min_x<=other.max_x && other.min_x<=max_x && min_y<=other.max_y && other.min_y<=max_y;}
 };
 
 /**
- * @class plancollider
+ * @class basic_plancollider
  * @brief Classe pour représenter un plan détectant des collisions.
  *
- * Cette classe hérite de la classe collider et implémente la vérification de contact
+ * Cette classe implémente la vérification de contact
  * avec un plan défini par son point milieu, la longueur entre le milieu et chacun des bords, et sa normale.
- * Ses caractéristiques sont publiques pour être accédées dans la
- * méthode enforceStaticGroundConstraint de context.cpp
+ * Les colliders ne sont pas polymorphes: chaque type est rangé dans son propre tableau
+ * d'un ColliderSet, et la détection est faite type par type sans appel virtuel.
+ * Ses caractéristiques sont publiques pour être accédées lors du dessin dans drawarea.cpp
  */
-class plancollider : public collider {
+template <class Real>
+class basic_plancollider {
 
 public:
-    std::pair<double, double> origin; /**< Milieu du plan. */
-    double length; /**< Distance entre le milieu du plan et un bord du plan. */
-    std::vector<double> normal; /**< Normale du plan. */
+    std::pair<Real, Real> origin; /**< Milieu du plan. */
+    Real length; /**< Distance entre le milieu du plan et un bord du plan. */
+    std::array<Real,2> normal; /**< Normale du plan. */
 
     /**
      * @brief Constructeur du plan de collision.
@@ -107,68 +130,174 @@ public:
      * @param length Longueur entre le milieu du plan et un des bords.
      * @param angle Angle d'orientation du plan (!en radians!).
      */
-    plancollider(const std::pair<double, double>& point, double length, double angle)
-        : origin(point), length(length), normal({-std::sin(angle),-std::cos(angle)}) {}
+    basic_plancollider(const std::pair<Real, Real>& point, Real length, double angle)
+        : origin(point), length(length), normal({Real(-std::sin(angle)),Real(-std::cos(angle))}) {}
 
     /**
      * @brief Vérifie si une particule entre en contact avec le plan.
-     * @param particle La particule à tester.
-     * @return Une contrainte statique si un contact est détecté, std::nullopt sinon.
+     * @param px Abscisse future de la particule.
+     * @param py Ordonnée future de la particule.
+     * @param r Rayon de la particule.
+     * @param constraint Contrainte remplie (sauf l'indice de particule) si un contact est détecté.
+     * @return true si un contact est détecté, false sinon.
      */
-    auto checkContact(const particle& particle)-> std::optional<StaticConstraint> override {
-        //géométrie vectorielle: calcul du projeté orthogonal sur le plan en calculant d'abord la distance de la particule au plan
-        double d_plan=normal[0]*(particle.future_pos[0]-origin.first)+normal[1]*(particle.future_pos[1]-origin.second);
-        std::pair<double,double> impact_point={particle.future_pos[0]-d_plan*normal[0],particle.future_pos[1]-d_plan*normal[1]};
-
-        double distance_au_centre=std::sqrt( (impact_point.first-origin.first)*(impact_point.first-origin.first)+(impact_point.second-origin.second)*(impact_point.second-origin.second));
+    bool checkContact(Real px,Real py,Real r,BasicStaticConstraint<Real>& constraint) const {
+        //géométrie vectorielle: distance signée de la particule au plan, et distance entre le projeté orthogonal et le milieu du plan
+        Real d_plan=normal[0]*(px-origin.first)+normal[1]*(py-origin.second);
+        Real distance_au_centre=std::abs(normal[1]*(px-origin.first)-normal[0]*(py-origin.second));
 
         // On vérifie si la particule est à une distance plus petite que son rayon du plan,
         // et si la particule ne passe pas à côté de la surface plane
-        if (distance_au_centre<=length && std::abs(d_plan)<particle.radius) {return StaticConstraint{impact_point,normal,particle};}
-        else {return std::nullopt;}
+        if (distance_au_centre<=length && std::abs(d_plan)<r) {
+            // Le point d'impact est le projeté orthogonal de la particule sur le plan
+            constraint=BasicStaticConstraint<Real>{0,normal[0],normal[1],r-d_plan,px-normal[0]*d_plan,py-normal[1]*d_plan};
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Boîte englobante du segment entre les deux extrémités du plan.
+     */
+    AABB boundingBox() const {
+        double dx=std::abs((double)normal[1]*length);
+        double dy=std::abs((double)normal[0]*length);
+        return AABB{origin.first-dx,origin.second-dy,origin.first+dx,origin.second+dy};
     }
 };
 
 /**
- * @class spherecollider
+ * @class basic_spherecollider
  * @brief Classe pour représenter une sphère détectant des collisions.
  *
- * Cette classe hérite de la classe collider et implémente la vérification de contact
+ * Cette classe implémente la vérification de contact
  * avec une sphère (un cercle, en 2D) définie par son centre et son rayon.
- * Ses caractéristiques sont publiques pour être accédées dans la
- * méthode enforceStaticGroundConstraint de context.cpp
+ * Ses caractéristiques sont publiques pour être accédées lors du dessin dans drawarea.cpp
  */
-class spherecollider : public collider {
+template <class Real>
+class basic_spherecollider {
 
 public:
 
-    std::pair<double, double> origin; /**< Centre de la sphère. */
-    double radius; /**< Rayon de la sphère. */
+    std::pair<Real, Real> origin; /**< Centre de la sphère. */
+    Real radius; /**< Rayon de la sphère. */
 
     /**
      * @brief Constructeur de la sphère de collision.
      * @param origin Centre de la sphère.
      * @param radius Rayon de la sphère.
      */
-    spherecollider(const std::pair<double, double>& origin, double radius)
+    basic_spherecollider(const std::pair<Real, Real>& origin, Real radius)
         : origin(origin), radius(radius) {}
 
     /**
      * @brief Vérifie si une particule entre en contact avec la sphère.
-     * @param particle La particule à tester.
-     * @return Une contrainte statique si un contact est détecté, std::nullopt sinon.
+     * @param px Abscisse future de la particule.
+     * @param py Ordonnée future de la particule.
+     * @param r Rayon de la particule.
+     * @param constraint Contrainte remplie (sauf l'indice de particule) si un contact est détecté.
+     * @return true si un contact est détecté, false sinon.
      */
-    auto checkContact(const particle& particle)-> std::optional<StaticConstraint> override {
-        double deltaX=particle.future_pos[0]-origin.first;
-        double deltaY=particle.future_pos[1]-origin.second;
-        double distance =std::sqrt(deltaX*deltaX+deltaY*deltaY);
+    bool checkContact(Real px,Real py,Real r,BasicStaticConstraint<Real>& constraint) const {
+        Real deltaX=px-origin.first;
+        Real deltaY=py-origin.second;
+        Real distance =std::sqrt(deltaX*deltaX+deltaY*deltaY);
         //Contact si la distance est plus petite que la somme des deux rayons (particule et sphère de collision)
-        if (distance<=radius+particle.radius){
-            std::vector<double> normal={deltaX/distance,deltaY/distance};
-            std::pair<double,double> impact_point={origin.first+radius*normal[0],origin.second+radius*normal[1]};
-            return StaticConstraint{impact_point,normal,particle};
-        }else{return std::nullopt;}
+        if (distance<=radius+r){
+            // La particule est replacée sur la sphère, au point d'impact origin+radius*normal
+            const Real nx=deltaX/distance;
+            const Real ny=deltaY/distance;
+            constraint=BasicStaticConstraint<Real>{0,nx,ny,radius+r-distance,origin.first+radius*nx,origin.second+radius*ny};
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Boîte englobante de la sphère.
+     */
+    AABB boundingBox() const {
+        return AABB{(double)origin.first-radius,(double)origin.second-radius,(double)origin.first+radius,(double)origin.second+radius};
     }
 };
 
+/**
+ * @struct BasicColliderSet
+ * @brief Ensemble des colliders statiques, rangés par type dans des tableaux contigus.
+ *
+ * Un collider est désigné globalement par un identifiant: les plans d'abord
+ * (0 à planes.size()-1), puis les sphères. C'est l'identifiant utilisé par la BVH.
+ */
+template <class Real>
+struct BasicColliderSet {
+    std::vector<basic_plancollider<Real>> planes;    /**< Plans de collision. */
+    std::vector<basic_spherecollider<Real>> spheres; /**< Sphères de collision. */
+
+    /**
+     * @brief Nombre total de colliders.
+     */
+    std::size_t size() const {return planes.size()+spheres.size();}
+
+    /**
+     * @brief Indique si l'ensemble est vide.
+     */
+    bool empty() const {return planes.empty() && spheres.empty();}
+
+    /**
+     * @brief Boîte englobante du collider d'identifiant id.
+     */
+    AABB boundingBox(std::uint32_t id) const {
+        if (id<planes.size()){return planes[id].boundingBox();}
+        return spheres[id-planes.size()].boundingBox();
+    }
+
+    /**
+     * @brief Vérifie le contact entre une particule et le collider d'identifiant id.
+     * @return true si un contact est détecté (constraint est alors remplie, sauf l'indice de particule).
+     */
+    bool checkContact(std::uint32_t id,Real px,Real py,Real r,BasicStaticConstraint<Real>& constraint) const {
+        if (id<planes.size()){return planes[id].checkContact(px,py,r,constraint);}
+        return spheres[id-planes.size()].checkContact(px,py,r,constraint);
+    }
+};
+
+/**
+ * @brief Détecte les contacts entre un plan et toutes les particules.
+ *
+ * Une première boucle sans branchement calcule la profondeur de pénétration de chaque
+ * particule (vectorisable par le compilateur), une seconde ajoute les contraintes des particules en contact.
+ * @param plan Le plan de collision.
+ * @param px Abscisses futures des particules.
+ * @param py Ordonnées futures des particules.
+ * @param radius Rayons des particules.
+ * @param n Nombre de particules.
+ * @param depth Tampon de travail, redimensionné à n.
+ * @param constraints Vecteur auquel sont ajoutées les contraintes détectées.
+ */
+template <class Real>
+void findPlaneContacts(const basic_plancollider<Real>& plan,const Real* px,const Real* py,const Real* radius,std::size_t n,
+                       std::vector<Real>& depth,std::vector<BasicStaticConstraint<Real>>& constraints);
+
+/**
+ * @brief Détecte les contacts entre une sphère et toutes les particules, en deux boucles comme findPlaneContacts.
+ * @param sphere La sphère de collision.
+ * @param px Abscisses futures des particules.
+ * @param py Ordonnées futures des particules.
+ * @param radius Rayons des particules.
+ * @param n Nombre de particules.
+ * @param depth Tampon de travail, redimensionné à n.
+ * @param constraints Vecteur auquel sont ajoutées les contraintes détectées.
+ */
+template <class Real>
+void findSphereContacts(const basic_spherecollider<Real>& sphere,const Real* px,const Real* py,const Real* radius,std::size_t n,
+                        std::vector<Real>& depth,std::vector<BasicStaticConstraint<Real>>& constraints);
+
+// Précision d'origine: les noms sans suffixe désignent les versions en double
+using particle=basic_particle<double>;
+using StaticConstraint=BasicStaticConstraint<double>;
+using DynamicConstraint=BasicDynamicConstraint<double>;
+using plancollider=basic_plancollider<double>;
+using spherecollider=basic_spherecollider<double>;
+using ColliderSet=BasicColliderSet<double>;
+
 #endif // COLLIDER_H
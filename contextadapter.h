@@ -0,0 +1,41 @@
+/******************************************************************************
+ * @file contextadapter.h
+ * @brief Définition de la classe ContextAdapter qui relie les signaux Qt au Context.
+ *
+ * Context ne dépend pas de Qt: cette classe expose ses commandes sous forme de slots
+ * pour que les boutons de l'interface puissent y être connectés. Le Context appartenant
+ * au thread de simulation, les commandes lui sont transmises par la file de SimulationThread.
+ ******************************************************************************/
+
+#ifndef CONTEXTADAPTER_H
+#define CONTEXTADAPTER_H
+
+#include <QObject>
+#include "simulationthread.h"
+
+/**
+ * @class ContextAdapter
+ * @brief Slots Qt transmettant les commandes de l'interface au Context du thread de simulation.
+ */
+class ContextAdapter : public QObject {
+    Q_OBJECT
+
+private:
+    SimulationThread& simulation; /**< Thread de simulation piloté, qui doit vivre plus longtemps que l'adaptateur */
+
+public:
+    /**
+     * @brief Constructeur.
+     * @param simulation Le thread de simulation à piloter.
+     * @param parent Parent Qt de l'adaptateur.
+     */
+    explicit ContextAdapter(SimulationThread& simulation,QObject* parent=nullptr) : QObject(parent), simulation(simulation) {}
+
+public slots:
+    void resetSimulation(){simulation.post([](Context& context){context.resetSimulation();});}
+    void frictionTrigger(){simulation.post([](Context& context){context.frictionTrigger();});}
+    void sleepTrigger(){simulation.post([](Context& context){context.sleepTrigger();});}
+    void gravityChange(){simulation.post([](Context& context){context.gravityChange();});}
+};
+
+#endif // CONTEXTADAPTER_H
@@ -0,0 +1,165 @@
+/******************************************************************************
+ * @file distanceconstraints.cpp
+ * @brief Implémentation des méthodes de la classe BasicDistanceConstraints définies dans
+ * distanceconstraints.h, instanciée en float et en double
+ ******************************************************************************/
+
+#include "distanceconstraints.h"
+#include "stepbuffers.h"
+#include <algorithm>
+#include <cmath>
+
+template <class Real>
+void BasicDistanceConstraints<Real>::reserve(std::size_t n){
+    first.reserve(n);
+    second.reserve(n);
+    rest_length.reserve(n);
+    compliance.reserve(n);
+    index1.reserve(n);
+    index2.reserve(n);
+    lambda.reserve(n);
+}
+
+template <class Real>
+std::size_t BasicDistanceConstraints<Real>::add(const std::vector<BasicDistanceConstraint<Real>>& links,const BasicParticleStore<Real>& particles){
+    reserve(size()+links.size());
+    std::size_t added=0;
+    for (const BasicDistanceConstraint<Real>& link:links){
+        if (!particles.valid(link.first) || !particles.valid(link.second) || link.first==link.second){continue;}
+        Real length=link.rest_length;
+        if (length<0){
+            std::size_t i=particles.indexOf(link.first);
+            std::size_t j=particles.indexOf(link.second);
+            Real dx=particles.x[j]-particles.x[i];
+            Real dy=particles.y[j]-particles.y[i];
+            length=std::sqrt(dx*dx+dy*dy);
+        }
+        first.push_back(link.first);
+        second.push_back(link.second);
+        rest_length.push_back(length);
+        compliance.push_back(std::max(link.compliance,Real(0)));
+        added++;
+    }
+    if (added>0){colors_dirty=true;}
+    return added;
+}
+
+/**
+* @brief Retire les liens marqués dans removed, en conservant l'ordre des autres
+* @return Le nombre de liens retirés
+*/
+template <class Real>
+std::size_t BasicDistanceConstraints<Real>::compact(){
+    const std::size_t n=size();
+    std::size_t kept=0;
+    for (std::size_t k=0;k<n;k++){
+        if (removed[k]){continue;}
+        first[kept]=first[k];
+        second[kept]=second[k];
+        rest_length[kept]=rest_length[k];
+        compliance[kept]=compliance[k];
+        kept++;
+    }
+    first.resize(kept);
+    second.resize(kept);
+    rest_length.resize(kept);
+    compliance.resize(kept);
+    if (kept!=n){colors_dirty=true;}
+    return n-kept;
+}
+
+template <class Real>
+std::size_t BasicDistanceConstraints<Real>::remove(const std::vector<std::uint32_t>& links){
+    removed.assign(size(),0);
+    for (std::uint32_t k:links){
+        if (k<size()){removed[k]=1;}
+    }
+    return compact();
+}
+
+template <class Real>
+std::size_t BasicDistanceConstraints<Real>::removeAttached(const std::vector<ParticleHandle>& handles){
+    // Poignées triées: une recherche dichotomique par extrémité
+    std::vector<ParticleHandle> sorted(handles);
+    auto less=[](const ParticleHandle& a,const ParticleHandle& b){return a.id<b.id || (a.id==b.id && a.generation<b.generation);};
+    std::sort(sorted.begin(),sorted.end(),less);
+    removed.assign(size(),0);
+    for (std::size_t k=0;k<size();k++){
+        removed[k]=std::binary_search(sorted.begin(),sorted.end(),first[k],less) || std::binary_search(sorted.begin(),sorted.end(),second[k],less);
+    }
+    return compact();
+}
+
+template <class Real>
+void BasicDistanceConstraints<Real>::clear(){
+    first.clear();
+    second.clear();
+    rest_length.clear();
+    compliance.clear();
+    index1.clear();
+    index2.clear();
+    lambda.clear();
+    colors_dirty=true;
+}
+
+template <class Real>
+void BasicDistanceConstraints<Real>::resolve(const BasicParticleStore<Real>& particles){
+    // Des particules ont été supprimées ou ajoutées: les liens vers une particule supprimée disparaissent
+    if (particles.revision()!=particles_revision){
+        assignStepBuffer(removed,size(),0);
+        bool any=false;
+        for (std::size_t k=0;k<size();k++){
+            if (!particles.valid(first[k]) || !particles.valid(second[k])){removed[k]=1;any=true;}
+        }
+        if (any){compact();}
+        particles_revision=particles.revision();
+    }
+    // Les indices changent aussi sans ajout ni suppression (mise en sommeil): ils sont recalculés à chaque fois
+    const std::size_t n=size();
+    resizeStepBuffer(index1,n);
+    resizeStepBuffer(index2,n);
+    for (std::size_t k=0;k<n;k++){
+        index1[k]=(std::uint32_t)particles.indexOf(first[k]);
+        index2[k]=(std::uint32_t)particles.indexOf(second[k]);
+    }
+    if (colors_dirty){
+        colorLinks(particles.size());
+        colors_dirty=false;
+    }
+}
+
+/**
+* @brief Coloration gloutonne des liens, comme celle des contraintes dynamiques (voir Context::colorConstraints).
+* Elle ne dépend que des extrémités des liens: un changement d'indice des particules ne la remet pas en cause.
+* Les liens qui ne trouvent pas de couleur parmi les 64 possibles sont placés dans une dernière couleur, résolue séquentiellement.
+*/
+template <class Real>
+void BasicDistanceConstraints<Real>::colorLinks(std::size_t particle_count){
+    const std::size_t n=size();
+    used_colors.assign(particle_count,0);
+    link_color.resize(n);
+    std::uint32_t n_colors=0;
+    for (std::size_t k=0;k<n;k++){
+        std::uint64_t used=used_colors[index1[k]]|used_colors[index2[k]];
+        std::uint32_t color=64;
+        if (used!=UINT64_MAX){
+            color=0;
+            while (used&(std::uint64_t(1)<<color)){color++;}
+            used_colors[index1[k]]|=std::uint64_t(1)<<color;
+            used_colors[index2[k]]|=std::uint64_t(1)<<color;
+        }
+        link_color[k]=color;
+        n_colors=std::max(n_colors,color+1);
+    }
+
+    // Tri par comptage des liens selon leur couleur
+    color_offsets.assign(n_colors+1,0);
+    for (std::size_t k=0;k<n;k++){color_offsets[link_color[k]+1]++;}
+    for (std::uint32_t c=1;c<=n_colors;c++){color_offsets[c]+=color_offsets[c-1];}
+    color_list.resize(n);
+    std::vector<std::uint32_t> cursor(color_offsets.begin(),color_offsets.end()-1);
+    for (std::uint32_t k=0;k<n;k++){color_list[cursor[link_color[k]]++]=k;}
+}
+
+template class BasicDistanceConstraints<float>;
+template class BasicDistanceConstraints<double>;
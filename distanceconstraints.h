@@ -0,0 +1,121 @@
+/******************************************************************************
+ * @file distanceconstraints.h
+ * @brief Définition de la classe DistanceConstraints qui stocke les liens de distance
+ * persistants entre particules (cordes, chaînes, treillis).
+ *
+ * Contrairement aux contraintes de contact, recalculées à chaque pas, un lien reste en place
+ * jusqu'à sa suppression. Les liens sont rangés en tableaux d'arêtes contigus (une entrée par lien
+ * et par grandeur): la projection les parcourt linéairement. Les extrémités sont désignées par
+ * leurs poignées, stables quand les particules changent de place dans le ParticleStore; les indices
+ * correspondants sont recalculés au début de chaque projection (voir resolve).
+ ******************************************************************************/
+
+#ifndef DISTANCECONSTRAINTS_H
+#define DISTANCECONSTRAINTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "particlestore.h"
+
+/**
+ * @struct BasicDistanceConstraint
+ * @brief Description d'un lien à ajouter: les deux particules doivent rester à distance rest_length.
+ */
+template <class Real>
+struct BasicDistanceConstraint {
+    ParticleHandle first;  /**< Première extrémité */
+    ParticleHandle second; /**< Seconde extrémité */
+    Real rest_length=-1;   /**< Longueur au repos, négative pour garder la distance actuelle des deux particules */
+    Real compliance=0;     /**< Souplesse du lien (inverse d'une raideur, 0: rigide) */
+};
+
+/**
+ * @class BasicDistanceConstraints
+ * @brief Liens de distance persistants, en tableaux d'arêtes de réels de type Real (float ou double).
+ *
+ * Les tableaux sont publics en lecture; seuls add, remove, removeAttached et clear les modifient.
+ * L'ordre des liens est celui de leur ajout, conservé par les suppressions: le numéro d'un lien
+ * est son rang dans les tableaux. Les liens sont aussi regroupés par couleurs (deux liens de même
+ * couleur n'ont aucune particule en commun) pour les solveurs parallèles; cette coloration n'est
+ * recalculée que si les liens ont changé.
+ */
+template <class Real>
+class BasicDistanceConstraints {
+public:
+    std::vector<ParticleHandle> first;  /**< Première extrémité de chaque lien */
+    std::vector<ParticleHandle> second; /**< Seconde extrémité de chaque lien */
+    std::vector<Real> rest_length;      /**< Longueur au repos */
+    std::vector<Real> compliance;       /**< Souplesse */
+    std::vector<std::uint32_t> index1;  /**< Indice actuel de la première extrémité, valable après resolve */
+    std::vector<std::uint32_t> index2;  /**< Indice actuel de la seconde extrémité, valable après resolve */
+    std::vector<Real> lambda;           /**< XPBD: multiplicateur de Lagrange de chaque lien pendant le sous-pas */
+    std::vector<std::uint32_t> color_offsets; /**< Début de chaque couleur dans color_list */
+    std::vector<std::uint32_t> color_list;    /**< Liens rangés couleur par couleur, dans l'ordre des liens */
+
+    /**
+     * @brief Nombre de liens.
+     */
+    std::size_t size() const {return first.size();}
+
+    /**
+     * @brief Indique s'il n'y a aucun lien.
+     */
+    bool empty() const {return first.empty();}
+
+    /**
+     * @brief Réserve la mémoire pour n liens dans chacun des tableaux.
+     */
+    void reserve(std::size_t n);
+
+    /**
+     * @brief Ajoute un lot de liens en fin de tableaux.
+     * Les liens dont une poignée n'est pas valide, ou dont les deux extrémités sont la même particule, sont ignorés.
+     * @param links Liens à ajouter.
+     * @param particles Les particules désignées par les poignées (pour les longueurs au repos négatives).
+     * @return Le nombre de liens ajoutés.
+     */
+    std::size_t add(const std::vector<BasicDistanceConstraint<Real>>& links,const BasicParticleStore<Real>& particles);
+
+    /**
+     * @brief Supprime un lot de liens en une seule passe; les liens restants gardent leur ordre.
+     * @param links Numéros des liens à supprimer, dans un ordre quelconque (les numéros hors limites sont ignorés).
+     * @return Le nombre de liens supprimés.
+     */
+    std::size_t remove(const std::vector<std::uint32_t>& links);
+
+    /**
+     * @brief Supprime en une seule passe tous les liens attachés à l'une des particules (pour couper une corde, déchirer un treillis).
+     * @return Le nombre de liens supprimés.
+     */
+    std::size_t removeAttached(const std::vector<ParticleHandle>& handles);
+
+    /**
+     * @brief Supprime tous les liens.
+     */
+    void clear();
+
+    /**
+     * @brief Prépare la projection: supprime les liens dont une particule a été supprimée, recalcule
+     * index1 et index2 et, si les liens ont changé, la coloration.
+     * @param particles Les particules du contexte.
+     */
+    void resolve(const BasicParticleStore<Real>& particles);
+
+private:
+    bool colors_dirty=true; /**< Vrai si les liens ont changé depuis la dernière coloration */
+    std::uint64_t particles_revision=UINT64_MAX; /**< Révision du ParticleStore au dernier resolve */
+    std::vector<std::uint64_t> used_colors; /**< Couleurs déjà prises par les liens de chaque particule (une par bit) */
+    std::vector<std::uint32_t> link_color;  /**< Couleur de chaque lien */
+    std::vector<char> removed;              /**< Tampon de travail de remove et removeAttached */
+
+    std::size_t compact();
+    void colorLinks(std::size_t particle_count);
+};
+
+using DistanceConstraint=BasicDistanceConstraint<double>;
+using DistanceConstraintF=BasicDistanceConstraint<float>;
+using DistanceConstraints=BasicDistanceConstraints<double>;
+using DistanceConstraintsF=BasicDistanceConstraints<float>;
+
+#endif // DISTANCECONSTRAINTS_H
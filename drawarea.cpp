@@ -7,71 +7,78 @@
  ******************************************************************************/
 
 #include "drawarea.h"
+#include "scene.h"
 #include <QPainter>
 #include <QRectF>
 #include <QMouseEvent>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 /**
 * @brief Constructeur par défaut "explicite".
 * Relie le timeout du timer à la méthode animate sur le DrawArea
-* Définit aussi les colliders présent dès le départ
+* Définit aussi les colliders présent dès le départ et lance le thread de simulation
 */
 DrawArea::DrawArea(QWidget *parent)
-    : QOpenGLWidget{parent}, timer(new QTimer(this)) {
+    : QOpenGLWidget{parent}, timer(new QTimer(this)), simulation(context, 0.2, 0.02), adapter(new ContextAdapter(simulation,this)) {
     // On lie le timeout du timer à la méthode animate sur le DrawArea
     connect(timer, &QTimer::timeout, this, &DrawArea::animate);
-    timer->start(20);
+    timer->start(16);
+
+    // PBD_RENDER=painter revient au dessin d'une ellipse par particule
+    const char* render=std::getenv("PBD_RENDER");
+    if (render && std::strcmp(render,"painter")==0){batched_rendering=false;}
 
     // On peut ici initialiser des colliders dans l'environnement de la simulation
 
-    /*std::shared_ptr<collider> bordbas=std::make_shared<plancollider>(std::make_pair(this->width()/2, this->height()-100), this->width()/2, 0);
-    std::shared_ptr<collider> bordhaut=std::make_shared<plancollider>(std::make_pair(this->width()/2, 10), this->width()/2,M_PI);
-    std::shared_ptr<collider> bordgauche=std::make_shared<plancollider>(std::make_pair(10, this->height()/2), this->height()/2, -M_PI/2);
-    std::shared_ptr<collider> borddroit=std::make_shared<plancollider>(std::make_pair(this->width()-10, this->height()/2), this->height()/2, M_PI/2);
+    /*plancollider bordbas(std::make_pair(this->width()/2, this->height()-100), this->width()/2, 0);
+    plancollider bordhaut(std::make_pair(this->width()/2, 10), this->width()/2,M_PI);
+    plancollider bordgauche(std::make_pair(10, this->height()/2), this->height()/2, -M_PI/2);
+    plancollider borddroit(std::make_pair(this->width()-10, this->height()/2), this->height()/2, M_PI/2);
     context.addCollider(bordbas);
     context.addCollider(bordhaut);
     context.addCollider(bordgauche);
     context.addCollider(borddroit);*/
 
-    std::shared_ptr<collider> planCollider1_1=std::make_shared<plancollider>(std::make_pair(700.0, 80.0), 200.0, 0);
-    std::shared_ptr<collider> planCollider1_2=std::make_shared<plancollider>(std::make_pair(700.0, 100.0), 200.0, -M_PI);
-    std::shared_ptr<collider> planCollider1_3=std::make_shared<plancollider>(std::make_pair(500.0, 90.0), 10.0, M_PI/2);
-    std::shared_ptr<collider> planCollider1_4=std::make_shared<plancollider>(std::make_pair(900.0, 90.0), 10.0, -M_PI/2);
-    context.addCollider(planCollider1_1);
-    context.addCollider(planCollider1_2);
-    context.addCollider(planCollider1_3);
-    context.addCollider(planCollider1_4);
-
-
-    std::shared_ptr<collider> planCollider2_1=std::make_shared<plancollider>(std::make_pair(700.0, 140.0), 200.0, 0);
-    std::shared_ptr<collider> planCollider2_2=std::make_shared<plancollider>(std::make_pair(700.0, 150.0), 200.0, M_PI);
-    std::shared_ptr<collider> planCollider2_3=std::make_shared<plancollider>(std::make_pair(500.0, 145.0), 5.0, M_PI/2);
-    std::shared_ptr<collider> planCollider2_4=std::make_shared<plancollider>(std::make_pair(900.0, 145.0), 5.0, -M_PI/2);
-    context.addCollider(planCollider2_1);
-    context.addCollider(planCollider2_2);
-    context.addCollider(planCollider2_3);
-    context.addCollider(planCollider2_4);
-
-    std::shared_ptr<collider> planCollider3_1=std::make_shared<plancollider>(std::make_pair(100.0, 150.0), 100.0, -M_PI/8);
-    std::shared_ptr<collider> planCollider3_2=std::make_shared<plancollider>(std::make_pair(100.0, 188.27), 92.39, -M_PI);
-    context.addCollider(planCollider3_1);
-    context.addCollider(planCollider3_2);
-
-    std::shared_ptr<collider> sphereCollider1=std::make_shared<spherecollider>(std::make_pair(200.0, 50.0), 30.0);
-    std::shared_ptr<collider> sphereCollider2=std::make_shared<spherecollider>(std::make_pair(350.0, 150.0), 20.0);
-    std::shared_ptr<collider> sphereCollider3=std::make_shared<spherecollider>(std::make_pair(600, 200.0), 10.0);
-    context.addCollider(sphereCollider1);
-    context.addCollider(sphereCollider2);
-    context.addCollider(sphereCollider3);
+    // Etagères et sphères de la scène de démonstration (voir scene.cpp)
+    addDefaultColliders(context);
+
+    // PBD_SDF=<pas> lit les contacts statiques dans une grille de distances, calculée ici une fois pour toutes
+    if (const char* sdf=std::getenv("PBD_SDF")){
+        ColliderSDFSettings settings;
+        settings.enabled=true;
+        if (std::atof(sdf)>0){settings.cell_size=std::atof(sdf);}
+        context.setColliderSDF(settings);
+        context.bakeColliderSDF();
+    }
+
+    // PBD_CCD=1 arrête les particules rapides au premier impact au lieu de les laisser traverser les étagères
+    if (const char* ccd=std::getenv("PBD_CCD")){
+        CCDSettings settings;
+        settings.enabled=std::strcmp(ccd,"0")!=0;
+        context.setCCD(settings);
+    }
 
+    // PBD_SLEEP=1 endort les piles au repos (et passe en XPBD, voir SleepSettings); le bouton Sleep ON/OFF fait de même
+    if (const char* sleep=std::getenv("PBD_SLEEP")){
+        SleepSettings settings=context.sleepSettings();
+        settings.enabled=std::strcmp(sleep,"0")!=0;
+        context.setSleep(settings);
+    }
+
+    // Un pas de 0.2 toutes les 20 ms, comme l'ancien timer de 20 ms divisé par 100
+    simulation.start();
 }
 
 /**
-* @brief Actualise la représentation à l'aide du contexte
+* @brief Actualise la représentation à l'aide de la dernière copie publiée par le thread de simulation
 * @param e Un QPaintEvent pour dessiner les particules et les colliders, ainsi que les bords de la simulation
 */
 void DrawArea::paintEvent(QPaintEvent *e) {
     QPainter p(this);
+    const RenderSnapshot &snapshot=simulation.snapshot();
 
     // Dessin de l'écran (blancs) et de ses bords (verts)
     p.setPen(Qt::white);
@@ -89,35 +96,100 @@ void DrawArea::paintEvent(QPaintEvent *e) {
     QRectF borddroit(this->width()-10, 0, 10, this->height());
     p.drawRect(borddroit);
 
-    // Dessin des particules
-    p.setPen(Qt::yellow);
-    p.setBrush(QBrush(Qt::red));
-    for (const particle &particle : context.particles) {
-        QRectF target(particle.pos[0] - particle.radius, particle.pos[1] - particle.radius, 2 * particle.radius, 2 * particle.radius);
-        p.drawEllipse(target);
+    // Dessin des liens de distance, sous les particules
+    p.setPen(Qt::darkGray);
+    for (std::size_t k=0;k+1<snapshot.links.size();k+=2) {
+        std::uint32_t i=snapshot.links[k];
+        std::uint32_t j=snapshot.links[k+1];
+        p.drawLine(QPointF(snapshot.x[i], snapshot.y[i]), QPointF(snapshot.x[j], snapshot.y[j]));
+    }
+
+    // Dessin des particules, en ignorant celles qui sont hors de la fenêtre
+    QRectF view(0, 0, this->width(), this->height());
+    if (batched_rendering) {
+        paintParticlesBatched(p, snapshot, view);
+    } else {
+        paintParticlesEllipses(p, snapshot, view);
     }
 
     // Dessin des colliders
     p.setPen(Qt::blue);
     p.setBrush(QBrush(Qt::black));
 
-    for (const auto& colliderPtr : context.colliders) {
-        // std::dynamic_pointer_cast pour vérifier si le colliderPtr peut être cast en plancollider ou non
-        if (auto plan = std::dynamic_pointer_cast<plancollider>(colliderPtr)) {
-            // On trace la ligne entre les deux extrémités du plan
-            QPointF center(plan->origin.first, plan->origin.second);
-            QPointF normal(plan->normal[0], plan->normal[1]);
-            double distance = plan->length;
-            QPointF point1(center.x()+normal.y()*distance,center.y()-normal.x()*distance);
-            QPointF point2(center.x()-normal.y()*distance,center.y()+normal.x()*distance);
-            p.drawLine(point1, point2);
+    // Les colliders sont rangés par type: pas besoin de tester le type de chacun
+    for (const plancollider& plan : snapshot.colliders.planes) {
+        // On trace la ligne entre les deux extrémités du plan
+        QPointF center(plan.origin.first, plan.origin.second);
+        QPointF normal(plan.normal[0], plan.normal[1]);
+        double distance = plan.length;
+        QPointF point1(center.x()+normal.y()*distance,center.y()-normal.x()*distance);
+        QPointF point2(center.x()-normal.y()*distance,center.y()+normal.x()*distance);
+        p.drawLine(point1, point2);
+    }
+    for (const spherecollider& sphere : snapshot.colliders.spheres) {
+        // On trace un cercle représentant la sphère
+        QRectF sp(sphere.origin.first-sphere.radius,sphere.origin.second-sphere.radius,2*sphere.radius,2*sphere.radius);
+        p.drawEllipse(sp);
+    }
+}
+
+/**
+* @brief Particule pré-dessinée (bord jaune, intérieur rouge) d'un diamètre donné, créée au premier usage
+*/
+const QPixmap& DrawArea::sprite(int diameter) {
+    auto found = sprites.find(diameter);
+    if (found != sprites.end()) {
+        return found->second;
+    }
+    // Un pixel de marge pour le trait du bord
+    QPixmap pixmap(diameter + 2, diameter + 2);
+    pixmap.fill(Qt::transparent);
+    QPainter p(&pixmap);
+    p.setPen(Qt::yellow);
+    p.setBrush(QBrush(Qt::red));
+    p.drawEllipse(QRectF(1, 1, diameter, diameter));
+    p.end();
+    return sprites.emplace(diameter, pixmap).first->second;
+}
+
+/**
+* @brief Dessine les particules visibles par lots, un appel à drawPixmapFragments par diamètre
+*/
+void DrawArea::paintParticlesBatched(QPainter &p, const RenderSnapshot &snapshot, const QRectF &view) {
+    for (auto &bucket : fragments) {
+        bucket.second.clear();
+    }
+    for (std::size_t i=0;i<snapshot.x.size();i++) {
+        double x=snapshot.x[i];
+        double y=snapshot.y[i];
+        double r=snapshot.radius[i];
+        if (x + r < view.left() || x - r > view.right() || y + r < view.top() || y - r > view.bottom()) {
+            continue;
+        }
+        int diameter = std::max(1, (int)std::lround(2 * r));
+        // La position d'un fragment est celle de son centre
+        fragments[diameter].push_back(QPainter::PixmapFragment::create(QPointF(x, y), QRectF(0, 0, diameter + 2, diameter + 2)));
+    }
+    for (const auto &bucket : fragments) {
+        if (!bucket.second.empty()) {
+            p.drawPixmapFragments(bucket.second.data(), (int)bucket.second.size(), sprite(bucket.first));
         }
-        // std::dynamic_pointer_cast pour vérifier si le colliderPtr peut être cast en spherecollider ou non
-        else if (auto sphere = std::dynamic_pointer_cast<spherecollider>(colliderPtr)) {
-            // On trace un cercle représentant la sphère
-            QRectF sp(sphere->origin.first-sphere->radius,sphere->origin.second-sphere->radius,2*sphere->radius,2*sphere->radius);
-            p.drawEllipse(sp);
+    }
+}
+
+/**
+* @brief Dessine les particules visibles une à une avec drawEllipse (chemin de secours)
+*/
+void DrawArea::paintParticlesEllipses(QPainter &p, const RenderSnapshot &snapshot, const QRectF &view) {
+    p.setPen(Qt::yellow);
+    p.setBrush(QBrush(Qt::red));
+    for (std::size_t i=0;i<snapshot.x.size();i++) {
+        double r=snapshot.radius[i];
+        QRectF target(snapshot.x[i] - r, snapshot.y[i] - r, 2 * r, 2 * r);
+        if (!view.intersects(target)) {
+            continue;
         }
+        p.drawEllipse(target);
     }
 }
 
@@ -129,25 +201,27 @@ void DrawArea::mouseDoubleClickEvent(QMouseEvent *event) {
     particle newParticle;
     // On récupère la position de la souris
     newParticle.pos={(double)event->position().x(),(double)event->position().y()};
-    newParticle.future_pos={0,0};
     newParticle.velocity={30,-40};
-    newParticle.future_velocity={0,0};
     newParticle.radius=radius;
     newParticle.mass=2;
-    context.particles.push_back(newParticle);
 
     // On définit quelques caractéristiquees de la simulation ici, à chaque clic pour s'adapter à des variations de la fenêtre de simulation par l'utilisateur
-    context.width=this->width();
-    context.height=this->height();
+    int width=this->width();
+    int height=this->height();
+    // Le contexte appartient au thread de simulation: l'ajout lui est transmis par sa file de commandes
+    simulation.post([newParticle,width,height](Context& context){
+        context.particles.add(newParticle);
+        context.width=width;
+        context.height=height;
+    });
     // Méthode magique qui fait que toutes les méthodes se relancent
     update();
 }
 
 /**
-* @brief Actualise le contexte après un certain pas de temps à l'aide de la méthode updatePhysicalSystem de Context.h
+* @brief Redemande un affichage; la simulation avance de son côté sur son propre thread
 */
 void DrawArea::animate(){
-    context.updatePhysicalSystem(((double) timer->interval())/100);
     // Méthode magique qui fait que toutes les méthodes se relancent
     update();
 }
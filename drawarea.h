@@ -12,7 +12,13 @@
 #include <QtOpenGLWidgets/qopenglwidget.h>
 #include <QWidget>
 #include <QTimer>
+#include <QPainter>
+#include <QPixmap>
+#include <unordered_map>
+#include <vector>
 #include "Context.h"
+#include "contextadapter.h"
+#include "simulationthread.h"
 
 /**
  * @class DrawArea
@@ -25,20 +31,46 @@ class DrawArea : public QOpenGLWidget {
 
 private:
     double radius=10; /**< Rayon des particules ajoutées */
-    QTimer *timer;    /**< Timer pour le pas de temps */
+    QTimer *timer;    /**< Timer de rafraîchissement de l'affichage */
+    bool batched_rendering=true; /**< Particules dessinées par lots de sprites (drawPixmapFragments) plutôt qu'une ellipse à la fois */
+    std::unordered_map<int,QPixmap> sprites; /**< Particule pré-dessinée, pour chaque diamètre arrondi au pixel */
+    std::unordered_map<int,std::vector<QPainter::PixmapFragment>> fragments; /**< Particules visibles de chaque diamètre, réutilisées d'une image à l'autre */
+
+    /**
+     * @brief Particule pré-dessinée (bord jaune, intérieur rouge) d'un diamètre donné, créée au premier usage
+     */
+    const QPixmap& sprite(int diameter);
+
+    /**
+     * @brief Dessine les particules visibles par lots, un appel à drawPixmapFragments par diamètre
+     */
+    void paintParticlesBatched(QPainter &p,const RenderSnapshot &snapshot,const QRectF &view);
+
+    /**
+     * @brief Dessine les particules visibles une à une avec drawEllipse (chemin de secours)
+     */
+    void paintParticlesEllipses(QPainter &p,const RenderSnapshot &snapshot,const QRectF &view);
 
 public:
-    Context context=Context(); /**< Contexte de la simulation*/
+    Context context; /**< Contexte de la simulation, utilisé par le thread de simulation une fois celui-ci lancé*/
+    SimulationThread simulation; /**< Thread faisant avancer le contexte, dont on affiche les copies publiées*/
+    ContextAdapter *adapter; /**< Slots Qt pilotant le contexte, pour les boutons de l'interface*/
 
     /**
     * @brief Constructeur par défaut "explicite".
     * Relie le timeout du timer à la méthode animate sur le DrawArea
-    * Définit aussi les colliders présent dès le départ
+    * Définit aussi les colliders présent dès le départ et lance le thread de simulation
     */
     explicit DrawArea(QWidget *parent = nullptr);
 
     /**
-     * @brief Actualise la représentation à l'aide du contexte
+     * @brief Choisit le dessin des particules.
+     * @param batched true pour les lots de sprites (par défaut), false pour une ellipse par particule.
+     */
+    void setBatchedRendering(bool batched){batched_rendering=batched;}
+
+    /**
+     * @brief Actualise la représentation à l'aide de la dernière copie publiée par le thread de simulation
      * @param e Un QPaintEvent pour dessiner les particules et les colliders, ainsi que les bords de la simulation
      */
     void paintEvent(QPaintEvent *e) override;
@@ -50,7 +82,7 @@ public:
     void mouseDoubleClickEvent(QMouseEvent *event) override;
 
     /**
-     * @brief Actualise le contexte après un certain pas de temps à l'aide de la méthode updatePhysicalSystem de Context.h
+     * @brief Redemande un affichage; la simulation avance de son côté sur son propre thread
      */
     void animate();
 
@@ -0,0 +1,84 @@
+/******************************************************************************
+ * @file hash64.h
+ * @brief Définition de la classe Hash64, une empreinte 64 bits rapide (non cryptographique).
+ *
+ * Utilisée pour la somme de contrôle des points de reprise (checkpoint.cpp) et pour l'empreinte
+ * de l'état de la simulation (Context::stateHash). Le résultat ne dépend que de la suite d'octets
+ * ajoutés, pas de la façon dont elle est découpée entre les appels à add().
+ ******************************************************************************/
+
+#ifndef HASH64_H
+#define HASH64_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * @class Hash64
+ * @brief Empreinte 64 bits sur quatre voies indépendantes (8 octets par voie et par tour),
+ * pour suivre le débit de la mémoire sur de gros tableaux.
+ */
+class Hash64 {
+private:
+    static constexpr std::uint64_t prime1=0x9E3779B185EBCA87ull;
+    static constexpr std::uint64_t prime2=0xC2B2AE3D27D4EB4Full;
+    std::uint64_t lanes[4]={prime1,prime2,0,~prime1};
+    unsigned char carry[32]; /**< Octets en attente d'un tour complet */
+    std::size_t carry_size=0;
+    std::uint64_t total=0;
+
+    static std::uint64_t rotl(std::uint64_t v,int r){return (v<<r)|(v>>(64-r));}
+
+    void round(const unsigned char* p){
+        for (int l=0;l<4;l++){
+            std::uint64_t w;
+            std::memcpy(&w,p+8*l,8);
+            lanes[l]=rotl(lanes[l]+w*prime2,31)*prime1;
+        }
+    }
+
+public:
+    /**
+     * @brief Ajoute des octets à l'empreinte.
+     */
+    void add(const void* data,std::size_t bytes){
+        const unsigned char* p=static_cast<const unsigned char*>(data);
+        total+=bytes;
+        if (carry_size>0){
+            std::size_t take=std::min(bytes,32-carry_size);
+            std::memcpy(carry+carry_size,p,take);
+            carry_size+=take;
+            p+=take;
+            bytes-=take;
+            if (carry_size<32){return;}
+            round(carry);
+            carry_size=0;
+        }
+        for (;bytes>=32;p+=32,bytes-=32){round(p);}
+        std::memcpy(carry,p,bytes);
+        carry_size=bytes;
+    }
+
+    /**
+     * @brief Ajoute la représentation binaire d'une valeur.
+     */
+    template <class T>
+    void addValue(const T& value){add(&value,sizeof(T));}
+
+    /**
+     * @brief Empreinte des octets ajoutés jusqu'ici.
+     */
+    std::uint64_t result() const{
+        std::uint64_t h=rotl(lanes[0],1)+rotl(lanes[1],7)+rotl(lanes[2],12)+rotl(lanes[3],18);
+        for (std::size_t k=0;k<carry_size;k++){h=(h^carry[k])*prime1;}
+        h^=total;
+        h^=h>>33;
+        h*=prime2;
+        h^=h>>29;
+        return h;
+    }
+};
+
+#endif // HASH64_H
@@ -0,0 +1,87 @@
+/******************************************************************************
+ * @file kernels.cpp
+ * @brief Choix à l'exécution du jeu d'instructions des fonctions de kernels.h
+ ******************************************************************************/
+
+#include "kernels.h"
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+extern const StageKernels stage_kernels_scalar;
+extern const StageKernelsF stage_kernels_scalar_f;
+#ifdef PBD_X86_KERNELS
+extern const StageKernels stage_kernels_sse2;
+extern const StageKernels stage_kernels_avx2;
+extern const StageKernels stage_kernels_avx512;
+extern const StageKernelsF stage_kernels_sse2_f;
+extern const StageKernelsF stage_kernels_avx2_f;
+extern const StageKernelsF stage_kernels_avx512_f;
+#endif
+
+/**
+ * @struct KernelTables
+ * @brief Tables compilées pour une précision donnée (nullptr pour un jeu d'instructions non compilé).
+ */
+template <class Real>
+struct KernelTables {
+    const BasicStageKernels<Real>* scalar;
+    const BasicStageKernels<Real>* sse2;
+    const BasicStageKernels<Real>* avx2;
+    const BasicStageKernels<Real>* avx512;
+};
+
+#ifdef PBD_X86_KERNELS
+static const KernelTables<double> tables_double={&stage_kernels_scalar,&stage_kernels_sse2,&stage_kernels_avx2,&stage_kernels_avx512};
+static const KernelTables<float> tables_float={&stage_kernels_scalar_f,&stage_kernels_sse2_f,&stage_kernels_avx2_f,&stage_kernels_avx512_f};
+#else
+static const KernelTables<double> tables_double={&stage_kernels_scalar,nullptr,nullptr,nullptr};
+static const KernelTables<float> tables_float={&stage_kernels_scalar_f,nullptr,nullptr,nullptr};
+#endif
+
+template <class Real> static const KernelTables<Real>& tables();
+template <> const KernelTables<double>& tables<double>(){return tables_double;}
+template <> const KernelTables<float>& tables<float>(){return tables_float;}
+
+template <class Real>
+const BasicStageKernels<Real>* stageKernelsFor(const char* name){
+    const KernelTables<Real>& t=tables<Real>();
+    if (std::strcmp(name,"scalar")==0){return t.scalar;}
+#ifdef PBD_X86_KERNELS
+    // Les fichiers SSE2, AVX2 et AVX-512 ne sont compilés que pour x86 avec GCC ou Clang (voir CMakeLists.txt)
+    __builtin_cpu_init();
+    if (std::strcmp(name,"sse2")==0 && __builtin_cpu_supports("sse2")){return t.sse2;}
+    if (std::strcmp(name,"avx2")==0 && __builtin_cpu_supports("avx2")){return t.avx2;}
+    if (std::strcmp(name,"avx512")==0 && __builtin_cpu_supports("avx512f")){return t.avx512;}
+#endif
+    return nullptr;
+}
+
+/**
+* @brief Meilleur jeu d'instructions disponible, ou celui imposé par PBD_SIMD
+*/
+template <class Real>
+static const BasicStageKernels<Real>& selectKernels(){
+    const char* forced=std::getenv("PBD_SIMD");
+    if (forced){
+        if (const BasicStageKernels<Real>* kernels=stageKernelsFor<Real>(forced)){return *kernels;}
+    }
+    // AVX2 passe avant AVX-512: sur les grands ensembles, limités par la mémoire, l'AVX-512
+    // n'est pas plus rapide (voir bench_kernels) et peut faire baisser la fréquence du processeur
+    for (const char* name:{"avx2","avx512","sse2"}){
+        if (const BasicStageKernels<Real>* kernels=stageKernelsFor<Real>(name)){return *kernels;}
+    }
+    return *tables<Real>().scalar;
+}
+
+template <class Real>
+const BasicStageKernels<Real>& stageKernels(){
+    // Choix fait une seule fois par précision, au premier appel
+    static const BasicStageKernels<Real>& kernels=selectKernels<Real>();
+    return kernels;
+}
+
+template const StageKernels& stageKernels<double>();
+template const StageKernelsF& stageKernels<float>();
+template const StageKernels* stageKernelsFor<double>(const char*);
+template const StageKernelsF* stageKernelsFor<float>(const char*);
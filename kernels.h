@@ -0,0 +1,76 @@
+/******************************************************************************
+ * @file kernels.h
+ * @brief Fonctions de calcul vectorisées (SIMD) des étapes d'intégration de Context.
+ *
+ * Chaque jeu d'instructions (scalaire, SSE2, AVX2, AVX-512) est compilé dans son propre
+ * fichier à partir du même code (kernels_impl.h). Le jeu utilisé est choisi à l'exécution
+ * selon le processeur. Toutes les versions font les mêmes opérations dans le même ordre
+ * (sans FMA): elles donnent exactement les mêmes résultats.
+ * Chaque fonction existe en double et en float (deux fois plus de réels par instruction).
+ ******************************************************************************/
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <cstddef>
+
+/**
+ * @struct BasicStageKernels
+ * @brief Table des fonctions d'intégration pour un jeu d'instructions et une précision (Real) donnés.
+ *
+ * Les tableaux ne doivent pas se chevaucher, sauf mention contraire.
+ */
+template <class Real>
+struct BasicStageKernels {
+    const char* name; /**< Nom du jeu d'instructions ("scalar", "sse2", "avx2", "avx512"). */
+
+    /**
+     * @brief v+=g (applyExternalForce), g étant le champ de force multiplié par dt.
+     */
+    void (*applyForce)(Real* vx,Real* vy,std::size_t n,Real gx,Real gy);
+
+    /**
+     * @brief p=x+v*dt (updateExpectedPosition).
+     */
+    void (*predict)(const Real* x,const Real* y,const Real* vx,const Real* vy,Real* px,Real* py,std::size_t n,Real dt);
+
+    /**
+     * @brief Les deux étapes précédentes en une seule passe: v+=g puis p=x+v*dt.
+     */
+    void (*applyForceAndPredict)(const Real* x,const Real* y,Real* vx,Real* vy,Real* px,Real* py,std::size_t n,Real gx,Real gy,Real dt);
+
+    /**
+     * @brief v-=alpha*v (applyFriction).
+     */
+    void (*damp)(Real* vx,Real* vy,std::size_t n,Real alpha);
+
+    /**
+     * @brief x=p (updateVelocityAndPosition).
+     */
+    void (*commit)(Real* x,Real* y,const Real* px,const Real* py,std::size_t n);
+
+    /**
+     * @brief Les deux étapes précédentes en une seule passe: v-=alpha*v puis x=p.
+     */
+    void (*dampAndCommit)(Real* x,Real* y,const Real* px,const Real* py,Real* vx,Real* vy,std::size_t n,Real alpha);
+};
+
+using StageKernels=BasicStageKernels<double>;
+using StageKernelsF=BasicStageKernels<float>;
+
+/**
+ * @brief Fonctions du meilleur jeu d'instructions disponible sur ce processeur, en double par défaut.
+ * La variable d'environnement PBD_SIMD (scalar, sse2, avx2, avx512) permet d'imposer un jeu d'instructions.
+ */
+template <class Real=double>
+const BasicStageKernels<Real>& stageKernels();
+
+/**
+ * @brief Fonctions d'un jeu d'instructions donné, en double par défaut.
+ * @param name Nom du jeu d'instructions.
+ * @return nullptr si ce jeu n'est pas compilé ou pas supporté par ce processeur.
+ */
+template <class Real=double>
+const BasicStageKernels<Real>* stageKernelsFor(const char* name);
+
+#endif // KERNELS_H
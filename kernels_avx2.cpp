@@ -0,0 +1,9 @@
+/******************************************************************************
+ * @file kernels_avx2.cpp
+ * @brief Fonctions de kernels.h en AVX2 (4 doubles ou 8 floats par instruction), compilé avec -mavx2
+ ******************************************************************************/
+
+#define PBD_KERNELS_TABLE stage_kernels_avx2
+#define PBD_KERNELS_TABLE_F stage_kernels_avx2_f
+#define PBD_KERNELS_NAME "avx2"
+#include "kernels_impl.h"
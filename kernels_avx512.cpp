@@ -0,0 +1,9 @@
+/******************************************************************************
+ * @file kernels_avx512.cpp
+ * @brief Fonctions de kernels.h en AVX-512 (8 doubles ou 16 floats par instruction), compilé avec -mavx512f
+ ******************************************************************************/
+
+#define PBD_KERNELS_TABLE stage_kernels_avx512
+#define PBD_KERNELS_TABLE_F stage_kernels_avx512_f
+#define PBD_KERNELS_NAME "avx512"
+#include "kernels_impl.h"
@@ -0,0 +1,209 @@
+/******************************************************************************
+ * @file kernels_impl.h
+ * @brief Code commun des fonctions de kernels.h, inclus par chaque fichier kernels_<isa>.cpp.
+ *
+ * Le fichier qui l'inclut définit PBD_KERNELS_TABLE et PBD_KERNELS_TABLE_F (noms des tables en double
+ * et en float à définir) et PBD_KERNELS_NAME. La largeur des vecteurs dépend des options de compilation
+ * de ce fichier (__AVX512F__, __AVX2__, __SSE2__), ou est forcée à 1 par PBD_KERNELS_SCALAR; elle est
+ * deux fois plus grande en float qu'en double.
+ ******************************************************************************/
+
+#include "kernels.h"
+
+#if !defined(PBD_KERNELS_SCALAR) && (defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE2__))
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/**
+ * @struct Simd
+ * @brief Type des vecteurs et nombre de réels par vecteur pour une précision donnée.
+ * Les opérations (load, store, set1, add, sub, mul) sont surchargées pour chacun des deux types de vecteurs.
+ */
+template <class Real> struct Simd;
+
+#if !defined(PBD_KERNELS_SCALAR) && defined(__AVX512F__)
+template <> struct Simd<double> {typedef __m512d vec; static const std::size_t width=8;};
+template <> struct Simd<float> {typedef __m512 vec; static const std::size_t width=16;};
+inline __m512d load(const double* p){return _mm512_loadu_pd(p);}
+inline void store(double* p,__m512d v){_mm512_storeu_pd(p,v);}
+inline __m512d set1(double a){return _mm512_set1_pd(a);}
+inline __m512d add(__m512d a,__m512d b){return _mm512_add_pd(a,b);}
+inline __m512d sub(__m512d a,__m512d b){return _mm512_sub_pd(a,b);}
+inline __m512d mul(__m512d a,__m512d b){return _mm512_mul_pd(a,b);}
+inline __m512 load(const float* p){return _mm512_loadu_ps(p);}
+inline void store(float* p,__m512 v){_mm512_storeu_ps(p,v);}
+inline __m512 set1(float a){return _mm512_set1_ps(a);}
+inline __m512 add(__m512 a,__m512 b){return _mm512_add_ps(a,b);}
+inline __m512 sub(__m512 a,__m512 b){return _mm512_sub_ps(a,b);}
+inline __m512 mul(__m512 a,__m512 b){return _mm512_mul_ps(a,b);}
+#elif !defined(PBD_KERNELS_SCALAR) && defined(__AVX2__)
+template <> struct Simd<double> {typedef __m256d vec; static const std::size_t width=4;};
+template <> struct Simd<float> {typedef __m256 vec; static const std::size_t width=8;};
+inline __m256d load(const double* p){return _mm256_loadu_pd(p);}
+inline void store(double* p,__m256d v){_mm256_storeu_pd(p,v);}
+inline __m256d set1(double a){return _mm256_set1_pd(a);}
+inline __m256d add(__m256d a,__m256d b){return _mm256_add_pd(a,b);}
+inline __m256d sub(__m256d a,__m256d b){return _mm256_sub_pd(a,b);}
+inline __m256d mul(__m256d a,__m256d b){return _mm256_mul_pd(a,b);}
+inline __m256 load(const float* p){return _mm256_loadu_ps(p);}
+inline void store(float* p,__m256 v){_mm256_storeu_ps(p,v);}
+inline __m256 set1(float a){return _mm256_set1_ps(a);}
+inline __m256 add(__m256 a,__m256 b){return _mm256_add_ps(a,b);}
+inline __m256 sub(__m256 a,__m256 b){return _mm256_sub_ps(a,b);}
+inline __m256 mul(__m256 a,__m256 b){return _mm256_mul_ps(a,b);}
+#elif !defined(PBD_KERNELS_SCALAR) && defined(__SSE2__)
+template <> struct Simd<double> {typedef __m128d vec; static const std::size_t width=2;};
+template <> struct Simd<float> {typedef __m128 vec; static const std::size_t width=4;};
+inline __m128d load(const double* p){return _mm_loadu_pd(p);}
+inline void store(double* p,__m128d v){_mm_storeu_pd(p,v);}
+inline __m128d set1(double a){return _mm_set1_pd(a);}
+inline __m128d add(__m128d a,__m128d b){return _mm_add_pd(a,b);}
+inline __m128d sub(__m128d a,__m128d b){return _mm_sub_pd(a,b);}
+inline __m128d mul(__m128d a,__m128d b){return _mm_mul_pd(a,b);}
+inline __m128 load(const float* p){return _mm_loadu_ps(p);}
+inline void store(float* p,__m128 v){_mm_storeu_ps(p,v);}
+inline __m128 set1(float a){return _mm_set1_ps(a);}
+inline __m128 add(__m128 a,__m128 b){return _mm_add_ps(a,b);}
+inline __m128 sub(__m128 a,__m128 b){return _mm_sub_ps(a,b);}
+inline __m128 mul(__m128 a,__m128 b){return _mm_mul_ps(a,b);}
+#else
+template <class Real> struct Simd {typedef Real vec; static const std::size_t width=1;};
+template <class Real> inline Real load(const Real* p){return *p;}
+template <class Real> inline void store(Real* p,Real v){*p=v;}
+template <class Real> inline Real set1(Real a){return a;}
+template <class Real> inline Real add(Real a,Real b){return a+b;}
+template <class Real> inline Real sub(Real a,Real b){return a-b;}
+template <class Real> inline Real mul(Real a,Real b){return a*b;}
+#endif
+
+// Chaque boucle traite width particules à la fois, puis les dernières une par une.
+// Les opérations scalaires de fin de boucle sont écrites comme les opérations vectorielles
+// (une multiplication puis une addition) pour donner les mêmes arrondis.
+
+template <class Real>
+void applyForce(Real* vx,Real* vy,std::size_t n,Real gx,Real gy){
+    typedef typename Simd<Real>::vec vec;
+    const std::size_t width=Simd<Real>::width;
+    const vec vgx=set1(gx);
+    const vec vgy=set1(gy);
+    std::size_t i=0;
+    for (;i+width<=n;i+=width){
+        store(vx+i,add(load(vx+i),vgx));
+        store(vy+i,add(load(vy+i),vgy));
+    }
+    for (;i<n;i++){
+        vx[i]+=gx;
+        vy[i]+=gy;
+    }
+}
+
+template <class Real>
+void predict(const Real* x,const Real* y,const Real* vx,const Real* vy,Real* px,Real* py,std::size_t n,Real dt){
+    typedef typename Simd<Real>::vec vec;
+    const std::size_t width=Simd<Real>::width;
+    const vec vdt=set1(dt);
+    std::size_t i=0;
+    for (;i+width<=n;i+=width){
+        store(px+i,add(load(x+i),mul(load(vx+i),vdt)));
+        store(py+i,add(load(y+i),mul(load(vy+i),vdt)));
+    }
+    for (;i<n;i++){
+        Real dx=vx[i]*dt;
+        Real dy=vy[i]*dt;
+        px[i]=x[i]+dx;
+        py[i]=y[i]+dy;
+    }
+}
+
+template <class Real>
+void applyForceAndPredict(const Real* x,const Real* y,Real* vx,Real* vy,Real* px,Real* py,std::size_t n,Real gx,Real gy,Real dt){
+    typedef typename Simd<Real>::vec vec;
+    const std::size_t width=Simd<Real>::width;
+    const vec vgx=set1(gx);
+    const vec vgy=set1(gy);
+    const vec vdt=set1(dt);
+    std::size_t i=0;
+    for (;i+width<=n;i+=width){
+        vec nvx=add(load(vx+i),vgx);
+        vec nvy=add(load(vy+i),vgy);
+        store(vx+i,nvx);
+        store(vy+i,nvy);
+        store(px+i,add(load(x+i),mul(nvx,vdt)));
+        store(py+i,add(load(y+i),mul(nvy,vdt)));
+    }
+    for (;i<n;i++){
+        vx[i]+=gx;
+        vy[i]+=gy;
+        Real dx=vx[i]*dt;
+        Real dy=vy[i]*dt;
+        px[i]=x[i]+dx;
+        py[i]=y[i]+dy;
+    }
+}
+
+template <class Real>
+void damp(Real* vx,Real* vy,std::size_t n,Real alpha){
+    typedef typename Simd<Real>::vec vec;
+    const std::size_t width=Simd<Real>::width;
+    const vec va=set1(alpha);
+    std::size_t i=0;
+    for (;i+width<=n;i+=width){
+        vec a=load(vx+i);
+        vec b=load(vy+i);
+        store(vx+i,sub(a,mul(va,a)));
+        store(vy+i,sub(b,mul(va,b)));
+    }
+    for (;i<n;i++){
+        Real fx=alpha*vx[i];
+        Real fy=alpha*vy[i];
+        vx[i]-=fx;
+        vy[i]-=fy;
+    }
+}
+
+template <class Real>
+void commit(Real* x,Real* y,const Real* px,const Real* py,std::size_t n){
+    const std::size_t width=Simd<Real>::width;
+    std::size_t i=0;
+    for (;i+width<=n;i+=width){
+        store(x+i,load(px+i));
+        store(y+i,load(py+i));
+    }
+    for (;i<n;i++){
+        x[i]=px[i];
+        y[i]=py[i];
+    }
+}
+
+template <class Real>
+void dampAndCommit(Real* x,Real* y,const Real* px,const Real* py,Real* vx,Real* vy,std::size_t n,Real alpha){
+    typedef typename Simd<Real>::vec vec;
+    const std::size_t width=Simd<Real>::width;
+    const vec va=set1(alpha);
+    std::size_t i=0;
+    for (;i+width<=n;i+=width){
+        vec a=load(vx+i);
+        vec b=load(vy+i);
+        store(vx+i,sub(a,mul(va,a)));
+        store(vy+i,sub(b,mul(va,b)));
+        store(x+i,load(px+i));
+        store(y+i,load(py+i));
+    }
+    for (;i<n;i++){
+        Real fx=alpha*vx[i];
+        Real fy=alpha*vy[i];
+        vx[i]-=fx;
+        vy[i]-=fy;
+        x[i]=px[i];
+        y[i]=py[i];
+    }
+}
+
+} // namespace
+
+extern const StageKernels PBD_KERNELS_TABLE={PBD_KERNELS_NAME,applyForce<double>,predict<double>,applyForceAndPredict<double>,
+                                             damp<double>,commit<double>,dampAndCommit<double>};
+extern const StageKernelsF PBD_KERNELS_TABLE_F={PBD_KERNELS_NAME,applyForce<float>,predict<float>,applyForceAndPredict<float>,
+                                               damp<float>,commit<float>,dampAndCommit<float>};
@@ -0,0 +1,10 @@
+/******************************************************************************
+ * @file kernels_scalar.cpp
+ * @brief Fonctions de kernels.h sans instructions vectorielles, disponibles sur tous les processeurs
+ ******************************************************************************/
+
+#define PBD_KERNELS_SCALAR
+#define PBD_KERNELS_TABLE stage_kernels_scalar
+#define PBD_KERNELS_TABLE_F stage_kernels_scalar_f
+#define PBD_KERNELS_NAME "scalar"
+#include "kernels_impl.h"
@@ -0,0 +1,9 @@
+/******************************************************************************
+ * @file kernels_sse2.cpp
+ * @brief Fonctions de kernels.h en SSE2 (2 doubles ou 4 floats par instruction), compilé avec -msse2
+ ******************************************************************************/
+
+#define PBD_KERNELS_TABLE stage_kernels_sse2
+#define PBD_KERNELS_TABLE_F stage_kernels_sse2_f
+#define PBD_KERNELS_NAME "sse2"
+#include "kernels_impl.h"
@@ -20,9 +20,10 @@ MainWindow::MainWindow(QWidget *parent)
     this->draw_area = new DrawArea();
     ui->verticalLayout->addWidget(draw_area);
 
-    QObject::connect(ui->resetButton, &QPushButton::pressed, &draw_area->context, &Context::resetSimulation);
-    QObject::connect(ui->frictionButton, &QPushButton::pressed, &draw_area->context, &Context::frictionTrigger);
-    QObject::connect(ui->gravityButton, &QPushButton::pressed, &draw_area->context, &Context::gravityChange);
+    QObject::connect(ui->resetButton, &QPushButton::pressed, draw_area->adapter, &ContextAdapter::resetSimulation);
+    QObject::connect(ui->frictionButton, &QPushButton::pressed, draw_area->adapter, &ContextAdapter::frictionTrigger);
+    QObject::connect(ui->sleepButton, &QPushButton::pressed, draw_area->adapter, &ContextAdapter::sleepTrigger);
+    QObject::connect(ui->gravityButton, &QPushButton::pressed, draw_area->adapter, &ContextAdapter::gravityChange);
 
 }
 
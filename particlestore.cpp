@@ -0,0 +1,150 @@
+/******************************************************************************
+ * @file particlestore.cpp
+ * @brief Implémentation des méthodes de la classe BasicParticleStore définies dans particlestore.h,
+ * instanciée en float et en double
+ ******************************************************************************/
+
+#include "particlestore.h"
+#include <utility>
+
+template <class Real>
+void BasicParticleStore<Real>::reserve(std::size_t n){
+    x.reserve(n);
+    y.reserve(n);
+    px.reserve(n);
+    py.reserve(n);
+    vx.reserve(n);
+    vy.reserve(n);
+    radius.reserve(n);
+    inv_mass.reserve(n);
+    rest_frames.reserve(n);
+    rest_x.reserve(n);
+    rest_y.reserve(n);
+    index_slot.reserve(n);
+    slot_index.reserve(n);
+    slot_generation.reserve(n);
+}
+
+template <class Real>
+ParticleHandle BasicParticleStore<Real>::add(const basic_particle<Real>& p){
+    std::uint32_t index=static_cast<std::uint32_t>(size());
+    x.push_back(p.pos[0]);
+    y.push_back(p.pos[1]);
+    px.push_back(p.pos[0]);
+    py.push_back(p.pos[1]);
+    vx.push_back(p.velocity[0]);
+    vy.push_back(p.velocity[1]);
+    radius.push_back(p.radius);
+    inv_mass.push_back(p.mass>0?1/p.mass:0);
+    rest_frames.push_back(0);
+    rest_x.push_back(p.pos[0]);
+    rest_y.push_back(p.pos[1]);
+    revision_count++;
+
+    // On réutilise un emplacement libéré s'il en existe un
+    std::uint32_t slot;
+    if (!free_slots.empty()){
+        slot=free_slots.back();
+        free_slots.pop_back();
+        slot_index[slot]=index;
+    }else{
+        slot=static_cast<std::uint32_t>(slot_index.size());
+        slot_index.push_back(index);
+        slot_generation.push_back(0);
+    }
+    index_slot.push_back(slot);
+    return {slot,slot_generation[slot]};
+}
+
+template <class Real>
+bool BasicParticleStore<Real>::valid(ParticleHandle h) const{
+    return h.id<slot_index.size() && slot_generation[h.id]==h.generation && slot_index[h.id]!=UINT32_MAX;
+}
+
+template <class Real>
+bool BasicParticleStore<Real>::remove(ParticleHandle h){
+    if (!valid(h)){return false;}
+    std::size_t i=slot_index[h.id];
+    std::size_t last=size()-1;
+
+    // La dernière particule prend la place de la particule supprimée
+    if (i!=last){
+        x[i]=x[last];
+        y[i]=y[last];
+        px[i]=px[last];
+        py[i]=py[last];
+        vx[i]=vx[last];
+        vy[i]=vy[last];
+        radius[i]=radius[last];
+        inv_mass[i]=inv_mass[last];
+        rest_frames[i]=rest_frames[last];
+        rest_x[i]=rest_x[last];
+        rest_y[i]=rest_y[last];
+        index_slot[i]=index_slot[last];
+        slot_index[index_slot[i]]=static_cast<std::uint32_t>(i);
+    }
+    x.pop_back();
+    y.pop_back();
+    px.pop_back();
+    py.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    radius.pop_back();
+    inv_mass.pop_back();
+    rest_frames.pop_back();
+    rest_x.pop_back();
+    rest_y.pop_back();
+    index_slot.pop_back();
+    revision_count++;
+
+    // L'emplacement change de génération: les anciennes poignées deviennent invalides
+    slot_index[h.id]=UINT32_MAX;
+    slot_generation[h.id]++;
+    free_slots.push_back(h.id);
+    return true;
+}
+
+template <class Real>
+void BasicParticleStore<Real>::swap(std::size_t i,std::size_t j){
+    if (i==j){return;}
+    std::swap(x[i],x[j]);
+    std::swap(y[i],y[j]);
+    std::swap(px[i],px[j]);
+    std::swap(py[i],py[j]);
+    std::swap(vx[i],vx[j]);
+    std::swap(vy[i],vy[j]);
+    std::swap(radius[i],radius[j]);
+    std::swap(inv_mass[i],inv_mass[j]);
+    std::swap(rest_frames[i],rest_frames[j]);
+    std::swap(rest_x[i],rest_x[j]);
+    std::swap(rest_y[i],rest_y[j]);
+    std::swap(index_slot[i],index_slot[j]);
+    slot_index[index_slot[i]]=static_cast<std::uint32_t>(i);
+    slot_index[index_slot[j]]=static_cast<std::uint32_t>(j);
+}
+
+template <class Real>
+void BasicParticleStore<Real>::clear(){
+    x.clear();
+    y.clear();
+    px.clear();
+    py.clear();
+    vx.clear();
+    vy.clear();
+    radius.clear();
+    inv_mass.clear();
+    rest_frames.clear();
+    rest_x.clear();
+    rest_y.clear();
+    index_slot.clear();
+    revision_count++;
+    free_slots.clear();
+    for (std::uint32_t slot=0;slot<slot_index.size();slot++){
+        slot_index[slot]=UINT32_MAX;
+        slot_generation[slot]++;
+        free_slots.push_back(slot);
+    }
+}
+
+template class BasicParticleStore<float>;
+template class BasicParticleStore<double>;
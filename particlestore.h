@@ -0,0 +1,155 @@
+/******************************************************************************
+ * @file particlestore.h
+ * @brief Définition de la classe ParticleStore qui stocke les particules en
+ * structure de tableaux (SoA).
+ *
+ * Chaque grandeur (position, position future, vitesse, rayon, inverse de la masse)
+ * est rangée dans son propre tableau contigu: les boucles d'intégration de Context
+ * parcourent ainsi la mémoire linéairement, sans aucune allocation par particule.
+ * Des poignées (handles) stables permettent de désigner une particule même après
+ * la suppression d'autres particules.
+ ******************************************************************************/
+
+#ifndef PARTICLESTORE_H
+#define PARTICLESTORE_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "collider.h"
+
+/**
+ * @struct ParticleHandle
+ * @brief Poignée stable vers une particule du ParticleStore.
+ *
+ * L'indice d'une particule dans les tableaux peut changer lors d'une suppression
+ * (la dernière particule prend la place de la particule supprimée), la poignée non.
+ * Le numéro de génération permet de détecter une poignée vers une particule supprimée.
+ */
+struct ParticleHandle {
+    std::uint32_t id=UINT32_MAX; /**< Emplacement dans la table des poignées. */
+    std::uint32_t generation=0;  /**< Génération de l'emplacement au moment de la création. */
+
+    bool operator==(const ParticleHandle& other) const {return id==other.id && generation==other.generation;}
+    bool operator!=(const ParticleHandle& other) const {return !(*this==other);}
+};
+
+/**
+ * @class BasicParticleStore
+ * @brief Ensemble de particules stocké en tableaux contigus, de nombres réels de type Real (float ou double).
+ *
+ * Les tableaux sont publics pour que les étapes de Context y accèdent directement.
+ * Ils ont toujours tous la même taille, égale à size().
+ */
+template <class Real>
+class BasicParticleStore {
+public:
+    std::vector<Real> x;        /**< Abscisse actuelle. */
+    std::vector<Real> y;        /**< Ordonnée actuelle. */
+    std::vector<Real> px;       /**< Abscisse future prédite. */
+    std::vector<Real> py;       /**< Ordonnée future prédite. */
+    std::vector<Real> vx;       /**< Vitesse selon x (mise à jour sur place pendant le pas). */
+    std::vector<Real> vy;       /**< Vitesse selon y (mise à jour sur place pendant le pas). */
+    std::vector<Real> radius;   /**< Rayon. */
+    std::vector<Real> inv_mass; /**< Inverse de la masse (0 pour une masse nulle ou infinie). */
+    std::vector<std::uint32_t> rest_frames; /**< Sommeil (voir Context::setSleep): pas passés au repos, ou asleep+numéro d'îlot. */
+    std::vector<Real> rest_x;   /**< Abscisse au début de la période de repos en cours. */
+    std::vector<Real> rest_y;   /**< Ordonnée au début de la période de repos en cours. */
+
+    static constexpr std::uint32_t asleep=0x80000000u; /**< rest_frames>=asleep: particule endormie, dans l'îlot rest_frames-asleep. */
+
+    /**
+     * @brief Nombre de particules.
+     */
+    std::size_t size() const {return x.size();}
+
+    /**
+     * @brief Indique si l'ensemble est vide.
+     */
+    bool empty() const {return x.empty();}
+
+    /**
+     * @brief Réserve la mémoire pour n particules dans chacun des tableaux.
+     * @param n Nombre de particules attendu.
+     */
+    void reserve(std::size_t n);
+
+    /**
+     * @brief Nombre de particules que les tableaux peuvent contenir sans réallocation.
+     */
+    std::size_t capacity() const {return x.capacity();}
+
+    /**
+     * @brief Garantit la place pour n particules. Si elle manque, la capacité est au moins doublée:
+     * des ajouts répétés ne recopient les tableaux qu'un nombre logarithmique de fois.
+     */
+    void ensureCapacity(std::size_t n){if (n>capacity()){reserve(std::max(n,2*capacity()));}}
+
+    /**
+     * @brief Ajoute une particule en fin de tableaux.
+     * @param p Description de la particule (la position future est ignorée et initialisée à la position).
+     * @return La poignée de la nouvelle particule.
+     */
+    ParticleHandle add(const basic_particle<Real>& p);
+
+    /**
+     * @brief Supprime une particule. La dernière particule prend sa place dans les tableaux.
+     * @param h Poignée de la particule à supprimer.
+     * @return false si la poignée n'est pas (ou plus) valide.
+     */
+    bool remove(ParticleHandle h);
+
+    /**
+     * @brief Échange deux particules dans les tableaux, leurs poignées restant valides.
+     */
+    void swap(std::size_t i,std::size_t j);
+
+    /**
+     * @brief Numéro incrémenté à chaque ajout, suppression ou vidage: les indices ont pu changer.
+     */
+    std::uint64_t revision() const {return revision_count;}
+
+    /**
+     * @brief Vérifie qu'une poignée désigne toujours une particule existante.
+     */
+    bool valid(ParticleHandle h) const;
+
+    /**
+     * @brief Indice actuel dans les tableaux de la particule désignée par la poignée.
+     * @param h Poignée valide.
+     */
+    std::size_t indexOf(ParticleHandle h) const {return slot_index[h.id];}
+
+    /**
+     * @brief Poignée de la particule rangée à l'indice i.
+     */
+    ParticleHandle handleAt(std::size_t i) const {return {index_slot[i],slot_generation[index_slot[i]]};}
+
+    /**
+     * @brief Copie les données de la particule d'indice i dans une structure particle.
+     * @param i Indice de la particule.
+     */
+    basic_particle<Real> get(std::size_t i) const {
+        return basic_particle<Real>{{x[i],y[i]},{px[i],py[i]},{vx[i],vy[i]},radius[i],inv_mass[i]>0?1/inv_mass[i]:0};
+    }
+
+    /**
+     * @brief Supprime toutes les particules. Les poignées existantes deviennent invalides.
+     */
+    void clear();
+
+private:
+    friend struct CheckpointAccess; /**< Sauvegarde et restauration des tables de poignées (checkpoint.cpp) */
+
+    std::vector<std::uint32_t> slot_index;      /**< Emplacement de poignée -> indice dans les tableaux. */
+    std::vector<std::uint32_t> slot_generation; /**< Génération courante de chaque emplacement. */
+    std::vector<std::uint32_t> index_slot;      /**< Indice dans les tableaux -> emplacement de poignée. */
+    std::vector<std::uint32_t> free_slots;      /**< Emplacements libérés, réutilisés en priorité. */
+    std::uint64_t revision_count=0;             /**< Voir revision(). */
+};
+
+using ParticleStore=BasicParticleStore<double>;
+using ParticleStoreF=BasicParticleStore<float>;
+
+#endif // PARTICLESTORE_H
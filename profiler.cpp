@@ -0,0 +1,115 @@
+/******************************************************************************
+ * @file profiler.cpp
+ * @brief Implémentation des méthodes de la classe Profiler définies dans profiler.h
+ ******************************************************************************/
+
+#include "profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+std::uint64_t Profiler::now(){
+    static const auto origin=std::chrono::steady_clock::now();
+    return (std::uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now()-origin).count();
+}
+
+void Profiler::beginFrame(){
+    if (frames.size()!=capacity){frames.assign(capacity,ProfileFrame());}
+    current=&frames[head];
+    *current=ProfileFrame();
+    current->index=next_index++;
+    head=(head+1)%capacity;
+    count=std::min(count+1,capacity);
+}
+
+void Profiler::endFrame(std::uint64_t start){
+    if (!current){return;}
+    current->stage_start[(std::size_t)ProfileStage::Step]=start;
+    current->stage_time[(std::size_t)ProfileStage::Step]=now()-start;
+    current=nullptr;
+}
+
+void Profiler::setCapacity(std::size_t new_capacity){
+    capacity=new_capacity>0?new_capacity:1;
+    frames.clear();
+    clear();
+}
+
+void Profiler::clear(){
+    head=0;
+    count=0;
+    current=nullptr;
+}
+
+double Profiler::averageMs(ProfileStage stage,std::size_t last) const{
+    std::size_t n=(last==0 || last>count)?count:last;
+    if (n==0){return 0;}
+    double total=0;
+    for (std::size_t k=count-n;k<count;k++){total+=frame(k).stage_time[(std::size_t)stage];}
+    return total/n/1e6;
+}
+
+double Profiler::maxMs(ProfileStage stage,std::size_t last) const{
+    std::size_t n=(last==0 || last>count)?count:last;
+    std::uint64_t longest=0;
+    for (std::size_t k=count-n;k<count;k++){longest=std::max(longest,frame(k).stage_time[(std::size_t)stage]);}
+    return longest/1e6;
+}
+
+bool Profiler::writeChromeTrace(const std::string& path) const{
+    FILE* file=std::fopen(path.c_str(),"w");
+    if (!file){return false;}
+    std::fprintf(file,"{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+    bool first=true;
+    for (std::size_t k=0;k<count;k++){
+        const ProfileFrame& f=frame(k);
+        // Les instants de Chrome trace sont en microsecondes
+        for (std::size_t s=0;s<profile_stage_count;s++){
+            if (f.stage_time[s]==0){continue;}
+            std::fprintf(file,"%s{\"name\": \"%s\", \"cat\": \"pbd\", \"ph\": \"X\", \"pid\": 1, \"tid\": 1, "
+                              "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"frame\": %llu}}",
+                         first?"":",\n",stageName((ProfileStage)s),f.stage_start[s]/1e3,f.stage_time[s]/1e3,
+                         (unsigned long long)f.index);
+            first=false;
+        }
+        std::fprintf(file,"%s{\"name\": \"counters\", \"ph\": \"C\", \"pid\": 1, \"ts\": %.3f, \"args\": {",
+                     first?"":",\n",f.stage_start[(std::size_t)ProfileStage::Step]/1e3);
+        for (std::size_t c=0;c<profile_counter_count;c++){
+            std::fprintf(file,"%s\"%s\": %llu",c>0?", ":"",counterName((ProfileCounter)c),(unsigned long long)f.counters[c]);
+        }
+        std::fprintf(file,"}}");
+        first=false;
+    }
+    std::fprintf(file,"\n]}\n");
+    return std::fclose(file)==0;
+}
+
+const char* Profiler::stageName(ProfileStage stage){
+    switch (stage){
+    case ProfileStage::Step: return "step";
+    case ProfileStage::ForceAndPredict: return "force_predict";
+    case ProfileStage::SweptContacts: return "swept_contacts";
+    case ProfileStage::StaticContacts: return "static_contacts";
+    case ProfileStage::Broadphase: return "broadphase";
+    case ProfileStage::DynamicContacts: return "dynamic_contacts";
+    case ProfileStage::ProjectConstraints: return "project";
+    case ProfileStage::DeleteContacts: return "delete_contacts";
+    case ProfileStage::FrictionAndUpdate: return "friction_update";
+    default: return "?";
+    }
+}
+
+const char* Profiler::counterName(ProfileCounter counter){
+    switch (counter){
+    case ProfileCounter::Particles: return "particles";
+    case ProfileCounter::AwakeParticles: return "awake_particles";
+    case ProfileCounter::ContactPairs: return "contact_pairs";
+    case ProfileCounter::StaticConstraints: return "static_constraints";
+    case ProfileCounter::DynamicConstraints: return "dynamic_constraints";
+    case ProfileCounter::SolvedConstraints: return "solved_constraints";
+    case ProfileCounter::SolverIterations: return "solver_iterations";
+    case ProfileCounter::DistanceConstraints: return "distance_constraints";
+    case ProfileCounter::FastParticles: return "fast_particles";
+    default: return "?";
+    }
+}
@@ -0,0 +1,222 @@
+/******************************************************************************
+ * @file profiler.h
+ * @brief Définition de la classe Profiler qui mesure la durée de chaque étape d'un pas de simulation.
+ *
+ * Chaque appel à Context::updatePhysicalSystem produit un ProfileFrame: durée de chaque étape
+ * et compteurs (particules, paires, contraintes). Les derniers ProfileFrame sont gardés dans un
+ * tampon circulaire, que l'on peut interroger ou écrire au format Chrome trace (chrome://tracing,
+ * Perfetto).
+ *
+ * Les mesures ne sont compilées que si PBD_ENABLE_PROFILING est défini (option CMake
+ * PBD_PROFILING): sinon les macros PBD_PROFILE_* ne génèrent aucun code et le tampon reste vide.
+ ******************************************************************************/
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @enum ProfileStage
+ * @brief Étapes mesurées d'un pas de simulation.
+ */
+enum class ProfileStage : std::uint8_t {
+    Step,               /**< Pas complet */
+    ForceAndPredict,    /**< applyExternalForceAndPredict */
+    SweptContacts,      /**< sweepFastParticles (détection continue des collisions) */
+    StaticContacts,     /**< addStaticContactConstraints */
+    Broadphase,         /**< Recherche des paires, dans addDynamicContactConstraints */
+    DynamicContacts,    /**< addDynamicContactConstraints, broadphase comprise */
+    ProjectConstraints, /**< projectConstraints */
+    DeleteContacts,     /**< deleteContactConstraints */
+    FrictionAndUpdate,  /**< applyFrictionAndUpdate */
+    Count
+};
+
+/**
+ * @enum ProfileCounter
+ * @brief Compteurs relevés à chaque pas de simulation.
+ */
+enum class ProfileCounter : std::uint8_t {
+    Particles,          /**< Nombre de particules */
+    AwakeParticles,     /**< Particules éveillées (toutes sans mise en sommeil) */
+    ContactPairs,       /**< Paires renvoyées par la broadphase */
+    StaticConstraints,  /**< Contraintes statiques détectées */
+    DynamicConstraints, /**< Contraintes dynamiques détectées */
+    SolvedConstraints,  /**< Contraintes appliquées par projectConstraints (une contrainte dynamique compte deux fois) */
+    SolverIterations,   /**< Itérations du solveur XPBD, tous sous-pas confondus (0 sans XPBD) */
+    DistanceConstraints,/**< Liens de distance projetés (voir Context::distances) */
+    FastParticles,      /**< Particules rapides dont la trajectoire est balayée (voir CCDSettings) */
+    Count
+};
+
+constexpr std::size_t profile_stage_count=(std::size_t)ProfileStage::Count;
+constexpr std::size_t profile_counter_count=(std::size_t)ProfileCounter::Count;
+
+/**
+ * @struct ProfileFrame
+ * @brief Mesures d'un pas de simulation. Les instants sont en nanosecondes depuis la création du Profiler.
+ */
+struct ProfileFrame {
+    std::uint64_t index=0; /**< Numéro du pas */
+    std::uint64_t stage_start[profile_stage_count]={}; /**< Début de la première exécution de chaque étape */
+    std::uint64_t stage_time[profile_stage_count]={}; /**< Durée cumulée de chaque étape (0 si elle n'a pas eu lieu) */
+    std::uint64_t counters[profile_counter_count]={}; /**< Valeur de chaque compteur */
+};
+
+/**
+ * @class Profiler
+ * @brief Tampon circulaire des mesures des derniers pas de simulation.
+ *
+ * Les mesures faites hors d'un pas (étape appelée directement) sont ignorées.
+ */
+class Profiler {
+private:
+    std::size_t capacity; /**< Nombre de pas conservés */
+    std::vector<ProfileFrame> frames; /**< Tampon circulaire, alloué au premier pas */
+    std::size_t head=0; /**< Emplacement du prochain pas */
+    std::size_t count=0; /**< Nombre de pas conservés (au plus capacity) */
+    std::uint64_t next_index=0; /**< Numéro du prochain pas */
+    ProfileFrame* current=nullptr; /**< Pas en cours, nullptr hors d'un pas */
+
+public:
+    /**
+     * @brief Constructeur.
+     * @param capacity Nombre de pas conservés dans le tampon circulaire.
+     */
+    explicit Profiler(std::size_t capacity=1024) : capacity(capacity>0?capacity:1) {}
+
+    /**
+     * @brief Vrai si les mesures sont compilées (PBD_ENABLE_PROFILING).
+     */
+    static constexpr bool enabled(){
+#ifdef PBD_ENABLE_PROFILING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief Instant présent, en nanosecondes depuis une origine fixe.
+     */
+    static std::uint64_t now();
+
+    /**
+     * @brief Commence un nouveau pas, qui remplace le plus ancien si le tampon est plein.
+     */
+    void beginFrame();
+
+    /**
+     * @brief Termine le pas en cours et enregistre sa durée totale.
+     * @param start Instant du début du pas.
+     */
+    void endFrame(std::uint64_t start);
+
+    /**
+     * @brief Ajoute la durée d'une étape au pas en cours.
+     */
+    void addTime(ProfileStage stage,std::uint64_t start,std::uint64_t end){
+        if (!current){return;}
+        std::size_t s=(std::size_t)stage;
+        if (current->stage_time[s]==0){current->stage_start[s]=start;}
+        current->stage_time[s]+=end-start;
+    }
+
+    /**
+     * @brief Donne sa valeur à un compteur du pas en cours.
+     */
+    void setCounter(ProfileCounter counter,std::uint64_t value){if (current){current->counters[(std::size_t)counter]=value;}}
+
+    /**
+     * @brief Change le nombre de pas conservés, en vidant le tampon.
+     */
+    void setCapacity(std::size_t new_capacity);
+
+    /**
+     * @brief Vide le tampon.
+     */
+    void clear();
+
+    /**
+     * @brief Nombre de pas conservés.
+     */
+    std::size_t frameCount() const {return count;}
+
+    /**
+     * @brief Accès à un pas conservé.
+     * @param k 0 pour le plus ancien, frameCount()-1 pour le plus récent.
+     */
+    const ProfileFrame& frame(std::size_t k) const {return frames[(head+capacity-count+k)%capacity];}
+
+    /**
+     * @brief Durée moyenne d'une étape (en ms) sur les derniers pas.
+     * @param last Nombre de pas pris en compte, 0 pour tous les pas conservés.
+     */
+    double averageMs(ProfileStage stage,std::size_t last=0) const;
+
+    /**
+     * @brief Durée maximale d'une étape (en ms) sur les derniers pas.
+     * @param last Nombre de pas pris en compte, 0 pour tous les pas conservés.
+     */
+    double maxMs(ProfileStage stage,std::size_t last=0) const;
+
+    /**
+     * @brief Écrit les pas conservés au format Chrome trace (étapes en événements "X", compteurs en événements "C").
+     * @param path Chemin du fichier JSON.
+     * @return false si le fichier ne peut être écrit.
+     */
+    bool writeChromeTrace(const std::string& path) const;
+
+    static const char* stageName(ProfileStage stage);
+    static const char* counterName(ProfileCounter counter);
+};
+
+/**
+ * @class ProfileScope
+ * @brief Mesure la durée de vie de l'objet et l'ajoute à une étape du pas en cours.
+ */
+class ProfileScope {
+private:
+    Profiler& profiler;
+    ProfileStage stage;
+    std::uint64_t start;
+public:
+    ProfileScope(Profiler& profiler,ProfileStage stage) : profiler(profiler), stage(stage), start(Profiler::now()) {}
+    ~ProfileScope(){profiler.addTime(stage,start,Profiler::now());}
+    ProfileScope(const ProfileScope&)=delete;
+    ProfileScope& operator=(const ProfileScope&)=delete;
+};
+
+/**
+ * @class ProfileFrameScope
+ * @brief Délimite un pas de simulation: beginFrame à la construction, endFrame à la destruction.
+ */
+class ProfileFrameScope {
+private:
+    Profiler& profiler;
+    std::uint64_t start;
+public:
+    explicit ProfileFrameScope(Profiler& profiler) : profiler(profiler), start(Profiler::now()) {profiler.beginFrame();}
+    ~ProfileFrameScope(){profiler.endFrame(start);}
+    ProfileFrameScope(const ProfileFrameScope&)=delete;
+    ProfileFrameScope& operator=(const ProfileFrameScope&)=delete;
+};
+
+#define PBD_PROFILE_CONCAT_(a,b) a##b
+#define PBD_PROFILE_CONCAT(a,b) PBD_PROFILE_CONCAT_(a,b)
+
+#ifdef PBD_ENABLE_PROFILING
+#define PBD_PROFILE_FRAME(profiler) ProfileFrameScope PBD_PROFILE_CONCAT(pbd_profile_frame_,__LINE__)(profiler)
+#define PBD_PROFILE_SCOPE(profiler,stage) ProfileScope PBD_PROFILE_CONCAT(pbd_profile_scope_,__LINE__)(profiler,stage)
+#define PBD_PROFILE_COUNTER(profiler,counter,value) (profiler).setCounter(counter,(std::uint64_t)(value))
+#else
+#define PBD_PROFILE_FRAME(profiler) ((void)0)
+#define PBD_PROFILE_SCOPE(profiler,stage) ((void)0)
+#define PBD_PROFILE_COUNTER(profiler,counter,value) ((void)0)
+#endif
+
+#endif // PROFILER_H
@@ -0,0 +1,172 @@
+/******************************************************************************
+ * @file scene.cpp
+ * @brief Implémentation des fonctions de chargement de scène définies dans scene.h,
+ * instanciées pour Context et ContextF
+ ******************************************************************************/
+
+#include "scene.h"
+#include <cmath>
+#include <fstream>
+#include <sstream>
+
+template <class Real>
+void addDefaultColliders(BasicContext<Real>& context){
+    typedef basic_plancollider<Real> plancollider;
+    typedef basic_spherecollider<Real> spherecollider;
+    plancollider planCollider1_1(std::make_pair(700.0, 80.0), 200.0, 0);
+    plancollider planCollider1_2(std::make_pair(700.0, 100.0), 200.0, -M_PI);
+    plancollider planCollider1_3(std::make_pair(500.0, 90.0), 10.0, M_PI/2);
+    plancollider planCollider1_4(std::make_pair(900.0, 90.0), 10.0, -M_PI/2);
+    context.addCollider(planCollider1_1);
+    context.addCollider(planCollider1_2);
+    context.addCollider(planCollider1_3);
+    context.addCollider(planCollider1_4);
+
+
+    plancollider planCollider2_1(std::make_pair(700.0, 140.0), 200.0, 0);
+    plancollider planCollider2_2(std::make_pair(700.0, 150.0), 200.0, M_PI);
+    plancollider planCollider2_3(std::make_pair(500.0, 145.0), 5.0, M_PI/2);
+    plancollider planCollider2_4(std::make_pair(900.0, 145.0), 5.0, -M_PI/2);
+    context.addCollider(planCollider2_1);
+    context.addCollider(planCollider2_2);
+    context.addCollider(planCollider2_3);
+    context.addCollider(planCollider2_4);
+
+    plancollider planCollider3_1(std::make_pair(100.0, 150.0), 100.0, -M_PI/8);
+    plancollider planCollider3_2(std::make_pair(100.0, 188.27), 92.39, -M_PI);
+    context.addCollider(planCollider3_1);
+    context.addCollider(planCollider3_2);
+
+    spherecollider sphereCollider1(std::make_pair(200.0, 50.0), 30.0);
+    spherecollider sphereCollider2(std::make_pair(350.0, 150.0), 20.0);
+    spherecollider sphereCollider3(std::make_pair(600, 200.0), 10.0);
+    context.addCollider(sphereCollider1);
+    context.addCollider(sphereCollider2);
+    context.addCollider(sphereCollider3);
+}
+
+/**
+* @brief Exécute une ligne de scène
+* @return false si la commande est inconnue ou ses arguments invalides
+*/
+template <class Real>
+static bool parseLine(std::istringstream& line,const std::string& command,BasicContext<Real>& context){
+    if (command=="size"){
+        int width,height;
+        if (!(line>>width>>height)){return false;}
+        context.width=width;
+        context.height=height;
+    }else if (command=="gravity"){
+        double gx,gy;
+        if (!(line>>gx>>gy)){return false;}
+        context.champ_de_force={Real(gx),Real(gy)};
+    }else if (command=="friction"){
+        if (!(line>>context.alpha)){return false;}
+    }else if (command=="xpbd"){
+        XPBDSettings settings;
+        settings.enabled=true;
+        if (!(line>>settings.substeps>>settings.iterations)){return false;}
+        // Souplesses et tolérance facultatives, mais une valeur qui n'est pas un nombre est une erreur
+        if (!(line>>settings.static_compliance)){if (!line.eof()){return false;}}
+        else if (!(line>>settings.dynamic_compliance>>settings.tolerance)){return false;}
+        context.setXPBD(settings);
+    }else if (command=="sleep"){
+        SleepSettings settings;
+        settings.enabled=true;
+        if (!(line>>settings.velocity)){if (!line.eof()){return false;}}
+        else if (!(line>>settings.displacement>>settings.frames)){return false;}
+        context.setSleep(settings);
+    }else if (command=="ccd"){
+        CCDSettings settings;
+        settings.enabled=true;
+        if (!(line>>settings.speed_threshold)){if (!line.eof()){return false;}}
+        else if (!(line>>settings.skin>>settings.passes)){return false;}
+        context.setCCD(settings);
+    }else if (command=="sdf"){
+        ColliderSDFSettings settings;
+        settings.enabled=true;
+        if (!(line>>settings.cell_size)){if (!line.eof()){return false;}}
+        else if (!(line>>settings.margin>>settings.thickness)){return false;}
+        if (!(settings.cell_size>0)){return false;}
+        context.setColliderSDF(settings);
+    }else if (command=="plane"){
+        double x,y,length,angle;
+        if (!(line>>x>>y>>length>>angle)){return false;}
+        context.addCollider(basic_plancollider<Real>(std::make_pair(x,y),length,angle));
+    }else if (command=="sphere"){
+        double x,y,radius;
+        if (!(line>>x>>y>>radius)){return false;}
+        context.addCollider(basic_spherecollider<Real>(std::make_pair(x,y),radius));
+    }else if (command=="particle"){
+        basic_particle<Real> p;
+        if (!(line>>p.pos[0]>>p.pos[1]>>p.velocity[0]>>p.velocity[1]>>p.radius>>p.mass)){return false;}
+        context.particles.add(p);
+    }else if (command=="grid"){
+        double x0,y0,spacing,radius,mass;
+        int cols,rows;
+        if (!(line>>x0>>y0>>cols>>rows>>spacing>>radius>>mass) || cols<0 || rows<0){return false;}
+        context.emitGrid(x0,y0,cols,rows,spacing,radius,mass);
+    }else if (command=="random"){
+        double x0,y0,x1,y1,radius,mass;
+        long count;
+        std::uint64_t seed;
+        if (!(line>>x0>>y0>>x1>>y1>>count>>radius>>mass>>seed) || count<0){return false;}
+        context.emitRandom(x0,y0,x1,y1,count,radius,mass,seed);
+    }else if (command=="stream"){
+        ParticleStream stream;
+        long max_particles;
+        if (!(line>>stream.x>>stream.y>>stream.vx>>stream.vy>>stream.rate>>stream.width>>stream.radius>>stream.mass>>max_particles)
+            || max_particles<0){return false;}
+        stream.max_particles=max_particles;
+        context.addStream(stream);
+    }else if (command=="rope"){
+        double x0,y0,x1,y1,radius,mass,compliance=0;
+        long count;
+        if (!(line>>x0>>y0>>x1>>y1>>count>>radius>>mass) || count<0){return false;}
+        if (!(line>>compliance) && !line.eof()){return false;}
+        context.emitRope(x0,y0,x1,y1,count,radius,mass,compliance);
+    }else if (command=="lattice"){
+        double x0,y0,spacing,radius,mass,compliance=0;
+        int cols,rows;
+        if (!(line>>x0>>y0>>cols>>rows>>spacing>>radius>>mass) || cols<0 || rows<0){return false;}
+        if (!(line>>compliance) && !line.eof()){return false;}
+        context.emitLattice(x0,y0,cols,rows,spacing,radius,mass,compliance);
+    }else if (command=="default_colliders"){
+        addDefaultColliders(context);
+    }else{
+        return false;
+    }
+    // Rien ne doit suivre les arguments
+    std::string extra;
+    return !(line>>extra);
+}
+
+template <class Real>
+bool loadScene(const std::string& path,BasicContext<Real>& context,std::string* error){
+    std::ifstream file(path);
+    if (!file){
+        if (error){*error=path+": impossible d'ouvrir le fichier";}
+        return false;
+    }
+    std::string text;
+    int line_number=0;
+    while (std::getline(file,text)){
+        line_number++;
+        std::istringstream line(text);
+        std::string command;
+        if (!(line>>command) || command[0]=='#'){continue;}
+        if (!parseLine(line,command,context)){
+            if (error){*error=path+":"+std::to_string(line_number)+": ligne invalide: "+text;}
+            return false;
+        }
+    }
+    // La grille de distances et les tampons des pas sont préparés au chargement plutôt qu'au premier pas
+    context.bakeColliderSDF();
+    context.reserveStepBuffers();
+    return true;
+}
+
+template void addDefaultColliders<float>(ContextF&);
+template void addDefaultColliders<double>(Context&);
+template bool loadScene<float>(const std::string&,ContextF&,std::string*);
+template bool loadScene<double>(const std::string&,Context&,std::string*);
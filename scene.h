@@ -0,0 +1,58 @@
+/******************************************************************************
+ * @file scene.h
+ * @brief Chargement d'une scène (colliders, particules, paramètres) dans un Context.
+ *
+ * Une scène est un fichier texte, une commande par ligne, les lignes vides et
+ * les lignes commençant par # étant ignorées:
+ *
+ *     size <largeur> <hauteur>
+ *     gravity <gx> <gy>
+ *     friction <alpha>
+ *     xpbd <sous_pas> <itérations> [<souplesse_statique> <souplesse_dynamique> <tolérance>]
+ *     sleep [<vitesse> <déplacement> <pas>]
+ *     sdf [<pas> <marge> <épaisseur>]
+ *     ccd [<seuil> <recouvrement> <passes>]
+ *     plane <x> <y> <demi_longueur> <angle_en_radians>
+ *     sphere <x> <y> <rayon>
+ *     particle <x> <y> <vx> <vy> <rayon> <masse>
+ *     grid <x0> <y0> <colonnes> <lignes> <pas> <rayon> <masse>
+ *     random <x0> <y0> <x1> <y1> <nombre> <rayon> <masse> <graine>
+ *     stream <x> <y> <vx> <vy> <débit> <largeur> <rayon> <masse> <nombre_max>
+ *     rope <x0> <y0> <x1> <y1> <nombre> <rayon> <masse> [<souplesse>]
+ *     lattice <x0> <y0> <colonnes> <lignes> <pas> <rayon> <masse> [<souplesse>]
+ *     default_colliders
+ *
+ * grid ajoute colonnes*lignes particules immobiles espacées de pas (Context::emitGrid), random
+ * tire des particules immobiles sans recouvrement dans un rectangle (Context::emitRandom), stream
+ * ajoute une source continue (ParticleStream, nombre_max 0 pour une source sans fin), rope une corde de
+ * particules liées (Context::emitRope), lattice un treillis (Context::emitLattice), et default_colliders
+ * ajoute les colliders de la scène de l'interface graphique. xpbd active le solveur XPBD
+ * (voir XPBDSettings), sleep la mise en sommeil, qui active aussi XPBD (voir SleepSettings), sdf la grille de distances aux
+ * colliders (voir ColliderSDFSettings) et ccd la détection continue des collisions (voir CCDSettings),
+ * les valeurs omises gardant leur valeur par défaut. Les valeurs sont converties dans la précision du contexte (Context ou ContextF).
+ ******************************************************************************/
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <string>
+#include "Context.h"
+
+/**
+ * @brief Ajoute au contexte les colliders de la scène de démonstration (étagères et sphères).
+ * @param context Le contexte à compléter.
+ */
+template <class Real>
+void addDefaultColliders(BasicContext<Real>& context);
+
+/**
+ * @brief Charge un fichier de scène dans le contexte (en plus de son contenu actuel).
+ * @param path Chemin du fichier.
+ * @param context Le contexte à compléter.
+ * @param error Message d'erreur (fichier et ligne) si le chargement échoue, peut être nullptr.
+ * @return false si le fichier ne peut être lu ou contient une ligne invalide.
+ */
+template <class Real>
+bool loadScene(const std::string& path,BasicContext<Real>& context,std::string* error);
+
+#endif // SCENE_H
@@ -0,0 +1,277 @@
+/******************************************************************************
+ * @file sdf.cpp
+ * @brief Implémentation des méthodes de la classe BasicColliderSDF définies dans sdf.h,
+ * instanciée en float et en double
+ ******************************************************************************/
+
+#include "sdf.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+/**
+* @brief Distance signée à la plaque d'un plan (rectangle de demi-longueur length, d'épaisseur thickness derrière le plan)
+* @param piece Morceau de la plaque le plus proche: 0 à l'extérieur (gradient continu), 1 à 4 à l'intérieur (extrémités, arrière, devant)
+*/
+template <class Real>
+static double plateDistance(const basic_plancollider<Real>& plan,double thickness,double x,double y,double& gx,double& gy,std::uint32_t& piece){
+    const double nx=plan.normal[0],ny=plan.normal[1];
+    const double dx=x-plan.origin.first,dy=y-plan.origin.second;
+    // Coordonnées le long du plan (tangente (ny,-nx), comme distance_au_centre de checkContact) et depuis le milieu de la plaque
+    const double t=ny*dx-nx*dy;
+    const double c=nx*dx+ny*dy+thickness/2;
+    const double qx=std::abs(t)-(double)plan.length;
+    const double qy=std::abs(c)-thickness/2;
+    const double st=t<0?-1:1,sc=c<0?-1:1;
+    double phi,lt,ld;
+    if (qx>0 || qy>0){
+        double ox=std::max(qx,0.0),oy=std::max(qy,0.0);
+        phi=std::sqrt(ox*ox+oy*oy);
+        lt=ox*st/phi;
+        ld=oy*sc/phi;
+        piece=0;
+    }else if (qx>qy){
+        phi=qx;
+        lt=st;
+        ld=0;
+        piece=st>0?1:2;
+    }else{
+        phi=qy;
+        lt=0;
+        ld=sc;
+        piece=sc>0?4:3;
+    }
+    gx=lt*ny+ld*nx;
+    gy=-lt*nx+ld*ny;
+    return phi;
+}
+
+/**
+* @brief Distance signée à une sphère
+*/
+template <class Real>
+static double sphereDistance(const basic_spherecollider<Real>& sphere,double x,double y,double& gx,double& gy){
+    const double dx=x-sphere.origin.first,dy=y-sphere.origin.second;
+    const double distance=std::sqrt(dx*dx+dy*dy);
+    gx=distance>0?dx/distance:1;
+    gy=distance>0?dy/distance:0;
+    return distance-sphere.radius;
+}
+
+/**
+* @brief Distance exacte plafonnée à margin et morceau du collider le plus proche (5*identifiant+morceau de la plaque, UINT32_MAX au-delà de margin).
+* Le premier collider l'emporte en cas d'égalité, comme dans build.
+*/
+template <class Real>
+static double exactPiece(const BasicColliderSet<Real>& colliders,const ColliderSDFSettings& settings,double x,double y,double& gx,double& gy,std::uint32_t& piece){
+    double phi=settings.margin;
+    gx=gy=0;
+    piece=UINT32_MAX;
+    double cx,cy;
+    std::uint32_t sub;
+    for (std::uint32_t p=0;p<colliders.planes.size();p++){
+        double d=plateDistance(colliders.planes[p],settings.thickness,x,y,cx,cy,sub);
+        if (d<phi){phi=d;gx=cx;gy=cy;piece=5*p+sub;}
+    }
+    for (std::uint32_t s=0;s<colliders.spheres.size();s++){
+        double d=sphereDistance(colliders.spheres[s],x,y,cx,cy);
+        if (d<phi){phi=d;gx=cx;gy=cy;piece=5*(std::uint32_t)(colliders.planes.size()+s);}
+    }
+    return phi;
+}
+
+template <class Real>
+double BasicColliderSDF<Real>::exactDistance(const BasicColliderSet<Real>& colliders,const ColliderSDFSettings& settings,double x,double y,
+                                             double& gx,double& gy,std::uint32_t& nearest){
+    std::uint32_t piece;
+    double phi=exactPiece(colliders,settings,x,y,gx,gy,piece);
+    nearest=piece==UINT32_MAX?UINT32_MAX:piece/5;
+    return phi;
+}
+
+template <class Real>
+void BasicColliderSDF<Real>::build(const BasicColliderSet<Real>& colliders,const ColliderSDFSettings& new_settings){
+    settings=new_settings;
+    settings.cell_size=settings.cell_size>0?settings.cell_size:1;
+    collider_count=colliders.size();
+    nodes.clear();
+    cols=n_rows=0;
+    cell=settings.cell_size;
+    inv_cell=Real(1/cell);
+    if (colliders.empty()){return;}
+
+    // Boîte de chaque collider, agrandie de la marge (et de l'épaisseur de la plaque pour un plan)
+    std::vector<AABB> boxes(colliders.size());
+    for (std::uint32_t c=0;c<colliders.size();c++){
+        double grow=settings.margin+(c<colliders.planes.size()?settings.thickness:0);
+        AABB box=colliders.boundingBox(c);
+        boxes[c]=AABB{box.min_x-grow,box.min_y-grow,box.max_x+grow,box.max_y+grow};
+    }
+    AABB bounds=boxes[0];
+    for (const AABB& box:boxes){
+        bounds.min_x=std::min(bounds.min_x,box.min_x);
+        bounds.min_y=std::min(bounds.min_y,box.min_y);
+        bounds.max_x=std::max(bounds.max_x,box.max_x);
+        bounds.max_y=std::max(bounds.max_y,box.max_y);
+    }
+    x0=bounds.min_x;
+    y0=bounds.min_y;
+    cols=(std::size_t)std::ceil((bounds.max_x-bounds.min_x)/cell)+2;
+    n_rows=(std::size_t)std::ceil((bounds.max_y-bounds.min_y)/cell)+2;
+    nodes.assign(cols*n_rows,Node{Real(settings.margin),0,0});
+
+    // Distances calculées en double, puis minimum collider par collider sur les noeuds de sa boîte
+    std::vector<double> phi(nodes.size(),settings.margin);
+    double gx,gy;
+    std::uint32_t sub;
+    for (std::uint32_t c=0;c<colliders.size();c++){
+        const AABB& box=boxes[c];
+        std::size_t i0=(std::size_t)std::max(0.0,std::floor((box.min_x-x0)/cell));
+        std::size_t j0=(std::size_t)std::max(0.0,std::floor((box.min_y-y0)/cell));
+        std::size_t i1=std::min(cols-1,(std::size_t)std::ceil((box.max_x-x0)/cell));
+        std::size_t j1=std::min(n_rows-1,(std::size_t)std::ceil((box.max_y-y0)/cell));
+        for (std::size_t j=j0;j<=j1;j++){
+            for (std::size_t i=i0;i<=i1;i++){
+                double x=x0+i*cell,y=y0+j*cell;
+                double d=c<colliders.planes.size()?plateDistance(colliders.planes[c],settings.thickness,x,y,gx,gy,sub)
+                                                 :sphereDistance(colliders.spheres[c-colliders.planes.size()],x,y,gx,gy);
+                std::size_t k=j*cols+i;
+                if (d<phi[k]){
+                    phi[k]=d;
+                    nodes[k]=Node{Real(d),Real(gx),Real(gy)};
+                }
+            }
+        }
+    }
+}
+
+template <class Real>
+bool BasicColliderSDF<Real>::sample(Real x,Real y,Real& phi,Real& gx,Real& gy) const {
+    const Real fx=(x-Real(x0))*inv_cell;
+    const Real fy=(y-Real(y0))*inv_cell;
+    // Écrit ainsi, le test rejette aussi les positions non finies
+    if (!(fx>=0 && fy>=0 && fx<Real(cols-1) && fy<Real(n_rows-1))){return false;}
+    const std::size_t i=(std::size_t)fx,j=(std::size_t)fy;
+    const Real u=fx-Real(i),v=fy-Real(j);
+    const Node& a=nodes[j*cols+i];
+    const Node& b=nodes[j*cols+i+1];
+    const Node& c=nodes[(j+1)*cols+i];
+    const Node& d=nodes[(j+1)*cols+i+1];
+    const Real wa=(1-u)*(1-v),wb=u*(1-v),wc=(1-u)*v,wd=u*v;
+    phi=wa*a.phi+wb*b.phi+wc*c.phi+wd*d.phi;
+    gx=wa*a.gx+wb*b.gx+wc*c.gx+wd*d.gx;
+    gy=wa*a.gy+wb*b.gy+wc*c.gy+wd*d.gy;
+    return true;
+}
+
+template <class Real>
+void BasicColliderSDF<Real>::findContacts(const Real* px,const Real* py,const Real* radius,std::size_t n,std::vector<BasicStaticConstraint<Real>>& out) const {
+    if (nodes.empty()){return;}
+    Real phi,gx,gy;
+    for (std::size_t i=0;i<n;i++){
+        if (!sample(px[i],py[i],phi,gx,gy) || !(phi<radius[i])){continue;}
+        // Le gradient interpolé entre deux colliders peut s'annuler: sans direction, pas de contact
+        Real norm=std::sqrt(gx*gx+gy*gy);
+        if (!(norm>0)){continue;}
+        // Point de contact: la particule reculée de sa distance aux colliders le long du gradient
+        const Real nx=gx/norm;
+        const Real ny=gy/norm;
+        out.push_back(BasicStaticConstraint<Real>{(std::uint32_t)i,nx,ny,radius[i]-phi,px[i]-nx*phi,py[i]-ny*phi});
+    }
+}
+
+template <class Real>
+bool BasicColliderSDF<Real>::sweep(Real x,Real y,Real dx,Real dy,Real radius,Real& t) const {
+    const Real length=std::sqrt(dx*dx+dy*dy);
+    Real phi,gx,gy;
+    if (nodes.empty() || !(length>0)){return false;}
+    if (sample(x,y,phi,gx,gy) && phi<radius){
+        // Déjà en contact: la particule reste sur place si elle s'enfonce, le contact la repoussera
+        if (gx*dx+gy*dy<0){t=0;return true;}
+        return false;
+    }
+    // L'interpolation bilinéaire de valeurs 1-lipschitziennes est √2-lipschitzienne: avancer de (phi-radius)/√2 ne traverse
+    // aucun contact. Le pas minimal borne le recouvrement au contact et le nombre de pas près d'une surface.
+    const Real min_step=Real(0.1*cell);
+    const Real x1=Real(x0+(cols-1)*cell),y1=Real(y0+(n_rows-1)*cell);
+    Real s=0;
+    for (unsigned k=0;k<256;k++){
+        const Real hit=s/length;
+        const Real qx=x+hit*dx,qy=y+hit*dy;
+        if (!sample(qx,qy,phi,gx,gy)){
+            // Hors de la grille, tout collider est à plus de margin de son bord
+            Real ox=std::max(std::max(Real(x0)-qx,qx-x1),Real(0)),oy=std::max(std::max(Real(y0)-qy,qy-y1),Real(0));
+            phi=Real(settings.margin)+std::sqrt(ox*ox+oy*oy);
+        }
+        if (phi<radius){t=hit;return true;}
+        s+=std::max((phi-radius)*Real(0.7071067811865476),min_step);
+        if (s>=length){return false;}
+    }
+    // Trop de pas (déplacement frôlant une surface sur une grande longueur): on s'arrête là, par prudence
+    t=s/length;
+    return true;
+}
+
+template <class Real>
+SDFError BasicColliderSDF<Real>::measureError(const BasicColliderSet<Real>& colliders,double radius,std::size_t samples,std::uint64_t seed) const {
+    SDFError e;
+    e.bound=errorBound();
+    if (nodes.empty()){return e;}
+    // Tolérance des arrondis de l'interpolation, en plus de la borne
+    const double rounding=sizeof(Real)==4?1e-3:1e-9;
+    std::mt19937_64 rng(seed);
+    std::uniform_real_distribution<double> ux(x0,x0+(cols-1)*cell),uy(y0,y0+(n_rows-1)*cell);
+    double sum_distance=0,sum_angle=0;
+    for (std::size_t attempt=0;e.samples<samples && attempt<100*samples;attempt++){
+        double x=ux(rng),y=uy(rng);
+        double gx,gy;
+        std::uint32_t piece;
+        double exact=exactPiece(colliders,settings,x,y,gx,gy,piece);
+        Real phi,sx,sy;
+        // Seuls les points à moins de margin d'un collider comptent
+        if (piece==UINT32_MAX || !sample(Real(x),Real(y),phi,sx,sy)){continue;}
+        e.samples++;
+
+        double error=std::abs((double)phi-exact);
+        e.max_distance=std::max(e.max_distance,error);
+        sum_distance+=error;
+        if (error>e.bound+rounding){e.over_bound++;}
+
+        double norm=std::sqrt((double)sx*sx+(double)sy*sy);
+        double angle=norm>0?std::acos(std::max(-1.0,std::min(1.0,(sx*gx+sy*gy)/norm))):M_PI;
+        sum_angle+=angle;
+        // Le gradient exact n'est continu qu'hors des colliders, entre noeuds dont le morceau le plus proche est le même
+        bool smooth=exact>=0;
+        const double fx=std::floor((x-x0)/cell),fy=std::floor((y-y0)/cell);
+        for (int corner=0;corner<4 && smooth;corner++){
+            double cx,cy;
+            std::uint32_t corner_piece;
+            exactPiece(colliders,settings,x0+(fx+(corner&1))*cell,y0+(fy+(corner>>1))*cell,cx,cy,corner_piece);
+            smooth=corner_piece==piece;
+        }
+        if (smooth){e.smooth_angle=std::max(e.smooth_angle,angle);}
+
+        // Contacts d'une particule de rayon radius placée au point, grille contre checkContact
+        BasicStaticConstraint<Real> constraint,found;
+        std::size_t exact_contacts=0;
+        for (std::uint32_t c=0;c<colliders.size();c++){
+            if (colliders.checkContact(c,Real(x),Real(y),Real(radius),constraint)){found=constraint;exact_contacts++;}
+        }
+        bool grid_contact=phi<Real(radius) && norm>0;
+        if (exact_contacts>0){e.contacts++;}
+        if (exact_contacts>0 && !grid_contact){e.missed++;}
+        if (exact_contacts==0 && grid_contact && exact>=0){e.extra++;}
+        // Profondeurs comparées là où la plaque et le plan donnent la même profondeur
+        if (exact_contacts==1 && grid_contact && std::abs(radius-exact-(double)found.depth)<1e-3){
+            e.max_depth=std::max(e.max_depth,std::abs((double)(Real(radius)-phi)-(double)found.depth));
+        }
+    }
+    if (e.samples>0){
+        e.mean_distance=sum_distance/e.samples;
+        e.mean_angle=sum_angle/e.samples;
+    }
+    return e;
+}
+
+template class BasicColliderSDF<float>;
+template class BasicColliderSDF<double>;
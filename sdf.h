@@ -0,0 +1,162 @@
+/******************************************************************************
+ * @file sdf.h
+ * @brief Définition de la classe ColliderSDF, une grille de distances signées précalculée
+ * sur les colliders statiques.
+ *
+ * La distance aux colliders et son gradient sont calculés une fois pour toutes aux noeuds
+ * d'une grille régulière. La détection des contacts statiques d'une particule se réduit alors
+ * à une interpolation bilinéaire entre quatre noeuds, quel que soit le nombre de colliders.
+ ******************************************************************************/
+
+#ifndef SDF_H
+#define SDF_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "collider.h"
+
+/**
+ * @struct ColliderSDFSettings
+ * @brief Réglages de la grille de distances (voir Context::setColliderSDF).
+ *
+ * Un plan n'a pas d'intérieur: il est épaissi vers l'arrière (à l'opposé de sa normale) en une plaque
+ * d'épaisseur thickness, dont la distance signée est celle d'un rectangle. Devant la plaque et derrière
+ * elle jusqu'à mi-épaisseur, le contact est celui du plan (même normale, même profondeur); il diffère
+ * aux extrémités du segment, arrondies, et derrière la plaque, qui repousse les particules vers l'arrière.
+ * L'épaisseur doit dépasser le diamètre des plus grosses particules.
+ */
+struct ColliderSDFSettings {
+    bool enabled=false; /**< Faux: les contacts statiques sont calculés exactement, collider par collider */
+    double cell_size=1; /**< Pas de la grille */
+    double margin=20; /**< Distance couverte autour des colliders: au-delà, la distance est plafonnée à margin. Doit dépasser le plus grand rayon de particule */
+    double thickness=20; /**< Épaisseur des plans vers l'arrière */
+};
+
+/**
+ * @struct SDFError
+ * @brief Écart entre la grille et le calcul exact, mesuré par ColliderSDF::measureError.
+ */
+struct SDFError {
+    std::size_t samples=0; /**< Points tirés à moins de margin d'un collider */
+    double bound=0; /**< Borne garantie de l'écart de distance: cell_size/√2 */
+    double max_distance=0; /**< Plus grand écart de distance */
+    double mean_distance=0; /**< Écart de distance moyen */
+    std::size_t over_bound=0; /**< Points dont l'écart dépasse la borne (0 attendu) */
+    double mean_angle=0; /**< Écart moyen entre les normales (en radians) */
+    double smooth_angle=0; /**< Plus grand écart entre les normales (en radians), hors des colliders, aux points dont le morceau de collider le plus proche est le même aux quatre noeuds voisins */
+    std::size_t contacts=0; /**< Points en contact pour le calcul exact des colliders (checkContact), pour le rayon donné */
+    std::size_t missed=0; /**< Points en contact exact, sans contact dans la grille */
+    std::size_t extra=0; /**< Points hors des colliders en contact dans la grille, sans contact exact (extrémités et arrière des plans) */
+    double max_depth=0; /**< Plus grand écart de profondeur des points en contact dans les deux calculs, avec un seul collider */
+};
+
+/**
+ * @class BasicColliderSDF
+ * @brief Grille de distances signées aux colliders, en réels de type Real (float ou double).
+ *
+ * Chaque noeud stocke la distance signée phi au collider le plus proche (négative à l'intérieur) et le gradient
+ * de phi, unitaire, qui donne la normale de contact. Les trois valeurs d'un noeud sont contiguës: une interpolation
+ * lit deux paires de noeuds voisins. Une particule de rayon r touche les colliders si phi<r; la contrainte
+ * pousse alors la particule de r-phi le long du gradient.
+ *
+ * phi est 1-lipschitzienne: l'interpolation bilinéaire s'en écarte d'au plus cell_size/√2 (la moyenne pondérée des
+ * distances aux quatre noeuds), et de l'ordre de cell_size² loin des arêtes et des coins des colliders.
+ * La grille couvre les boîtes des colliders agrandies de margin (et de thickness pour les plans); hors de la grille, il n'y
+ * a pas de contact.
+ */
+template <class Real>
+class BasicColliderSDF {
+public:
+    /**
+     * @brief Calcule la grille sur les colliders donnés.
+     * Chaque collider ne met à jour que les noeuds de sa boîte agrandie de margin: le coût est proportionnel à la surface
+     * couverte par les colliders, pas au produit de la taille de la grille par leur nombre.
+     */
+    void build(const BasicColliderSet<Real>& colliders,const ColliderSDFSettings& settings);
+
+    /**
+     * @brief Nombre de colliders sur lesquels la grille a été calculée.
+     */
+    std::size_t colliderCount() const {return collider_count;}
+
+    /**
+     * @brief Nombre de noeuds selon x et selon y (0 si aucun collider).
+     */
+    std::size_t columns() const {return cols;}
+    std::size_t rows() const {return n_rows;}
+
+    /**
+     * @brief Mémoire occupée par les noeuds, en octets.
+     */
+    std::size_t memoryBytes() const {return nodes.size()*sizeof(Node);}
+
+    /**
+     * @brief Borne de l'écart entre la distance interpolée et la distance exacte.
+     */
+    double errorBound() const {return cell*0.7071067811865476;}
+
+    /**
+     * @brief Interpole la distance et le gradient au point (x,y).
+     * @return false hors de la grille (phi, gx et gy ne sont pas modifiés).
+     */
+    bool sample(Real x,Real y,Real& phi,Real& gx,Real& gy) const;
+
+    /**
+     * @brief Ajoute à out une contrainte par particule en contact avec les colliders.
+     * Les particules sont numérotées à partir de 0, dans l'ordre des tableaux.
+     * @param n Nombre de particules.
+     */
+    void findContacts(const Real* px,const Real* py,const Real* radius,std::size_t n,std::vector<BasicStaticConstraint<Real>>& out) const;
+
+    /**
+     * @brief Premier contact d'une particule qui se déplace de (x,y) à (x+dx,y+dy), cherché par pas conservatifs le long
+     * du segment (sphere tracing): le point atteint est celui où la grille donne phi<radius.
+     * Une particule déjà en contact au départ est arrêtée sur place (t=0) si elle s'enfonce (déplacement contre le gradient).
+     * @param t Fraction du déplacement au premier contact: la position (x+t*dx,y+t*dy) est en contact pour findContacts.
+     * @return false si la particule ne touche pas les colliders pendant le déplacement, ou s'en éloigne après un contact au départ.
+     */
+    bool sweep(Real x,Real y,Real dx,Real dy,Real radius,Real& t) const;
+
+    /**
+     * @brief Distance signée exacte aux colliders et son gradient, plafonnée à margin: la valeur que la grille échantillonne.
+     * @param nearest Identifiant du collider le plus proche (voir ColliderSet), UINT32_MAX au-delà de margin.
+     */
+    static double exactDistance(const BasicColliderSet<Real>& colliders,const ColliderSDFSettings& settings,double x,double y,
+                                double& gx,double& gy,std::uint32_t& nearest);
+
+    /**
+     * @brief Compare la grille au calcul exact en des points tirés au hasard près des colliders.
+     * @param colliders Les colliders sur lesquels la grille a été calculée.
+     * @param radius Rayon des particules pour la comparaison des contacts avec checkContact.
+     * @param samples Nombre de points.
+     * @param seed Graine du tirage.
+     */
+    SDFError measureError(const BasicColliderSet<Real>& colliders,double radius,std::size_t samples,std::uint64_t seed) const;
+
+private:
+    /**
+     * @struct Node
+     * @brief Valeurs d'un noeud de la grille.
+     */
+    struct Node {
+        Real phi; /**< Distance signée */
+        Real gx;  /**< Gradient selon x */
+        Real gy;  /**< Gradient selon y */
+    };
+
+    std::vector<Node> nodes; /**< Noeuds, ligne par ligne */
+    std::size_t cols=0;
+    std::size_t n_rows=0;
+    double x0=0; /**< Position du premier noeud */
+    double y0=0;
+    double cell=1; /**< Pas de la grille */
+    Real inv_cell=1;
+    std::size_t collider_count=0;
+    ColliderSDFSettings settings;
+};
+
+using ColliderSDF=BasicColliderSDF<double>;
+using ColliderSDFF=BasicColliderSDF<float>;
+
+#endif // SDF_H
@@ -0,0 +1,92 @@
+/******************************************************************************
+ * @file simulationthread.cpp
+ * @brief Implémentation des méthodes de la classe SimulationThread définies dans simulationthread.h
+ ******************************************************************************/
+
+#include "simulationthread.h"
+#include <algorithm>
+#include <chrono>
+
+void SimulationThread::start(){
+    if (worker.joinable()){return;}
+    stop_requested=false;
+    publishSnapshot();
+    worker=std::thread(&SimulationThread::run,this);
+}
+
+void SimulationThread::stop(){
+    {
+        std::lock_guard<std::mutex> lock(command_mutex);
+        stop_requested=true;
+    }
+    command_cv.notify_all();
+    if (worker.joinable()){worker.join();}
+}
+
+void SimulationThread::post(Command command){
+    {
+        std::lock_guard<std::mutex> lock(command_mutex);
+        pending.push_back(std::move(command));
+    }
+    command_cv.notify_all();
+}
+
+/**
+* @brief Copie les positions, les rayons et les colliders dans le tampon libre puis le publie
+*/
+void SimulationThread::publishSnapshot(){
+    RenderSnapshot& s=snapshots.writing();
+    s.step=steps.load(std::memory_order_relaxed);
+    // Les affectations réutilisent la mémoire des tampons: pas d'allocation une fois la taille atteinte
+    s.x=context.particles.x;
+    s.y=context.particles.y;
+    s.radius=context.particles.radius;
+    s.links.clear();
+    const DistanceConstraints& links=context.distances;
+    for (std::size_t k=0;k<links.size();k++){
+        if (!context.particles.valid(links.first[k]) || !context.particles.valid(links.second[k])){continue;}
+        s.links.push_back((std::uint32_t)context.particles.indexOf(links.first[k]));
+        s.links.push_back((std::uint32_t)context.particles.indexOf(links.second[k]));
+    }
+    s.colliders=context.colliders;
+    snapshots.publish();
+}
+
+/**
+* @brief Boucle du thread: commandes, pas fixes rattrapant le temps réel écoulé, publication, attente du pas suivant
+*/
+void SimulationThread::run(){
+    using clock=std::chrono::steady_clock;
+    const auto period=std::chrono::duration<double>(step_period);
+    auto previous=clock::now();
+    double accumulator=0;
+
+    while (true){
+        {
+            std::lock_guard<std::mutex> lock(command_mutex);
+            if (stop_requested){return;}
+            running.swap(pending);
+        }
+        for (Command& command:running){command(context);}
+        bool changed=!running.empty();
+        running.clear();
+
+        auto now=clock::now();
+        accumulator+=std::chrono::duration<double>(now-previous).count();
+        previous=now;
+        int n=0;
+        while (accumulator>=step_period && n<max_steps_per_tick){
+            context.updatePhysicalSystem((float)step_dt);
+            steps.fetch_add(1,std::memory_order_relaxed);
+            accumulator-=step_period;
+            n++;
+        }
+        if (n==max_steps_per_tick){accumulator=std::min(accumulator,step_period);}
+        if (n>0 || changed){publishSnapshot();}
+
+        // On dort jusqu'au pas suivant, ou jusqu'à l'arrivée d'une commande
+        auto next=now+std::chrono::duration_cast<clock::duration>(period*(1-accumulator/step_period));
+        std::unique_lock<std::mutex> lock(command_mutex);
+        command_cv.wait_until(lock,next,[this]{return stop_requested || !pending.empty();});
+    }
+}
@@ -0,0 +1,154 @@
+/******************************************************************************
+ * @file simulationthread.h
+ * @brief Définition de la classe SimulationThread qui fait avancer un Context sur son propre thread.
+ *
+ * Le thread exécute des pas de temps fixes, au rythme du temps réel (accumulateur), et publie
+ * après chaque série de pas une copie des positions (RenderSnapshot) dans un triple tampon sans
+ * verrou: l'affichage lit toujours la dernière copie complète sans jamais attendre la simulation,
+ * et la simulation n'attend jamais l'affichage. Les commandes de l'interface (réinitialisation,
+ * frottement, gravité, ajout de particule) passent par une file et sont exécutées par le thread
+ * de simulation entre deux pas.
+ ******************************************************************************/
+
+#ifndef SIMULATIONTHREAD_H
+#define SIMULATIONTHREAD_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Context.h"
+
+/**
+ * @class TripleBuffer
+ * @brief Échange sans verrou de valeurs entre un seul producteur et un seul consommateur.
+ *
+ * Le producteur remplit writing() puis appelle publish(); le consommateur appelle update() puis lit
+ * reading(). Les trois tampons ne sont jamais réalloués: une valeur publiée n'est plus modifiée
+ * tant que le consommateur la lit.
+ */
+template <class T>
+class TripleBuffer {
+private:
+    static constexpr unsigned index_mask=3;
+    static constexpr unsigned fresh_bit=4; /**< Le tampon du milieu contient une valeur pas encore lue */
+    T buffers[3];
+    std::atomic<unsigned> middle{1}; /**< Tampon échangé entre les deux côtés, et fresh_bit */
+    unsigned write_index=0; /**< Tampon du producteur */
+    unsigned read_index=2; /**< Tampon du consommateur */
+
+public:
+    /**
+     * @brief Tampon à remplir par le producteur.
+     */
+    T& writing(){return buffers[write_index];}
+
+    /**
+     * @brief Rend le tampon rempli visible au consommateur et en reprend un autre.
+     */
+    void publish(){write_index=middle.exchange(write_index|fresh_bit,std::memory_order_acq_rel)&index_mask;}
+
+    /**
+     * @brief Récupère la dernière valeur publiée s'il y en a une nouvelle.
+     * @return true si reading() a changé.
+     */
+    bool update(){
+        if (!(middle.load(std::memory_order_relaxed)&fresh_bit)){return false;}
+        read_index=middle.exchange(read_index,std::memory_order_acq_rel)&index_mask;
+        return true;
+    }
+
+    /**
+     * @brief Dernière valeur récupérée par update().
+     */
+    const T& reading() const {return buffers[read_index];}
+};
+
+/**
+ * @struct RenderSnapshot
+ * @brief Ce qu'il faut pour dessiner un pas de simulation.
+ */
+struct RenderSnapshot {
+    std::uint64_t step=0; /**< Nombre de pas effectués */
+    std::vector<double> x; /**< Positions des particules */
+    std::vector<double> y;
+    std::vector<double> radius; /**< Rayons des particules */
+    std::vector<std::uint32_t> links; /**< Liens de distance: indices des deux particules de chaque lien, à la suite */
+    ColliderSet colliders; /**< Colliders, qui peuvent changer par une commande */
+};
+
+/**
+ * @class SimulationThread
+ * @brief Thread de simulation à pas fixe, piloté par une file de commandes.
+ *
+ * Une fois start() appelé, le Context ne doit plus être utilisé que par le thread de simulation,
+ * à travers post(). snapshot() ne doit être appelé que depuis un seul thread (celui de l'affichage).
+ */
+class SimulationThread {
+public:
+    using Command=std::function<void(Context&)>;
+
+private:
+    Context& context; /**< Contexte simulé, qui doit vivre plus longtemps que le thread */
+    double step_dt; /**< Pas de temps passé à updatePhysicalSystem */
+    double step_period; /**< Durée réelle d'un pas, en secondes */
+    int max_steps_per_tick=5; /**< Au delà, le retard est abandonné pour ne pas s'emballer si un pas dure plus que step_period */
+    TripleBuffer<RenderSnapshot> snapshots;
+    std::mutex command_mutex;
+    std::condition_variable command_cv;
+    std::vector<Command> pending; /**< Commandes en attente, protégées par command_mutex */
+    std::vector<Command> running; /**< Commandes en cours d'exécution (thread de simulation seulement) */
+    bool stop_requested=false; /**< Protégé par command_mutex */
+    std::atomic<std::uint64_t> steps{0};
+    std::thread worker;
+
+    void run();
+    void publishSnapshot();
+
+public:
+    /**
+     * @brief Constructeur, le thread n'est pas encore lancé.
+     * @param context Le contexte à simuler.
+     * @param step_dt Pas de temps de la simulation.
+     * @param step_period Durée réelle d'un pas, en secondes.
+     */
+    SimulationThread(Context& context,double step_dt,double step_period) : context(context), step_dt(step_dt), step_period(step_period) {}
+
+    /**
+     * @brief Arrête le thread.
+     */
+    ~SimulationThread(){stop();}
+
+    SimulationThread(const SimulationThread&)=delete;
+    SimulationThread& operator=(const SimulationThread&)=delete;
+
+    /**
+     * @brief Publie l'état initial et lance le thread.
+     */
+    void start();
+
+    /**
+     * @brief Arrête le thread et attend sa fin. Les commandes en attente ne sont pas exécutées.
+     */
+    void stop();
+
+    /**
+     * @brief Ajoute une commande, exécutée par le thread de simulation avant le prochain pas.
+     */
+    void post(Command command);
+
+    /**
+     * @brief Dernière copie publiée. Le résultat reste valide jusqu'au prochain appel.
+     */
+    const RenderSnapshot& snapshot(){snapshots.update();return snapshots.reading();}
+
+    /**
+     * @brief Nombre de pas effectués depuis start().
+     */
+    std::uint64_t stepCount() const {return steps.load(std::memory_order_relaxed);}
+};
+
+#endif // SIMULATIONTHREAD_H
@@ -0,0 +1,78 @@
+/******************************************************************************
+ * @file slabchannel.cpp
+ * @brief Implémentation de la classe SlabChannel définie dans slabchannel.h
+ ******************************************************************************/
+
+#include "slabchannel.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+SlabChannel::~SlabChannel(){
+    if (fd>=0){::close(fd);}
+}
+
+bool SlabChannel::socketPair(int fds[2]){
+    return ::socketpair(AF_UNIX,SOCK_STREAM,0,fds)==0;
+}
+
+static bool fail(std::string* error,const char* what){
+    if (error){*error=std::string(what)+": "+(errno!=0?std::strerror(errno):"connexion fermée par le voisin");}
+    return false;
+}
+
+bool SlabChannel::exchange(const std::vector<unsigned char>& out,std::vector<unsigned char>& in,std::string* error){
+    // Chaque message est précédé de sa taille sur 8 octets
+    const std::uint64_t out_size=out.size();
+    unsigned char in_header[8];
+    std::uint64_t in_size=0;
+    std::size_t sent=0,received=0;
+    const std::size_t to_send=8+out.size();
+    bool header_done=false;
+    while (sent<to_send || !header_done || received<in_size){
+        pollfd p{fd,0,0};
+        if (sent<to_send){p.events|=POLLOUT;}
+        if (!header_done || received<in_size){p.events|=POLLIN;}
+        if (::poll(&p,1,-1)<0){
+            if (errno==EINTR){continue;}
+            return fail(error,"poll");
+        }
+        if (p.revents&(POLLERR|POLLNVAL)){errno=0; return fail(error,"échange");}
+        if ((p.revents&POLLOUT) && sent<to_send){
+            const void* data;
+            std::size_t length;
+            if (sent<8){data=reinterpret_cast<const unsigned char*>(&out_size)+sent; length=8-sent;}
+            else {data=out.data()+(sent-8); length=to_send-sent;}
+            // Sans attente: une socket pleine rend la main pour lire ce que le voisin envoie pendant ce temps
+            ssize_t n=::send(fd,data,length,MSG_NOSIGNAL|MSG_DONTWAIT);
+            if (n<0 && errno!=EINTR && errno!=EAGAIN){return fail(error,"send");}
+            if (n>0){sent+=(std::size_t)n;}
+        }
+        if (p.revents&(POLLIN|POLLHUP)){
+            ssize_t n;
+            if (!header_done){
+                n=::recv(fd,in_header+received,8-received,0);
+                if (n>0){
+                    received+=(std::size_t)n;
+                    if (received==8){
+                        std::memcpy(&in_size,in_header,8);
+                        in.resize(in_size);
+                        header_done=true;
+                        received=0;
+                    }
+                }
+            }else if (received<in_size){
+                n=::recv(fd,in.data()+received,in_size-received,0);
+                if (n>0){received+=(std::size_t)n;}
+            }else{
+                continue;
+            }
+            if (n==0){errno=0; return fail(error,"recv");}
+            if (n<0 && errno!=EINTR && errno!=EAGAIN){return fail(error,"recv");}
+        }
+    }
+    return true;
+}
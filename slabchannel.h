@@ -0,0 +1,50 @@
+/******************************************************************************
+ * @file slabchannel.h
+ * @brief Définition de la classe SlabChannel, le lien entre deux processus voisins d'une simulation
+ * découpée en tranches (voir slabdomain.h).
+ *
+ * Le lien est une socket Unix connectée (socketpair avant fork, voir tools/pbd_slabs.cpp). Chaque échange
+ * envoie un message et reçoit celui du voisin en même temps (poll sur la socket): deux voisins qui
+ * s'envoient de gros messages ne se bloquent pas mutuellement quand les tampons du noyau sont pleins.
+ * Disponible seulement sur les systèmes POSIX.
+ ******************************************************************************/
+
+#ifndef SLABCHANNEL_H
+#define SLABCHANNEL_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @class SlabChannel
+ * @brief Échange de messages de taille quelconque avec le processus voisin, à travers une socket connectée.
+ */
+class SlabChannel {
+public:
+    /**
+     * @brief Prend possession d'une extrémité de socket connectée (fermée par le destructeur).
+     */
+    explicit SlabChannel(int fd) : fd(fd) {}
+    ~SlabChannel();
+    SlabChannel(const SlabChannel&)=delete;
+    SlabChannel& operator=(const SlabChannel&)=delete;
+
+    /**
+     * @brief Crée deux extrémités de socket Unix connectées l'une à l'autre, à répartir entre deux processus.
+     * @return false si la création échoue (voir errno).
+     */
+    static bool socketPair(int fds[2]);
+
+    /**
+     * @brief Envoie out au voisin et reçoit son message dans in, les deux en même temps.
+     * Le voisin doit appeler exchange de son côté; in garde sa capacité d'un échange à l'autre.
+     * @param error Message d'erreur si l'échange échoue, peut être nullptr.
+     * @return false si la socket est fermée ou en erreur.
+     */
+    bool exchange(const std::vector<unsigned char>& out,std::vector<unsigned char>& in,std::string* error);
+
+private:
+    int fd;
+};
+
+#endif // SLABCHANNEL_H
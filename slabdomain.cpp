@@ -0,0 +1,196 @@
+/******************************************************************************
+ * @file slabdomain.cpp
+ * @brief Implémentation de la classe SlabDomain définie dans slabdomain.h
+ ******************************************************************************/
+
+#include "slabdomain.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+template <class Real>
+bool BasicSlabDomain<Real>::partition(std::string* error){
+    if (settings.count==0 || settings.rank>=settings.count){
+        if (error){*error="tranche "+std::to_string(settings.rank)+" hors du découpage en "+std::to_string(settings.count);}
+        return false;
+    }
+    if (!context.distances.empty()){
+        if (error){*error="les liens de distance ne sont pas pris en charge par le découpage en tranches";}
+        return false;
+    }
+    // La mise en sommeil réordonne les particules: les fantômes ne seraient plus en fin de tableaux
+    if (context.sleepSettings().enabled){
+        SleepSettings sleep=context.sleepSettings();
+        sleep.enabled=false;
+        // Le solveur reste celui de la scène, même si la mise en sommeil avait activé XPBD
+        const XPBDSettings xpbd=context.xpbdSettings();
+        context.setSleep(sleep);
+        context.setXPBD(xpbd);
+    }
+
+    // Bornes calculées de la même façon par tous les processus, à partir de la même scène
+    BasicParticleStore<Real>& particles=context.particles;
+    const std::size_t n=particles.size(),count=settings.count;
+    std::vector<double> cuts(count+1);
+    cuts[0]=-std::numeric_limits<double>::infinity();
+    cuts[count]=std::numeric_limits<double>::infinity();
+    if (settings.balanced && n>=count){
+        std::vector<double> xs(particles.x.begin(),particles.x.end());
+        std::sort(xs.begin(),xs.end());
+        for (std::size_t k=1;k<count;k++){cuts[k]=xs[k*n/count];}
+    }else{
+        for (std::size_t k=1;k<count;k++){cuts[k]=(double)context.width*k/count;}
+    }
+    // Chaque tranche intérieure doit être plus large que la zone des fantômes au repos (deux rayons): sinon (abscisses
+    // répétées, plus de tranches que d'abscisses distinctes) ses deux voisines pourraient se toucher sans rien s'échanger
+    Real max_radius=0;
+    for (std::size_t i=0;i<n;i++){max_radius=std::max(max_radius,particles.radius[i]);}
+    for (std::size_t k=1;k+1<count;k++){
+        if (!(cuts[k+1]-cuts[k]>2*(double)max_radius)){
+            if (error){*error="découpage en "+std::to_string(count)+" tranches trop fin: la tranche "+std::to_string(k)
+                               +" n'est pas plus large que deux rayons";}
+            return false;
+        }
+    }
+    min_x=cuts[settings.rank];
+    max_x=cuts[settings.rank+1];
+
+    // On parcourt les particules à rebours: la dernière, qui prend la place d'une particule supprimée, a déjà été vue
+    for (std::size_t i=n;i-->0;){
+        if (!((double)particles.x[i]>=min_x && (double)particles.x[i]<max_x)){particles.remove(particles.handleAt(i));}
+    }
+    context.streams.erase(std::remove_if(context.streams.begin(),context.streams.end(),[&](const ParticleStream& s){return !(s.x>=min_x && s.x<max_x);}),
+                          context.streams.end());
+    return true;
+}
+
+/**
+* @brief Borne du déplacement prédit de la particule i selon x pendant le pas: vitesse et gravité. Les tranches
+* ne sont séparées que selon x: une chute verticale, même rapide, n'élargit pas la zone des fantômes.
+*/
+template <class Real>
+Real BasicSlabDomain<Real>::displacement(std::size_t i,Real dt,Real g) const{
+    return std::fabs(context.particles.vx[i])*dt+g*dt*dt;
+}
+
+template <class Real>
+void BasicSlabDomain<Real>::pack(std::vector<unsigned char>& out,std::size_t i) const{
+    const BasicParticleStore<Real>& particles=context.particles;
+    Record r{particles.x[i],particles.y[i],particles.vx[i],particles.vy[i],particles.radius[i],particles.inv_mass[i]};
+    const unsigned char* bytes=reinterpret_cast<const unsigned char*>(&r);
+    out.insert(out.end(),bytes,bytes+sizeof(Record));
+}
+
+template <class Real>
+void BasicSlabDomain<Real>::unpack(const std::vector<unsigned char>& in,std::size_t offset,bool ghost){
+    BasicParticleStore<Real>& particles=context.particles;
+    for (std::size_t k=offset;k+sizeof(Record)<=in.size();k+=sizeof(Record)){
+        Record r;
+        std::memcpy(&r,in.data()+k,sizeof(Record));
+        basic_particle<Real> p;
+        p.pos={r.x,r.y};
+        p.velocity={r.vx,r.vy};
+        p.radius=r.radius;
+        p.mass=r.inv_mass>0?1/r.inv_mass:0;
+        ParticleHandle h=particles.add(p);
+        // 1/(1/m) peut différer de l'inverse envoyé: on garde celui du propriétaire, au bit près
+        particles.inv_mass[particles.indexOf(h)]=r.inv_mass;
+        if (ghost){ghosts.push_back(h);}
+    }
+}
+
+template <class Real>
+bool BasicSlabDomain<Real>::exchange(SlabChannel* channel,std::vector<unsigned char>& out,std::vector<unsigned char>& in,std::string* error){
+    if (!channel){
+        in.clear();
+        return true;
+    }
+    return channel->exchange(out,in,error);
+}
+
+template <class Real>
+bool BasicSlabDomain<Real>::step(float dt,std::string* error){
+    BasicParticleStore<Real>& particles=context.particles;
+    const Real h=Real(dt);
+    const Real g=std::fabs(context.champ_de_force[0]);
+    const std::size_t header=2*sizeof(Real);
+    ghosts.clear();
+
+    // 1. Migrations, précédées du plus grand rayon et du plus grand déplacement des particules restantes
+    out_left.assign(header,0);
+    out_right.assign(header,0);
+    migrated=0;
+    Real migrated_left[2]={0,0},migrated_right[2]={0,0};
+    for (std::size_t i=particles.size();i-->0;){
+        const double x=particles.x[i];
+        const bool to_left=x<min_x && left;
+        if (!to_left && !(x>=max_x && right)){continue;}
+        Real* limits=to_left?migrated_left:migrated_right;
+        limits[0]=std::max(limits[0],particles.radius[i]);
+        limits[1]=std::max(limits[1],displacement(i,h,g));
+        pack(to_left?out_left:out_right,i);
+        particles.remove(particles.handleAt(i));
+        migrated++;
+    }
+    Real limits[2]={0,0};
+    for (std::size_t i=0;i<particles.size();i++){
+        limits[0]=std::max(limits[0],particles.radius[i]);
+        limits[1]=std::max(limits[1],displacement(i,h,g));
+    }
+    std::memcpy(out_left.data(),limits,header);
+    std::memcpy(out_right.data(),limits,header);
+    if (!exchange(left,out_left,in_left,error) || !exchange(right,out_right,in_right,error)){return false;}
+    Real left_limits[2]={0,0},right_limits[2]={0,0};
+    if (in_left.size()>=header){std::memcpy(left_limits,in_left.data(),header);}
+    if (in_right.size()>=header){std::memcpy(right_limits,in_right.data(),header);}
+    // Le voisin a calculé ses bornes avant de recevoir nos migrations: ces particules, rapides et près du bord, en font
+    // désormais partie
+    for (int k=0;k<2;k++){
+        left_limits[k]=std::max(left_limits[k],migrated_left[k]);
+        right_limits[k]=std::max(right_limits[k],migrated_right[k]);
+    }
+    unpack(in_left,header,false);
+    unpack(in_right,header,false);
+
+
+    // 2. Fantômes: les particules qui peuvent toucher une particule du voisin pendant le pas
+    out_left.clear();
+    out_right.clear();
+    for (std::size_t i=0;i<particles.size();i++){
+        const Real reach=particles.radius[i]+displacement(i,h,g);
+        const double x=particles.x[i];
+        if (left && x-min_x<reach+left_limits[0]+left_limits[1]){pack(out_left,i);}
+        if (right && max_x-x<reach+right_limits[0]+right_limits[1]){pack(out_right,i);}
+    }
+    if (!exchange(left,out_left,in_left,error) || !exchange(right,out_right,in_right,error)){return false;}
+    unpack(in_left,0,true);
+    const std::size_t left_ghosts=ghosts.size();
+    unpack(in_right,0,true);
+
+    // Une particule d'un voisin qui peut toucher une particule de l'autre voisin par-dessus la tranche ne serait vue
+    // par aucun des deux, qui ne s'échangent rien. Si la tranche est plus large que la zone des fantômes de chaque
+    // voisin, deux telles particules sont forcément des fantômes ici: il suffit de comparer les fronts des fantômes
+    if (left && right){
+        const double widest=std::max(left_limits[0]+left_limits[1],right_limits[0]+right_limits[1]);
+        double left_front=-std::numeric_limits<double>::infinity(),right_front=std::numeric_limits<double>::infinity();
+        for (std::size_t k=0;k<ghosts.size();k++){
+            const std::size_t i=particles.indexOf(ghosts[k]);
+            const double reach=particles.radius[i]+displacement(i,h,g);
+            if (k<left_ghosts){left_front=std::max(left_front,particles.x[i]+reach);}
+            else {right_front=std::min(right_front,particles.x[i]-reach);}
+        }
+        if (max_x-min_x<=widest || left_front>right_front){
+            if (error){*error="tranche plus étroite que la zone des fantômes (particules trop rapides pour ce découpage)";}
+            return false;
+        }
+    }
+
+    // 3. Pas du contexte, fantômes compris, puis 4. retrait des fantômes
+    context.updatePhysicalSystem(dt);
+    for (ParticleHandle ghost:ghosts){particles.remove(ghost);}
+    return true;
+}
+
+template class BasicSlabDomain<float>;
+template class BasicSlabDomain<double>;
@@ -0,0 +1,110 @@
+/******************************************************************************
+ * @file slabdomain.h
+ * @brief Définition de la classe SlabDomain: un Context qui ne simule qu'une tranche verticale du monde,
+ * en échangeant chaque pas ses particules de bord avec les processus voisins.
+ *
+ * Le monde est découpé selon x en tranches [min_x,max_x), une par processus, la première et la dernière
+ * s'étendant à l'infini. Tous les processus chargent la même scène; partition() ne garde dans chaque
+ * contexte que les particules et les sources de sa tranche (les colliders restent tous). À chaque pas:
+ * 1. les particules sorties de la tranche migrent vers le voisin de ce côté (d'une tranche au plus par pas);
+ * 2. les particules proches d'un bord sont envoyées au voisin comme particules fantômes: assez proches
+ *    pour toucher une de ses particules pendant le pas (somme des rayons et des déplacements prédits, le
+ *    plus grand rayon et le plus grand déplacement selon x du voisin étant reçus avec les migrations, puis complétés par
+ *    ceux des particules qu'on vient de lui envoyer);
+ * 3. le contexte simule ses particules et les fantômes, qui voient les contacts des deux côtés du bord;
+ * 4. les fantômes sont retirés: leur propriétaire a calculé leur propre mouvement.
+ *
+ * Un contact entre deux tranches est donc résolu des deux côtés, chaque processus n'appliquant la correction
+ * qu'à sa particule, comme le solveur Jacobi (SolverMode::Jacobi) à l'intérieur d'un processus. Le résultat
+ * est déterministe pour un découpage donné, mais diffère de celui d'un seul processus (un seul processus donne
+ * exactement la simulation du contexte seul, mise en sommeil désactivée). Une tranche doit être plus large que la zone
+ * des fantômes: partition() refuse un découpage dont une tranche intérieure n'est pas plus large que deux rayons
+ * (abscisses répétées, plus de tranches que d'abscisses distinctes), et step() échoue si la zone des fantômes,
+ * qui grandit avec les vitesses, dépasse la largeur de la tranche.
+ * Les liens de distance et la mise en sommeil ne sont pas pris en charge: partition() refuse une scène avec
+ * des liens et désactive la mise en sommeil.
+ ******************************************************************************/
+
+#ifndef SLABDOMAIN_H
+#define SLABDOMAIN_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "Context.h"
+#include "slabchannel.h"
+
+/**
+ * @struct SlabSettings
+ * @brief Place d'un processus dans le découpage en tranches.
+ */
+struct SlabSettings {
+    unsigned rank=0;   /**< Numéro de la tranche, de gauche à droite */
+    unsigned count=1;  /**< Nombre de tranches (de processus) */
+    bool balanced=true; /**< Vrai: bornes aux quantiles des abscisses des particules de la scène (autant de particules par
+                             tranche au départ), faux: tranches de même largeur sur la largeur du monde */
+};
+
+/**
+ * @class BasicSlabDomain
+ * @brief Une tranche du monde simulée par un contexte, reliée à ses voisines par des SlabChannel.
+ */
+template <class Real>
+class BasicSlabDomain {
+public:
+    /**
+     * @param context Contexte chargé avec la scène complète, simulé par cette tranche.
+     * @param left Lien vers la tranche de gauche, nullptr pour la première.
+     * @param right Lien vers la tranche de droite, nullptr pour la dernière.
+     */
+    BasicSlabDomain(BasicContext<Real>& context,const SlabSettings& settings,SlabChannel* left,SlabChannel* right)
+        : context(context), settings(settings), left(left), right(right) {}
+
+    /**
+     * @brief Calcule les bornes de la tranche et retire du contexte les particules et les sources des autres tranches.
+     * Tous les processus doivent appeler partition sur la même scène.
+     * @return false si la scène a des liens de distance ou si le découpage est invalide (tranche intérieure trop étroite).
+     */
+    bool partition(std::string* error);
+
+    /**
+     * @brief Avance la tranche d'un pas: migrations, échange des fantômes, pas du contexte, retrait des fantômes.
+     * Les voisins doivent appeler step en même temps, avec le même dt.
+     * @return false si un échange avec un voisin échoue ou si la zone des fantômes dépasse la largeur de la tranche.
+     */
+    bool step(float dt,std::string* error);
+
+    double minX() const {return min_x;} /**< Borne gauche de la tranche (-infini pour la première) */
+    double maxX() const {return max_x;} /**< Borne droite de la tranche (+infini pour la dernière) */
+    std::size_t lastMigrated() const {return migrated;} /**< Particules parties vers les voisins au dernier pas */
+    std::size_t lastGhosts() const {return ghosts.size();} /**< Fantômes reçus des voisins au dernier pas */
+
+private:
+    /**
+     * @struct Record
+     * @brief Particule telle qu'elle est envoyée au voisin, dans la précision du contexte.
+     */
+    struct Record {
+        Real x,y,vx,vy,radius,inv_mass;
+    };
+
+    BasicContext<Real>& context;
+    SlabSettings settings;
+    SlabChannel* left;
+    SlabChannel* right;
+    double min_x=0;
+    double max_x=0;
+    std::size_t migrated=0;
+    std::vector<ParticleHandle> ghosts; /**< Fantômes ajoutés au contexte pendant le pas */
+    std::vector<unsigned char> out_left,out_right,in_left,in_right; /**< Messages, gardant leur capacité d'un pas à l'autre */
+
+    Real displacement(std::size_t i,Real dt,Real g) const;
+    void pack(std::vector<unsigned char>& out,std::size_t i) const;
+    void unpack(const std::vector<unsigned char>& in,std::size_t offset,bool ghost);
+    bool exchange(SlabChannel* channel,std::vector<unsigned char>& out,std::vector<unsigned char>& in,std::string* error);
+};
+
+using SlabDomain=BasicSlabDomain<double>;
+using SlabDomainF=BasicSlabDomain<float>;
+
+#endif // SLABDOMAIN_H
@@ -0,0 +1,65 @@
+/******************************************************************************
+ * @file stepbuffers.h
+ * @brief Redimensionnement des tampons de travail d'un pas de simulation.
+ *
+ * Les données temporaires d'un pas (contacts, couleurs, multiplicateurs, cellules de la grille...)
+ * sont des std::vector membres qui gardent leur capacité d'un pas à l'autre: les vider est immédiat
+ * (leurs éléments n'ont pas de destructeur) et leur capacité est le maximum atteint depuis le début.
+ * Une fois ce maximum atteint, un pas n'alloue plus de mémoire. Context::reserveStepBuffers leur donne dès le
+ * chargement la capacité prévue pour le nombre de particules, pour que ce maximum ne soit pas atteint en cours de route.
+ *
+ * std::vector::assign alloue exactement la taille demandée: un tampon qui grandit un peu à chaque pas
+ * (une fontaine qui ajoute des particules) serait réalloué à chaque pas. Ces fonctions doublent au
+ * moins la capacité, comme push_back, pour que les réallocations restent en nombre logarithmique.
+ ******************************************************************************/
+
+#ifndef STEPBUFFERS_H
+#define STEPBUFFERS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+/**
+ * @brief Prépare un tampon à recevoir n éléments, en doublant au moins sa capacité s'il faut la dépasser
+ */
+template <class T>
+inline void reserveStepBuffer(std::vector<T>& buffer,std::size_t n){
+    if (n>buffer.capacity()){buffer.reserve(std::max(n,2*buffer.capacity()));}
+}
+
+/**
+ * @brief Donne au tampon n éléments égaux à value
+ */
+template <class T>
+inline void assignStepBuffer(std::vector<T>& buffer,std::size_t n,const typename std::vector<T>::value_type& value){
+    reserveStepBuffer(buffer,n);
+    buffer.assign(n,value);
+}
+
+/**
+ * @brief Copie [first,last) dans le tampon
+ */
+template <class T,class Iterator>
+inline void copyStepBuffer(std::vector<T>& buffer,Iterator first,Iterator last){
+    reserveStepBuffer(buffer,(std::size_t)std::distance(first,last));
+    buffer.assign(first,last);
+}
+
+/**
+ * @brief Donne au tampon n éléments, sans initialiser ceux qui étaient déjà là
+ */
+template <class T>
+inline void resizeStepBuffer(std::vector<T>& buffer,std::size_t n){
+    reserveStepBuffer(buffer,n);
+    buffer.resize(n);
+}
+
+/**
+ * @brief Mémoire réservée par un tampon, en octets
+ */
+template <class T>
+inline std::size_t stepBufferBytes(const std::vector<T>& buffer){return buffer.capacity()*sizeof(T);}
+
+#endif // STEPBUFFERS_H
@@ -0,0 +1,132 @@
+/******************************************************************************
+ * @file test_checkpoint.cpp
+ * @brief Test d'aller-retour des points de reprise (voir checkpoint.h).
+ *
+ * Usage: test_checkpoint <scène>...
+ *
+ * Pour chaque scène, en double puis en float: on simule quelques pas, on retire quelques particules (emplacements
+ * de poignées libres), on sauve, puis on simule encore. Les sources continues font partie de l'empreinte: une
+ * source reprise avec un mauvais compte de particules émises est détectée dès le chargement. Un second contexte chargé avec la même scène puis avec le
+ * point de reprise doit arriver à la même empreinte (Context::stateHash) à chaque pas. Enfin, un point de reprise
+ * dont la table des emplacements est forgée doit être refusé sans toucher au contexte, même sans somme de contrôle,
+ * tout comme un point de reprise d'une version plus récente.
+ * Code de retour 0 si tout est conforme, 1 sinon.
+ ******************************************************************************/
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../checkpoint.h"
+#include "../scene.h"
+
+static const long warmup_steps=40;
+static const long compared_steps=40;
+static const float dt=0.2f;
+
+static bool failed(const std::string& scene,const char* real,const std::string& what){
+    std::fprintf(stderr,"test_checkpoint: %s (%s): %s\n",scene.c_str(),real,what.c_str());
+    return false;
+}
+
+static bool readFile(const std::string& path,std::vector<unsigned char>& bytes){
+    FILE* file=std::fopen(path.c_str(),"rb");
+    if (!file){return false;}
+    unsigned char buffer[65536];
+    std::size_t n;
+    bytes.clear();
+    while ((n=std::fread(buffer,1,sizeof(buffer),file))>0){bytes.insert(bytes.end(),buffer,buffer+n);}
+    std::fclose(file);
+    return true;
+}
+
+static bool writeFile(const std::string& path,const std::vector<unsigned char>& bytes){
+    FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file){return false;}
+    bool ok=std::fwrite(bytes.data(),1,bytes.size(),file)==bytes.size();
+    return std::fclose(file)==0 && ok;
+}
+
+/**
+* @brief Fait pointer la première particule vers un emplacement hors de la table (bloc BlockIndexSlot, numéro 11)
+* @return false si le bloc n'est pas trouvé
+*/
+static bool forgeIndexSlot(std::vector<unsigned char>& bytes){
+    const std::size_t header_size=112,entry_size=24,block_count_offset=104;
+    if (bytes.size()<header_size){return false;}
+    std::uint32_t block_count;
+    std::memcpy(&block_count,bytes.data()+block_count_offset,4);
+    for (std::uint32_t b=0;b<block_count;b++){
+        const std::size_t entry=header_size+b*entry_size;
+        if (entry+entry_size>bytes.size()){return false;}
+        std::uint32_t id;
+        std::uint64_t offset,count;
+        std::memcpy(&id,bytes.data()+entry,4);
+        std::memcpy(&offset,bytes.data()+entry+8,8);
+        std::memcpy(&count,bytes.data()+entry+16,8);
+        if (id!=11 || count==0 || offset+4>bytes.size()){continue;}
+        const std::uint32_t forged=0x7fffffffu;
+        std::memcpy(bytes.data()+offset,&forged,4);
+        return true;
+    }
+    return false;
+}
+
+template <class Real>
+static bool roundTrip(const std::string& scene,const char* real){
+    const std::string path="test_checkpoint_"+std::string(real)+".ckpt";
+    const std::string forged_path="test_checkpoint_"+std::string(real)+"_forged.ckpt";
+    std::string error;
+
+    BasicContext<Real> original;
+    if (!loadScene(scene,original,&error)){return failed(scene,real,error);}
+    for (long s=0;s<warmup_steps;s++){original.updatePhysicalSystem(dt);}
+    // Quelques emplacements libres, pour que la table des emplacements libres fasse partie de l'aller-retour
+    for (std::size_t k=0;k<3 && original.particles.size()>1 && original.distances.empty();k++){
+        original.particles.remove(original.particles.handleAt(original.particles.size()/2));
+    }
+    if (!saveCheckpoint(original,path,&error)){return failed(scene,real,error);}
+
+    BasicContext<Real> restored;
+    if (!loadScene(scene,restored,&error) || !loadCheckpoint(path,restored,&error)){return failed(scene,real,error);}
+    if (restored.stateHash()!=original.stateHash()){return failed(scene,real,"empreinte différente après chargement");}
+    for (long s=0;s<compared_steps;s++){
+        original.updatePhysicalSystem(dt);
+        restored.updatePhysicalSystem(dt);
+        if (restored.stateHash()!=original.stateHash()){
+            return failed(scene,real,"empreinte différente au pas "+std::to_string(s)+" après la reprise");
+        }
+    }
+
+    std::vector<unsigned char> bytes;
+    if (!readFile(path,bytes) || !forgeIndexSlot(bytes) || !writeFile(forged_path,bytes)){
+        return failed(scene,real,"impossible de forger le point de reprise");
+    }
+    const std::uint64_t before=restored.stateHash();
+    if (loadCheckpoint(forged_path,restored,&error,false)){return failed(scene,real,"point de reprise forgé accepté");}
+    if (restored.stateHash()!=before){return failed(scene,real,"contexte modifié par un point de reprise refusé");}
+
+    // Un fichier d'une version plus récente porte de l'état inconnu: il est refusé
+    if (!readFile(path,bytes)){return failed(scene,real,"impossible de relire le point de reprise");}
+    const std::uint32_t newer=checkpoint_version+1;
+    std::memcpy(bytes.data()+8,&newer,4);
+    if (!writeFile(forged_path,bytes)){return failed(scene,real,"impossible d'écrire le point de reprise");}
+    if (loadCheckpoint(forged_path,restored,&error,false)){return failed(scene,real,"version plus récente acceptée");}
+    std::remove(path.c_str());
+    std::remove(forged_path.c_str());
+    return true;
+}
+
+int main(int argc,char* argv[]){
+    if (argc<2){
+        std::fprintf(stderr,"usage: test_checkpoint <scène>...\n");
+        return 2;
+    }
+    bool ok=true;
+    for (int a=1;a<argc;a++){
+        ok=roundTrip<double>(argv[a],"double") && ok;
+        ok=roundTrip<float>(argv[a],"float") && ok;
+    }
+    std::printf("test_checkpoint: %s\n",ok?"ok":"FAILED");
+    return ok?0:1;
+}
@@ -0,0 +1,147 @@
+/******************************************************************************
+ * @file test_trajectory.cpp
+ * @brief Test d'aller-retour des trajectoires (voir trajectory.h).
+ *
+ * Usage: test_trajectory <scène>...
+ *
+ * Pour chaque scène: on simule et on enregistre chaque pas en gardant les positions exactes, puis on relit
+ * les images dans l'ordre et dans le désordre. Chaque identifiant de poignée relu doit être celui de la particule
+ * enregistrée au même indice (les particules changent d'indice en s'endormant dans fountain.scene), et chaque
+ * position et chaque rayon à un demi-quantum près de la valeur enregistrée. Les mêmes vérifications sont faites sur le fichier privé de
+ * son index (enregistrement interrompu), puis un fichier dont l'index annonce un nombre de morceaux
+ * démesuré doit être refusé à l'ouverture.
+ * Code de retour 0 si tout est conforme, 1 sinon.
+ ******************************************************************************/
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../scene.h"
+#include "../trajectory.h"
+
+static const long recorded_steps=150;
+static const std::uint32_t frames_per_chunk=16;
+static const double quantum=1.0/64;
+static const float dt=0.2f;
+
+static bool failed(const std::string& scene,const std::string& what){
+    std::fprintf(stderr,"test_trajectory: %s: %s\n",scene.c_str(),what.c_str());
+    return false;
+}
+
+static bool readFile(const std::string& path,std::vector<unsigned char>& bytes){
+    FILE* file=std::fopen(path.c_str(),"rb");
+    if (!file){return false;}
+    unsigned char buffer[65536];
+    std::size_t n;
+    bytes.clear();
+    while ((n=std::fread(buffer,1,sizeof(buffer),file))>0){bytes.insert(bytes.end(),buffer,buffer+n);}
+    std::fclose(file);
+    return true;
+}
+
+static bool writeFile(const std::string& path,const std::vector<unsigned char>& bytes){
+    FILE* file=std::fopen(path.c_str(),"wb");
+    if (!file){return false;}
+    bool ok=std::fwrite(bytes.data(),1,bytes.size(),file)==bytes.size();
+    return std::fclose(file)==0 && ok;
+}
+
+/**
+* @brief Compare une image relue aux identifiants, positions et rayons enregistrés (identifiant, x, y, rayon entrelacés)
+*/
+static bool matches(const TrajectoryFrame& frame,const std::vector<double>& expected){
+    const std::size_t n=expected.size()/4;
+    if (frame.x.size()!=n || frame.id.size()!=n){return false;}
+    const double tolerance=quantum/2*(1+1e-9);
+    for (std::size_t i=0;i<n;i++){
+        if (frame.id[i]!=expected[4*i] || std::fabs(frame.x[i]-expected[4*i+1])>tolerance
+            || std::fabs(frame.y[i]-expected[4*i+2])>tolerance || std::fabs(frame.radius[i]-expected[4*i+3])>tolerance){return false;}
+    }
+    return true;
+}
+
+/**
+* @brief Relit toutes les images, dans l'ordre puis en commençant par la fin de chaque morceau
+*/
+static bool playBack(const std::string& scene,const std::string& path,const std::vector<std::vector<double>>& recorded){
+    TrajectoryPlayer player;
+    std::string error;
+    if (!player.open(path,&error)){return failed(scene,error);}
+    if (player.frameCount()!=recorded.size()){
+        return failed(scene,path+": "+std::to_string(player.frameCount())+" images relues au lieu de "+std::to_string(recorded.size()));
+    }
+    TrajectoryFrame frame;
+    for (std::uint64_t f=0;f<recorded.size();f++){
+        if (!player.readFrame(f,frame) || !matches(frame,recorded[f])){return failed(scene,path+": image "+std::to_string(f)+" différente");}
+    }
+    for (std::uint64_t f=recorded.size();f-->0;){
+        if (!player.readFrame(f,frame) || !matches(frame,recorded[f])){return failed(scene,path+": image "+std::to_string(f)+" différente en accès direct");}
+    }
+    if (player.readFrame(recorded.size(),frame)){return failed(scene,path+": image au delà de la fin acceptée");}
+    return true;
+}
+
+static bool roundTrip(const std::string& scene){
+    const std::string path="test_trajectory.traj";
+    const std::string unindexed_path="test_trajectory_unindexed.traj";
+    const std::string forged_path="test_trajectory_forged.traj";
+    std::string error;
+
+    Context context;
+    if (!loadScene(scene,context,&error)){return failed(scene,error);}
+    TrajectoryRecorder recorder;
+    if (!recorder.open(path,quantum,frames_per_chunk,8,&error)){return failed(scene,error);}
+    std::vector<std::vector<double>> recorded;
+    for (long s=0;s<recorded_steps;s++){
+        context.updatePhysicalSystem(dt);
+        recorder.record(context.particles);
+        std::vector<double> values(4*context.particles.size());
+        for (std::size_t i=0;i<context.particles.size();i++){
+            values[4*i]=context.particles.handleAt(i).id;
+            values[4*i+1]=context.particles.x[i];
+            values[4*i+2]=context.particles.y[i];
+            values[4*i+3]=context.particles.radius[i];
+        }
+        recorded.push_back(values);
+    }
+    if (!recorder.close(&error)){return failed(scene,error);}
+    if (!playBack(scene,path,recorded)){return false;}
+
+    // En-tête: frame_count à l'octet 24, chunk_count à 32, index_offset à 40 (voir trajectory.cpp)
+    std::vector<unsigned char> bytes;
+    if (!readFile(path,bytes) || bytes.size()<64){return failed(scene,"impossible de relire "+path);}
+    std::uint64_t index_offset;
+    std::memcpy(&index_offset,bytes.data()+40,8);
+    if (index_offset==0 || index_offset>bytes.size()){return failed(scene,"index absent");}
+
+    // Sans index ni compteurs, comme un enregistrement interrompu: l'index est reconstruit
+    std::vector<unsigned char> unindexed(bytes.begin(),bytes.begin()+index_offset);
+    std::memset(unindexed.data()+24,0,24);
+    if (!writeFile(unindexed_path,unindexed) || !playBack(scene,unindexed_path,recorded)){return false;}
+
+    // Un nombre de morceaux qui ne tient pas dans le fichier est refusé avant d'allouer l'index
+    const std::uint64_t forged_count=std::uint64_t(1)<<60;
+    std::memcpy(bytes.data()+32,&forged_count,8);
+    TrajectoryPlayer player;
+    if (!writeFile(forged_path,bytes)){return failed(scene,"impossible d'écrire "+forged_path);}
+    if (player.open(forged_path,&error)){return failed(scene,"index forgé accepté");}
+
+    std::remove(path.c_str());
+    std::remove(unindexed_path.c_str());
+    std::remove(forged_path.c_str());
+    return true;
+}
+
+int main(int argc,char* argv[]){
+    if (argc<2){
+        std::fprintf(stderr,"usage: test_trajectory <scène>...\n");
+        return 2;
+    }
+    bool ok=true;
+    for (int a=1;a<argc;a++){ok=roundTrip(argv[a]) && ok;}
+    std::printf("test_trajectory: %s\n",ok?"ok":"FAILED");
+    return ok?0:1;
+}
@@ -0,0 +1,103 @@
+/******************************************************************************
+ * @file threadpool.cpp
+ * @brief Implémentation des méthodes de la classe ThreadPool définies dans threadpool.h
+ ******************************************************************************/
+
+#include "threadpool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(unsigned threads){
+    threads=std::max(threads,1u);
+    for (unsigned t=0;t<threads;t++){queues.push_back(std::make_unique<Queue>());}
+    for (unsigned t=1;t<threads;t++){workers.emplace_back(&ThreadPool::workerLoop,this,t);}
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        stop=true;
+    }
+    job_cv.notify_all();
+    for (std::thread& worker:workers){worker.join();}
+}
+
+/**
+* @brief Exécute un morceau: d'abord dans sa propre file, sinon volé dans celle d'un autre thread
+* @return false si aucune file ne contient de morceau
+*/
+bool ThreadPool::runOne(unsigned self){
+    Task task;
+    bool found=false;
+    {
+        Queue& own=*queues[self];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (own.tasks.size()>own.front){
+            task=own.tasks.back();
+            own.tasks.pop_back();
+            found=true;
+        }
+    }
+    for (unsigned k=1;!found && k<queues.size();k++){
+        Queue& other=*queues[(self+k)%queues.size()];
+        std::lock_guard<std::mutex> lock(other.mutex);
+        if (other.tasks.size()>other.front){
+            task=other.tasks[other.front++];
+            found=true;
+        }
+    }
+    if (!found){return false;}
+
+    body(task.begin,task.end);
+    if (remaining.fetch_sub(1)==1){
+        std::lock_guard<std::mutex> lock(job_mutex);
+        done_cv.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerLoop(unsigned self){
+    std::uint64_t seen=0;
+    while (true){
+        {
+            std::unique_lock<std::mutex> lock(job_mutex);
+            job_cv.wait(lock,[&]{return stop || job_id!=seen;});
+            if (stop){return;}
+            seen=job_id;
+        }
+        while (runOne(self)){}
+    }
+}
+
+void ThreadPool::run(std::size_t begin,std::size_t end,std::size_t grain,const LoopBody& f){
+    if (begin>=end){return;}
+    grain=std::max<std::size_t>(grain,1);
+    // Un seul thread ou un seul morceau: inutile de passer par les files
+    if (workers.empty() || end-begin<=grain){
+        f(begin,end);
+        return;
+    }
+
+    // Répartition des morceaux entre les files, à tour de rôle
+    std::size_t chunks=(end-begin+grain-1)/grain;
+    body=f;
+    remaining.store(chunks);
+    // Les files de la boucle précédente sont vides: elles repartent du début, sans rendre leur mémoire
+    for (std::size_t q=0;q<queues.size();q++){
+        Queue& queue=*queues[q];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.clear();
+        queue.front=0;
+        for (std::size_t c=q;c<chunks;c+=queues.size()){queue.tasks.push_back(Task{begin+c*grain,std::min(end,begin+(c+1)*grain)});}
+    }
+    {
+        std::lock_guard<std::mutex> lock(job_mutex);
+        job_id++;
+    }
+    job_cv.notify_all();
+
+    // L'appelant participe, puis attend les morceaux encore en cours dans d'autres threads
+    while (runOne(0)){}
+    std::unique_lock<std::mutex> lock(job_mutex);
+    done_cv.wait(lock,[&]{return remaining.load()==0;});
+    body=LoopBody{nullptr,nullptr};
+}
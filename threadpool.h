@@ -0,0 +1,111 @@
+/******************************************************************************
+ * @file threadpool.h
+ * @brief Définition de la classe ThreadPool, un ensemble de threads avec vol de tâches.
+ *
+ * Une boucle parallelFor est découpée en morceaux répartis dans une file par thread.
+ * Chaque thread dépile ses propres morceaux, puis vole ceux des autres files quand la
+ * sienne est vide: les threads ralentis ne bloquent pas la fin de la boucle.
+ *
+ * Une boucle n'alloue pas de mémoire: les files gardent leur capacité d'une boucle à l'autre
+ * et le corps de la boucle est passé par référence, sans std::function.
+ ******************************************************************************/
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ThreadPool
+ * @brief Threads de calcul permanents exécutant des boucles parallèles.
+ *
+ * Le thread qui appelle parallelFor participe au calcul: un ThreadPool de taille 1
+ * n'a aucun thread de travail et exécute tout sur place.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Crée le pool.
+     * @param threads Nombre total de threads participant aux calculs (appelant compris), au moins 1.
+     */
+    explicit ThreadPool(unsigned threads);
+
+    /**
+     * @brief Arrête et attend les threads de travail.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&)=delete;
+    ThreadPool& operator=(const ThreadPool&)=delete;
+
+    /**
+     * @brief Nombre de threads participant aux calculs, appelant compris.
+     */
+    unsigned size() const {return (unsigned)queues.size();}
+
+    /**
+     * @brief Exécute body sur [begin,end) découpé en morceaux d'au plus grain éléments, et attend la fin.
+     * @param begin Début de l'intervalle.
+     * @param end Fin (exclue) de l'intervalle.
+     * @param grain Taille maximale d'un morceau.
+     * @param body Fonction appelée avec les bornes [b,e) de chaque morceau. Elle peut être appelée en parallèle.
+     */
+    template <class Body>
+    void parallelFor(std::size_t begin,std::size_t end,std::size_t grain,const Body& body){
+        run(begin,end,grain,LoopBody{&body,[](const void* object,std::size_t b,std::size_t e){(*static_cast<const Body*>(object))(b,e);}});
+    }
+
+private:
+    /**
+     * @struct LoopBody
+     * @brief Référence au corps d'une boucle parallèle, valable pendant parallelFor.
+     */
+    struct LoopBody {
+        const void* object; /**< Le corps de la boucle. */
+        void (*call)(const void*,std::size_t,std::size_t); /**< Appelle object sur un morceau. */
+        void operator()(std::size_t b,std::size_t e) const {call(object,b,e);}
+    };
+
+    /**
+     * @struct Task
+     * @brief Morceau d'une boucle parallèle.
+     */
+    struct Task {
+        std::size_t begin; /**< Début du morceau. */
+        std::size_t end;   /**< Fin (exclue) du morceau. */
+    };
+
+    /**
+     * @struct Queue
+     * @brief File de morceaux d'un thread: il dépile à l'arrière, les autres volent à l'avant.
+     */
+    struct Queue {
+        std::mutex mutex;        /**< Protège tasks et front. */
+        std::vector<Task> tasks; /**< Morceaux de la boucle en cours: ceux d'indice front à tasks.size()-1 sont en attente. */
+        std::size_t front=0;     /**< Premier morceau en attente (les précédents ont été volés). */
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues; /**< Une file par thread, la file 0 est celle de l'appelant. */
+    std::vector<std::thread> workers;           /**< Threads de travail (size()-1). */
+
+    std::mutex job_mutex;                 /**< Protège job_id et stop. */
+    std::condition_variable job_cv;       /**< Réveille les threads de travail lors d'une nouvelle boucle. */
+    std::condition_variable done_cv;      /**< Réveille l'appelant quand tous les morceaux sont faits. */
+    std::uint64_t job_id=0;               /**< Numéro de la boucle en cours. */
+    bool stop=false;                      /**< Demande d'arrêt des threads de travail. */
+    LoopBody body{nullptr,nullptr};       /**< Corps de la boucle en cours. */
+    std::atomic<std::size_t> remaining{0}; /**< Nombre de morceaux non terminés. */
+
+    void run(std::size_t begin,std::size_t end,std::size_t grain,const LoopBody& f);
+    bool runOne(unsigned self);
+    void workerLoop(unsigned self);
+};
+
+#endif // THREADPOOL_H
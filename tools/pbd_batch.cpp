@@ -0,0 +1,152 @@
+/******************************************************************************
+ * @file pbd_batch.cpp
+ * @brief Balayage de paramètres: simule en parallèle toutes les combinaisons de scènes, gravités,
+ * frottements et rayons données, et écrit les mesures de chaque cas en CSV ou en JSON (voir batch.h).
+ *
+ * Usage: pbd_batch <scene|point_de_reprise>... [--gravity g1,g2,...] [--friction a1,a2,...] [--radius r1,r2,...]
+ *                  [--steps N] [--dt DT] [--threads T] [--settle vitesse,pas] [--stop-settled on|off]
+ *                  [--real float|double] [--format csv|json] [--out fichier]
+ *
+ * Chaque liste de valeurs remplace le paramètre de la scène; un paramètre sans liste garde la valeur de
+ * chaque scène. Les cas sont écrits dans l'ordre scène, gravité, frottement, rayon, sur la sortie standard
+ * si --out est absent. --settle règle le critère de repos (vitesse quadratique moyenne et nombre de pas,
+ * voir BatchSettings) et --stop-settled arrête chaque cas dès que sa scène est posée.
+ * Le résumé du lot (durée, cas et pas par seconde) est écrit sur la sortie d'erreur. Une valeur numérique
+ * mal formée ou hors limites (--steps 1e3, --threads abc, --dt 0...) affiche l'usage, avec le code de retour 2.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../batch.h"
+
+static void usage(){
+    std::fprintf(stderr,"usage: pbd_batch <scene|point_de_reprise>... [--gravity g1,g2,...] [--friction a1,a2,...] [--radius r1,r2,...] "
+                        "[--steps N] [--dt DT] [--threads T] [--settle vitesse,pas] [--stop-settled on|off] "
+                        "[--real float|double] [--format csv|json] [--out fichier]\n");
+}
+
+/**
+* @brief Lit une liste de nombres séparés par des virgules
+*/
+static bool parseList(const char* value,std::vector<double>& out){
+    out.clear();
+    for (const char* p=value;;){
+        char* next;
+        out.push_back(std::strtod(p,&next));
+        if (next==p){return false;}
+        if (*next==0){return true;}
+        if (*next!=','){return false;}
+        p=next+1;
+    }
+}
+
+/**
+* @brief Lit un nombre fini qui occupe toute la valeur
+*/
+static bool parseNumber(const char* value,double& number){
+    char* next;
+    number=std::strtod(value,&next);
+    return next!=value && *next==0 && std::isfinite(number);
+}
+
+/**
+* @brief Lit un entier positif ou nul qui occupe toute la valeur: 1e3 est refusé au lieu d'être lu comme 1
+*/
+static bool parseCount(const char* value,long& count){
+    char* next;
+    errno=0;
+    count=std::strtol(value,&next,10);
+    return next!=value && *next==0 && errno==0 && count>=0;
+}
+
+int main(int argc,char* argv[]){
+    std::vector<std::string> scenes;
+    std::vector<double> gravities,frictions,radii;
+    BatchSettings settings;
+    bool real_float=false,json=false;
+    std::string out="-";
+
+    for (int a=1;a<argc;a++){
+        const char* option=argv[a];
+        if (std::strncmp(option,"--",2)!=0){scenes.push_back(option);continue;}
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){usage(); return 2;}
+        a++;
+        if (std::strcmp(option,"--gravity")==0){if (!parseList(value,gravities)){usage(); return 2;}}
+        else if (std::strcmp(option,"--friction")==0){if (!parseList(value,frictions)){usage(); return 2;}}
+        else if (std::strcmp(option,"--radius")==0){if (!parseList(value,radii)){usage(); return 2;}}
+        else if (std::strcmp(option,"--steps")==0){if (!parseCount(value,settings.steps)){usage(); return 2;}}
+        else if (std::strcmp(option,"--dt")==0){if (!parseNumber(value,settings.dt) || settings.dt<=0){usage(); return 2;}}
+        else if (std::strcmp(option,"--threads")==0){
+            long threads;
+            if (!parseCount(value,threads)){usage(); return 2;}
+            settings.threads=(unsigned)threads;
+        }
+        else if (std::strcmp(option,"--settle")==0){
+            std::vector<double> settle;
+            if (!parseList(value,settle) || settle.size()!=2 || !(settle[0]>=0) || !(settle[1]>=0) || settle[1]!=std::floor(settle[1])){usage(); return 2;}
+            settings.settle_speed=settle[0];
+            settings.settle_steps=(long)settle[1];
+        }
+        else if (std::strcmp(option,"--stop-settled")==0){settings.stop_when_settled=std::strcmp(value,"on")==0;}
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){real_float=true;}
+            else if (std::strcmp(value,"double")==0){real_float=false;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--format")==0){
+            if (std::strcmp(value,"csv")==0){json=false;}
+            else if (std::strcmp(value,"json")==0){json=true;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--out")==0){out=value;}
+        else {usage(); return 2;}
+    }
+    if (scenes.empty() || settings.steps<0 || !(settings.dt>0)){usage(); return 2;}
+
+    // Produit cartésien des listes; une liste vide garde le paramètre de la scène
+    std::vector<BatchCase> cases;
+    const std::size_t n_gravity=std::max<std::size_t>(gravities.size(),1);
+    const std::size_t n_friction=std::max<std::size_t>(frictions.size(),1);
+    const std::size_t n_radius=std::max<std::size_t>(radii.size(),1);
+    for (const std::string& scene:scenes){
+        for (std::size_t g=0;g<n_gravity;g++){
+            for (std::size_t f=0;f<n_friction;f++){
+                for (std::size_t r=0;r<n_radius;r++){
+                    BatchCase c;
+                    c.scene=scene;
+                    if (!gravities.empty()){c.set_gravity=true; c.gravity=gravities[g];}
+                    if (!frictions.empty()){c.friction=frictions[f];}
+                    if (!radii.empty()){c.radius=radii[r];}
+                    cases.push_back(c);
+                }
+            }
+        }
+    }
+
+    auto start=std::chrono::steady_clock::now();
+    std::vector<BatchResult> results=real_float?runBatch<float>(cases,settings):runBatch<double>(cases,settings);
+    double seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+
+    bool written=json?writeBatchJSON(out,settings,cases,results):writeBatchCSV(out,cases,results);
+    if (!written){
+        std::fprintf(stderr,"pbd_batch: impossible d'écrire %s\n",out.c_str());
+        return 1;
+    }
+    std::size_t failed=0;
+    long steps=0;
+    for (const BatchResult& r:results){
+        if (!r.loaded){failed++;}
+        steps+=r.steps;
+    }
+    std::fprintf(stderr,"pbd_batch: %zu cases (%zu failed), %ld steps in %.3f s: %.1f cases/s, %.1f steps/s\n",
+                 cases.size(),failed,steps,seconds,seconds>0?cases.size()/seconds:0.0,seconds>0?steps/seconds:0.0);
+    return failed>0?1:0;
+}
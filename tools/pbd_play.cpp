@@ -0,0 +1,89 @@
+/******************************************************************************
+ * @file pbd_play.cpp
+ * @brief Relecture d'une trajectoire enregistrée par pbd_run --record.
+ *
+ * Sans option, affiche le nombre d'images et de morceaux. --frame N écrit les identifiants, positions et
+ * rayons de l'image N (une particule par ligne: identifiant x y rayon, sans identifiant pour une trajectoire
+ * de version 1), --frames A B écrit les images A à B-1
+ * précédées chacune d'une ligne "frame N", --bench mesure la lecture séquentielle et l'accès direct.
+ *
+ * Usage: pbd_play <trajectoire> [--frame N | --frames A B | --bench]
+ ******************************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include "../trajectory.h"
+
+static void usage(){
+    std::fprintf(stderr,"usage: pbd_play <trajectoire> [--frame N | --frames A B | --bench]\n");
+}
+
+static void printFrame(const TrajectoryFrame& frame){
+    for (std::size_t i=0;i<frame.x.size();i++){
+        if (!frame.id.empty()){std::printf("%u ",(unsigned)frame.id[i]);}
+        std::printf("%.6g %.6g %.6g\n",frame.x[i],frame.y[i],frame.radius[i]);
+    }
+}
+
+int main(int argc,char* argv[]){
+    if (argc<2){
+        usage();
+        return 2;
+    }
+    TrajectoryPlayer player;
+    std::string error;
+    if (!player.open(argv[1],&error)){
+        std::fprintf(stderr,"pbd_play: %s\n",error.c_str());
+        return 1;
+    }
+    TrajectoryFrame frame;
+
+    if (argc==2){
+        std::printf("frames: %llu\n",(unsigned long long)player.frameCount());
+        std::printf("chunks: %zu\n",player.chunkCount());
+        std::printf("precision: %g\n",player.precision());
+        if (player.frameCount()>0 && player.readFrame(player.frameCount()-1,frame)){std::printf("particles (last frame): %zu\n",frame.x.size());}
+        return 0;
+    }
+    if (std::strcmp(argv[2],"--frame")==0 && argc==4){
+        if (!player.readFrame(std::strtoull(argv[3],nullptr,10),frame)){
+            std::fprintf(stderr,"pbd_play: image %s illisible\n",argv[3]);
+            return 1;
+        }
+        printFrame(frame);
+        return 0;
+    }
+    if (std::strcmp(argv[2],"--frames")==0 && argc==5){
+        std::uint64_t first=std::strtoull(argv[3],nullptr,10),last=std::strtoull(argv[4],nullptr,10);
+        for (std::uint64_t f=first;f<last;f++){
+            if (!player.readFrame(f,frame)){
+                std::fprintf(stderr,"pbd_play: image %llu illisible\n",(unsigned long long)f);
+                return 1;
+            }
+            std::printf("frame %llu\n",(unsigned long long)f);
+            printFrame(frame);
+        }
+        return 0;
+    }
+    if (std::strcmp(argv[2],"--bench")==0 && argc==3){
+        const std::uint64_t n=player.frameCount();
+        if (n==0){return 0;}
+        auto start=std::chrono::steady_clock::now();
+        for (std::uint64_t f=0;f<n;f++){player.readFrame(f,frame);}
+        double sequential=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        std::mt19937_64 rng(7);
+        const int seeks=100;
+        start=std::chrono::steady_clock::now();
+        for (int s=0;s<seeks;s++){player.readFrame(rng()%n,frame);}
+        double random=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-start).count();
+        std::printf("sequential: %.3f ms/frame\n",sequential/n);
+        std::printf("seek: %.3f ms/frame\n",random/seeks);
+        return 0;
+    }
+    usage();
+    return 2;
+}
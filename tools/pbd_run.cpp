@@ -0,0 +1,447 @@
+/******************************************************************************
+ * @file pbd_run.cpp
+ * @brief Simulation sans interface graphique: charge une scène, calcule N pas le plus
+ * vite possible et affiche le nombre de pas par seconde.
+ *
+ * Usage: pbd_run <scene|point_de_reprise> [--steps N] [--dt DT] [--threads T]
+ *                        [--solver sequential|colored|jacobi] [--broadphase grid|brute]
+ *                        [--trace fichier.json] [--save point_de_reprise]
+ *                        [--record trajectoire] [--precision q]
+ *                        [--hash on] [--check-threads T1,T2,...]
+ *                        [--xpbd sous_pas,itérations] [--compliance statique,dynamique] [--tolerance r]
+ *                        [--sleep on|off] [--real float|double] [--compare-real on]
+ *                        [--sdf pas|off] [--check-sdf points] [--ccd on|off]
+ *                        [--check-allocations pas]
+ *
+ * Un point de reprise (voir checkpoint.h) peut remplacer la scène: la simulation reprend alors
+ * là où elle s'était arrêtée. --save écrit l'état final dans un point de reprise. Une valeur numérique mal formée
+ * ou hors limites (--steps 1e3, --dt abc, --dt -1...) affiche l'usage, avec le code de retour 2.
+ * --record enregistre les identifiants et positions des particules après chaque pas (voir trajectory.h), à q près (1/64 par défaut).
+ *
+ * --hash on affiche l'empreinte de l'état (Context::stateHash) après chaque pas. --check-threads
+ * simule la scène une fois par nombre de threads donné et vérifie que les empreintes sont identiques
+ * à chaque pas (code de retour 1 sinon).
+ *
+ * --xpbd active le solveur XPBD (voir XPBDSettings), en remplaçant les réglages de la scène;
+ * --compliance et --tolerance règlent ses souplesses et son critère d'arrêt. Le nombre moyen
+ * d'itérations par pas est alors affiché. --sleep active ou désactive la mise en sommeil (voir
+ * SleepSettings; l'activer active aussi XPBD) et le nombre de particules éveillées à la fin est affiché.
+ *
+ * --sdf active la grille de distances aux colliders avec le pas donné (voir ColliderSDFSettings), ou la désactive.
+ * --check-sdf compare, avant la simulation, la grille au calcul exact en autant de points tirés près des colliders
+ * (voir ColliderSDF::measureError) et affiche les écarts; le code de retour est 1 si un écart dépasse la borne.
+ *
+ * --ccd active ou désactive la détection continue des collisions (voir CCDSettings); le nombre moyen de
+ * particules rapides par pas est alors affiché.
+ *
+ * Les allocations sur le tas faites pendant les pas sont comptées (voir allocationcounter.h) et affichées avec
+ * la mémoire gardée par les tampons de travail (Context::stepBufferBytes). --check-allocations vérifie qu'aucun
+ * pas n'alloue à partir du pas donné (code de retour 1 sinon). Les tampons sont réservés au chargement (voir
+ * Context::reserveStepBuffers): seul le premier pas alloue encore (liens de distance, threads des solveurs).
+ *
+ * --real float simule en simple précision (ContextF) au lieu de double. --compare-real simule la scène
+ * dans les deux précisions et affiche, à intervalles réguliers, l'écart de position entre les deux
+ * (moyen et maximal) et l'énergie cinétique de chacune; le pas par seconde de chaque précision est
+ * donné à la fin.
+ *
+ * Si pbd_core est compilé avec PBD_PROFILING, la durée moyenne et maximale de chaque étape est
+ * affichée et --trace écrit les derniers pas au format Chrome trace.
+ ******************************************************************************/
+
+#include <chrono>
+#include <cerrno>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../Context.h"
+#include "../allocationcounter.h"
+#include "../batch.h"
+#include "../checkpoint.h"
+#include "../scene.h"
+#include "../trajectory.h"
+
+static void usage(){
+    std::fprintf(stderr,"usage: pbd_run <scene|point_de_reprise> [--steps N] [--dt DT] [--threads T] "
+                        "[--solver sequential|colored|jacobi] [--broadphase grid|brute] [--trace fichier.json] [--save point_de_reprise] "
+                        "[--record trajectoire] [--precision q] [--hash on] [--check-threads T1,T2,...] "
+                        "[--xpbd sous_pas,itérations] [--compliance statique,dynamique] [--tolerance r] [--sleep on|off] "
+                        "[--real float|double] [--compare-real on] [--sdf pas|off] [--check-sdf points] [--ccd on|off] "
+                        "[--check-allocations pas]\n");
+}
+
+/**
+ * @struct RunOptions
+ * @brief Réglages de la simulation lus sur la ligne de commande.
+ */
+struct RunOptions {
+    std::string scene;
+    unsigned threads=1;
+    SolverMode solver=SolverMode::Sequential;
+    BroadphaseMode broadphase=BroadphaseMode::UniformGrid;
+    XPBDSettings xpbd; /**< Appliqués après le chargement si xpbd.enabled */
+    int sleep=-1; /**< 1: mise en sommeil activée après le chargement, 0: désactivée, -1: réglage de la scène */
+    double sdf=-1; /**< Pas de la grille de distances activée après le chargement, 0: désactivée, négatif: réglage de la scène */
+    std::size_t check_sdf=0; /**< Points de comparaison de la grille au calcul exact, 0: pas de comparaison */
+    int ccd=-1; /**< 1: détection continue activée après le chargement, 0: désactivée, -1: réglage de la scène */
+    bool real_float=false; /**< Simulation en float (ContextF) */
+    long steps=1000; /**< Nombre de pas simulés */
+    float dt=0.2f; /**< Même pas de temps que l'interface graphique (timer de 20 ms divisé par 100) */
+    const char* trace=nullptr; /**< --trace, --save et --record: fichiers à écrire, nullptr si absents */
+    const char* save=nullptr;
+    const char* record=nullptr;
+    double precision=1.0/64; /**< Précision de la trajectoire enregistrée */
+    bool print_hash=false; /**< Empreinte affichée après chaque pas */
+    long check_allocations=-1; /**< Premier pas qui ne doit plus allouer, négatif: pas de vérification */
+};
+
+/**
+* @brief Lit deux nombres séparés par une virgule
+*/
+static bool parsePair(const char* value,double& a,double& b){
+    char* next;
+    a=std::strtod(value,&next);
+    if (next==value || *next!=','){return false;}
+    const char* second=next+1;
+    b=std::strtod(second,&next);
+    return next!=second && *next==0;
+}
+
+/**
+* @brief Lit un nombre fini qui occupe toute la valeur
+*/
+static bool parseNumber(const char* value,double& number){
+    char* next;
+    number=std::strtod(value,&next);
+    return next!=value && *next==0 && std::isfinite(number);
+}
+
+/**
+* @brief Lit un entier positif ou nul qui occupe toute la valeur: 1e3 est refusé au lieu d'être lu comme 1
+*/
+static bool parseCount(const char* value,long& count){
+    char* next;
+    errno=0;
+    count=std::strtol(value,&next,10);
+    return next!=value && *next==0 && errno==0 && count>=0;
+}
+
+/**
+* @brief Charge la scène ou le point de reprise dans un contexte neuf et applique les réglages
+*/
+template <class Real>
+static bool setup(BasicContext<Real>& context,const RunOptions& options,unsigned threads,std::string& error){
+    context.setThreadCount(threads);
+    context.setSolverMode(options.solver);
+    context.setBroadphase(options.broadphase);
+    bool loaded=isCheckpoint(options.scene)?loadCheckpoint(options.scene,context,&error):loadScene(options.scene,context,&error);
+    if (options.xpbd.enabled){context.setXPBD(options.xpbd);}
+    if (options.sleep>=0){
+        SleepSettings sleep;
+        sleep.enabled=options.sleep==1;
+        context.setSleep(sleep);
+    }
+    if (options.ccd>=0){
+        CCDSettings ccd=context.ccdSettings();
+        ccd.enabled=options.ccd==1;
+        context.setCCD(ccd);
+    }
+    if (options.sdf>=0){
+        ColliderSDFSettings sdf=context.colliderSDFSettings();
+        sdf.enabled=options.sdf>0;
+        if (sdf.enabled){sdf.cell_size=options.sdf;}
+        context.setColliderSDF(sdf);
+        context.bakeColliderSDF();
+    }
+    // La détection continue a pu être activée après le chargement
+    if (loaded){context.reserveStepBuffers();}
+    return loaded;
+}
+
+/**
+* @brief Simule la scène pour chaque nombre de threads et compare les empreintes pas à pas
+*/
+template <class Real>
+static int checkThreads(const RunOptions& options,const std::vector<unsigned>& thread_counts){
+    const long steps=options.steps;
+    std::vector<std::uint64_t> reference;
+    bool identical=true;
+    for (std::size_t t=0;t<thread_counts.size();t++){
+        BasicContext<Real> context;
+        std::string error;
+        if (!setup(context,options,thread_counts[t],error)){
+            std::fprintf(stderr,"pbd_run: %s\n",error.c_str());
+            return 1;
+        }
+        long diverged=-1;
+        for (long s=0;s<steps;s++){
+            context.updatePhysicalSystem(options.dt);
+            std::uint64_t hash=context.stateHash();
+            if (t==0){reference.push_back(hash);}
+            else if (diverged<0 && hash!=reference[s]){diverged=s;}
+        }
+        if (diverged>=0){
+            identical=false;
+            std::printf("threads %u: differs from threads %u at step %ld\n",thread_counts[t],thread_counts[0],diverged);
+        }else{
+            std::printf("threads %u: %ld steps, final hash %016" PRIx64 "\n",thread_counts[t],steps,context.stateHash());
+        }
+    }
+    std::printf("%s\n",identical?"identical":"NOT identical");
+    return identical?0:1;
+}
+
+/**
+* @brief Simule la scène en double et en float et compare les positions, particule par particule (par poignée)
+*/
+static int compareReal(const RunOptions& options){
+    Context reference;
+    ContextF single;
+    std::string error;
+    if (!setup(reference,options,options.threads,error) || !setup(single,options,options.threads,error)){
+        std::fprintf(stderr,"pbd_run: %s\n",error.c_str());
+        return 1;
+    }
+    std::printf("%8s %12s %12s %14s %14s\n","step","mean_dev","max_dev","energy_double","energy_float");
+    double seconds[2]={0,0};
+    long next_report=1;
+    for (long s=1;s<=options.steps;s++){
+        auto start=std::chrono::steady_clock::now();
+        reference.updatePhysicalSystem(options.dt);
+        auto middle=std::chrono::steady_clock::now();
+        single.updatePhysicalSystem(options.dt);
+        auto end=std::chrono::steady_clock::now();
+        seconds[0]+=std::chrono::duration<double>(middle-start).count();
+        seconds[1]+=std::chrono::duration<double>(end-middle).count();
+        if (s!=next_report && s!=options.steps){continue;}
+        next_report*=2;
+
+        double sum=0,max=0;
+        std::size_t n=reference.particles.size();
+        for (std::size_t i=0;i<n;i++){
+            ParticleHandle h=reference.particles.handleAt(i);
+            if (!single.particles.valid(h)){continue;}
+            std::size_t k=single.particles.indexOf(h);
+            double dx=reference.particles.x[i]-(double)single.particles.x[k];
+            double dy=reference.particles.y[i]-(double)single.particles.y[k];
+            double d=std::sqrt(dx*dx+dy*dy);
+            sum+=d;
+            max=std::max(max,d);
+        }
+        std::printf("%8ld %12.3g %12.3g %14.6g %14.6g\n",s,n>0?sum/n:0.0,max,kineticEnergy(reference.particles),kineticEnergy(single.particles));
+    }
+    std::printf("steps/s: double %.1f, float %.1f\n",seconds[0]>0?options.steps/seconds[0]:0.0,seconds[1]>0?options.steps/seconds[1]:0.0);
+    return 0;
+}
+
+/**
+* @brief Simulation de la scène dans la précision Real
+*/
+template <class Real>
+static int run(const RunOptions& options){
+    const long steps=options.steps;
+    BasicContext<Real> context;
+    std::string error;
+    auto load_start=std::chrono::steady_clock::now();
+    bool loaded=setup(context,options,options.threads,error);
+    double load_ms=std::chrono::duration<double,std::milli>(std::chrono::steady_clock::now()-load_start).count();
+    if (!loaded){
+        std::fprintf(stderr,"pbd_run: %s\n",error.c_str());
+        return 1;
+    }
+
+    if (options.check_sdf>0){
+        // Rayon de comparaison des contacts: celui de la première particule, 5 pour une scène sans particule
+        double radius=context.particles.size()>0?(double)context.particles.radius[0]:5;
+        SDFError e=context.bakeColliderSDF().measureError(context.colliders,radius,options.check_sdf,1);
+        std::printf("sdf check: %zu points, distance error max %.4g mean %.4g (bound %.4g, %zu over), "
+                    "normal error mean %.3g rad max %.3g rad away from seams\n",
+                    e.samples,e.max_distance,e.mean_distance,e.bound,e.over_bound,e.mean_angle,e.smooth_angle);
+        std::printf("sdf check: radius %g, %zu exact contacts, %zu missed, %zu extra, depth error max %.4g\n",
+                    radius,e.contacts,e.missed,e.extra,e.max_depth);
+        if (!context.colliderSDFSettings().enabled || e.over_bound>0){
+            std::fprintf(stderr,"pbd_run: %s\n",context.colliderSDFSettings().enabled?"écart de la grille de distances au-delà de la borne":"--check-sdf: grille de distances désactivée");
+            return 1;
+        }
+    }
+
+    TrajectoryRecorder recorder;
+    if (options.record && !recorder.open(options.record,options.precision,64,8,&error)){
+        std::fprintf(stderr,"pbd_run: %s\n",error.c_str());
+        return 1;
+    }
+
+    unsigned long long iterations=0,fast=0;
+    std::uint64_t allocations=0,late_allocations=0;
+    long allocating_steps=0,last_allocating=-1;
+    auto start=std::chrono::steady_clock::now();
+    for (long s=0;s<steps;s++){
+        std::uint64_t before=allocationCount();
+        context.updatePhysicalSystem(options.dt);
+        std::uint64_t allocated=allocationCount()-before;
+        if (allocated>0){
+            allocations+=allocated;
+            allocating_steps++;
+            last_allocating=s;
+            if (options.check_allocations>=0 && s>=options.check_allocations){late_allocations+=allocated;}
+        }
+        iterations+=context.lastSolverIterations();
+        fast+=context.lastFastParticles();
+        if (options.record){recorder.record(context.particles);}
+        if (options.print_hash){std::printf("hash %ld %016" PRIx64 "\n",s,context.stateHash());}
+    }
+    if (options.record && !recorder.close(&error)){
+        std::fprintf(stderr,"pbd_run: %s\n",error.c_str());
+        return 1;
+    }
+    auto end=std::chrono::steady_clock::now();
+    double seconds=std::chrono::duration<double>(end-start).count();
+
+    std::printf("scene: %s (loaded in %.1f ms)\n",options.scene.c_str(),load_ms);
+    std::printf("real: %s\n",sizeof(Real)==4?"float":"double");
+    std::printf("particles: %zu\n",context.particles.size());
+    std::printf("colliders: %zu\n",context.colliders.size());
+    if (context.colliderSDFSettings().enabled){
+        const BasicColliderSDF<Real>& sdf=context.bakeColliderSDF();
+        std::printf("sdf: %zux%zu nodes, %.1f MB, error bound %.4g\n",sdf.columns(),sdf.rows(),sdf.memoryBytes()/1e6,sdf.errorBound());
+    }
+    if (!context.distances.empty()){std::printf("links: %zu\n",context.distances.size());}
+    std::printf("steps: %ld\n",steps);
+    std::printf("time: %.3f s\n",seconds);
+    std::printf("steps/s: %.1f\n",seconds>0?steps/seconds:0.0);
+    std::printf("allocations: %" PRIu64 " in %ld steps, last at step %ld\n",allocations,allocating_steps,last_allocating);
+    std::printf("step buffers: %.1f KB\n",context.stepBufferBytes()/1e3);
+    if (context.sleepSettings().enabled){std::printf("awake: %zu\n",context.awakeCount());}
+    if (context.ccdSettings().enabled){std::printf("ccd: %.2f fast particles/step\n",steps>0?(double)fast/steps:0.0);}
+    if (context.xpbdSettings().enabled){
+        const XPBDSettings& xpbd=context.xpbdSettings();
+        std::printf("xpbd: %u substeps, %u iterations max, %.2f iterations/step\n",xpbd.substeps,xpbd.iterations,steps>0?(double)iterations/steps:0.0);
+    }
+
+    if (Profiler::enabled()){
+        std::printf("%-18s %10s %10s\n","stage","mean (ms)","max (ms)");
+        for (std::size_t s=0;s<profile_stage_count;s++){
+            ProfileStage stage=(ProfileStage)s;
+            std::printf("%-18s %10.4f %10.4f\n",Profiler::stageName(stage),context.profiler.averageMs(stage),context.profiler.maxMs(stage));
+        }
+    }
+    if (options.check_allocations>=0 && late_allocations>0){
+        std::fprintf(stderr,"pbd_run: %" PRIu64 " allocations à partir du pas %ld\n",late_allocations,options.check_allocations);
+        return 1;
+    }
+    if (options.save && !saveCheckpoint(context,options.save,&error)){
+        std::fprintf(stderr,"pbd_run: %s\n",error.c_str());
+        return 1;
+    }
+    if (options.trace){
+        if (!Profiler::enabled()){std::fprintf(stderr,"pbd_run: --trace: pbd_core compilé sans PBD_PROFILING\n");}
+        else if (!context.profiler.writeChromeTrace(options.trace)){
+            std::fprintf(stderr,"pbd_run: impossible d'écrire %s\n",options.trace);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc,char* argv[]){
+    if (argc<2){
+        usage();
+        return 2;
+    }
+    RunOptions options;
+    options.scene=argv[1];
+    std::vector<unsigned> check_threads;
+    bool compare_real=false;
+
+    for (int a=2;a<argc;a++){
+        const char* option=argv[a];
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){
+            usage();
+            return 2;
+        }
+        a++;
+        double number;
+        long count;
+        if (std::strcmp(option,"--steps")==0){
+            if (!parseCount(value,options.steps)){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--dt")==0){
+            if (!parseNumber(value,number) || number<=0){usage(); return 2;}
+            options.dt=(float)number;
+        }
+        else if (std::strcmp(option,"--trace")==0){options.trace=value;}
+        else if (std::strcmp(option,"--save")==0){options.save=value;}
+        else if (std::strcmp(option,"--record")==0){options.record=value;}
+        else if (std::strcmp(option,"--precision")==0){
+            if (!parseNumber(value,options.precision) || options.precision<=0){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--hash")==0){options.print_hash=std::strcmp(value,"on")==0;}
+        else if (std::strcmp(option,"--check-threads")==0){
+            for (const char* p=value;*p;){
+                char* next;
+                long threads=std::strtol(p,&next,10);
+                if (next==p || threads<0 || (*next!=',' && *next!=0)){usage(); return 2;}
+                check_threads.push_back((unsigned)threads);
+                p=*next==','?next+1:next;
+            }
+        }
+        else if (std::strcmp(option,"--xpbd")==0){
+            double substeps,iterations;
+            if (!parsePair(value,substeps,iterations) || !(substeps>=1) || !(iterations>=1)){usage(); return 2;}
+            options.xpbd.enabled=true;
+            options.xpbd.substeps=(unsigned)substeps;
+            options.xpbd.iterations=(unsigned)iterations;
+        }
+        else if (std::strcmp(option,"--compliance")==0){
+            if (!parsePair(value,options.xpbd.static_compliance,options.xpbd.dynamic_compliance)
+                || !(options.xpbd.static_compliance>=0) || !(options.xpbd.dynamic_compliance>=0)){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--tolerance")==0){
+            if (!parseNumber(value,number) || number<0){usage(); return 2;}
+            options.xpbd.tolerance=number;
+        }
+        else if (std::strcmp(option,"--sleep")==0){options.sleep=std::strcmp(value,"on")==0?1:0;}
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){options.real_float=true;}
+            else if (std::strcmp(value,"double")==0){options.real_float=false;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--sdf")==0){
+            if (std::strcmp(value,"off")==0){options.sdf=0;}
+            else if (!parseNumber(value,options.sdf) || options.sdf<=0){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--ccd")==0){options.ccd=std::strcmp(value,"on")==0?1:0;}
+        else if (std::strcmp(option,"--check-allocations")==0){
+            if (!parseCount(value,options.check_allocations)){usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--check-sdf")==0){
+            if (!parseCount(value,count)){usage(); return 2;}
+            options.check_sdf=(std::size_t)count;
+        }
+        else if (std::strcmp(option,"--compare-real")==0){compare_real=std::strcmp(value,"on")==0;}
+        else if (std::strcmp(option,"--threads")==0){
+            if (!parseCount(value,count)){usage(); return 2;}
+            options.threads=(unsigned)count;
+        }
+        else if (std::strcmp(option,"--solver")==0){
+            if (std::strcmp(value,"sequential")==0){options.solver=SolverMode::Sequential;}
+            else if (std::strcmp(value,"colored")==0){options.solver=SolverMode::Colored;}
+            else if (std::strcmp(value,"jacobi")==0){options.solver=SolverMode::Jacobi;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--broadphase")==0){
+            if (std::strcmp(value,"grid")==0){options.broadphase=BroadphaseMode::UniformGrid;}
+            else if (std::strcmp(value,"brute")==0){options.broadphase=BroadphaseMode::BruteForce;}
+            else {usage(); return 2;}
+        }
+        else {usage(); return 2;}
+    }
+
+    if (compare_real){return compareReal(options);}
+    if (!check_threads.empty()){return options.real_float?checkThreads<float>(options,check_threads):checkThreads<double>(options,check_threads);}
+    return options.real_float?run<float>(options):run<double>(options);
+}
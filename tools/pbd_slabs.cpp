@@ -0,0 +1,262 @@
+/******************************************************************************
+ * @file pbd_slabs.cpp
+ * @brief Simulation d'une scène découpée en tranches, un processus par tranche (voir slabdomain.h).
+ *
+ * Usage: pbd_slabs <scene|point_de_reprise> [--processes P] [--steps N] [--dt DT] [--threads T]
+ *                  [--split balanced|even] [--real float|double] [--xpbd sous_pas,itérations]
+ *
+ * Le programme crée une socket Unix entre chaque paire de tranches voisines puis lance un processus (fork)
+ * par tranche. Chaque processus charge la scène, garde sa tranche et simule N pas avec T threads; il renvoie
+ * ses mesures par un tube. --xpbd active le solveur XPBD (voir XPBDSettings) à la place des réglages de la scène. Sont affichés, par tranche puis au total: les particules, les migrations et les
+ * fantômes par pas, l'énergie cinétique, l'empreinte de l'état final (Context::stateHash) et le débit en
+ * pas-particules par seconde. Le débit total est celui de la tranche la plus lente, en temps écoulé et en temps de
+ * calcul: sur une machine qui a moins de cœurs que de tranches, le temps de calcul de la tranche la plus lente donne
+ * le débit qu'aurait le découpage avec un cœur par tranche.
+ * Avec --processes 1, la simulation est exactement celle de pbd_run, sauf pour les scènes qui activent la mise en
+ * sommeil: partition() la désactive (voir slabdomain.h).
+ * Une valeur numérique mal formée ou hors limites (--processes abc, --processes 0, --dt 0...) affiche l'usage,
+ * avec le code de retour 2.
+ ******************************************************************************/
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../batch.h"
+#include "../checkpoint.h"
+#include "../scene.h"
+#include "../slabdomain.h"
+
+static void usage(){
+    std::fprintf(stderr,"usage: pbd_slabs <scene|point_de_reprise> [--processes P] [--steps N] [--dt DT] [--threads T] "
+                        "[--split balanced|even] [--real float|double] [--xpbd sous_pas,itérations]\n");
+}
+
+/**
+* @brief Lit un nombre fini qui occupe toute la valeur
+*/
+static bool parseNumber(const char* value,double& number){
+    char* next;
+    number=std::strtod(value,&next);
+    return next!=value && *next==0 && std::isfinite(number);
+}
+
+/**
+* @brief Lit un entier positif ou nul qui occupe la valeur jusqu'à end (fin de chaîne par défaut):
+* 1e3 est refusé au lieu d'être lu comme 1
+*/
+static bool parseCount(const char* value,long& count,char end=0){
+    char* next;
+    errno=0;
+    count=std::strtol(value,&next,10);
+    return next!=value && *next==end && errno==0 && count>=0;
+}
+
+/**
+ * @struct SlabReport
+ * @brief Mesures d'une tranche, envoyées au processus parent (une écriture de moins de PIPE_BUF octets, atomique).
+ */
+struct SlabReport {
+    unsigned rank=0;
+    int ok=0;
+    double min_x=0,max_x=0;
+    std::uint64_t particles=0;
+    std::uint64_t migrated=0; /**< Migrations vers les voisins, sur tous les pas */
+    std::uint64_t ghosts=0;   /**< Fantômes reçus, sur tous les pas */
+    std::uint64_t particle_steps=0;
+    double kinetic_energy=0;
+    double seconds=0;
+    double cpu_seconds=0; /**< Temps de calcul du processus: la durée sur un cœur dédié, attente des voisins comprise */
+    std::uint64_t hash=0;
+};
+
+/**
+* @brief Simule une tranche dans le processus fils
+*/
+template <class Real>
+static SlabReport runSlab(const std::string& scene,const SlabSettings& settings,SlabChannel* left,SlabChannel* right,
+                          long steps,float dt,unsigned threads,const XPBDSettings& xpbd){
+    SlabReport report;
+    report.rank=settings.rank;
+    BasicContext<Real> context;
+    context.setThreadCount(threads);
+    std::string error;
+    bool loaded=isCheckpoint(scene)?loadCheckpoint(scene,context,&error):loadScene(scene,context,&error);
+    if (xpbd.enabled){context.setXPBD(xpbd);}
+    BasicSlabDomain<Real> domain(context,settings,left,right);
+    if (!loaded || !domain.partition(&error)){
+        std::fprintf(stderr,"pbd_slabs: tranche %u: %s\n",settings.rank,error.c_str());
+        return report;
+    }
+    report.min_x=domain.minX();
+    report.max_x=domain.maxX();
+    auto start=std::chrono::steady_clock::now();
+    std::clock_t cpu_start=std::clock();
+    for (long s=0;s<steps;s++){
+        if (!domain.step(dt,&error)){
+            std::fprintf(stderr,"pbd_slabs: tranche %u, pas %ld: %s\n",settings.rank,s,error.c_str());
+            return report;
+        }
+        report.migrated+=domain.lastMigrated();
+        report.ghosts+=domain.lastGhosts();
+        report.particle_steps+=context.particles.size();
+    }
+    report.seconds=std::chrono::duration<double>(std::chrono::steady_clock::now()-start).count();
+    report.cpu_seconds=(double)(std::clock()-cpu_start)/CLOCKS_PER_SEC;
+    report.particles=context.particles.size();
+    report.kinetic_energy=kineticEnergy(context.particles);
+    report.hash=context.stateHash();
+    report.ok=1;
+    return report;
+}
+
+int main(int argc,char* argv[]){
+    if (argc<2){
+        usage();
+        return 2;
+    }
+    const std::string scene=argv[1];
+    unsigned processes=2,threads=1;
+    long steps=1000;
+    float dt=0.2f;
+    bool balanced=true,real_float=false;
+    XPBDSettings xpbd;
+    for (int a=2;a<argc;a++){
+        const char* option=argv[a];
+        const char* value=a+1<argc?argv[a+1]:nullptr;
+        if (!value){usage(); return 2;}
+        a++;
+        long count;
+        double number;
+        if (std::strcmp(option,"--processes")==0){
+            if (!parseCount(value,count) || count==0){usage(); return 2;}
+            processes=(unsigned)count;
+        }
+        else if (std::strcmp(option,"--steps")==0){if (!parseCount(value,steps)){usage(); return 2;}}
+        else if (std::strcmp(option,"--dt")==0){
+            if (!parseNumber(value,number) || number<=0){usage(); return 2;}
+            dt=(float)number;
+        }
+        else if (std::strcmp(option,"--threads")==0){
+            if (!parseCount(value,count)){usage(); return 2;}
+            threads=(unsigned)count;
+        }
+        else if (std::strcmp(option,"--split")==0){
+            if (std::strcmp(value,"balanced")==0){balanced=true;}
+            else if (std::strcmp(value,"even")==0){balanced=false;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--real")==0){
+            if (std::strcmp(value,"float")==0){real_float=true;}
+            else if (std::strcmp(value,"double")==0){real_float=false;}
+            else {usage(); return 2;}
+        }
+        else if (std::strcmp(option,"--xpbd")==0){
+            const char* comma=std::strchr(value,',');
+            long substeps,iterations;
+            if (!comma || !parseCount(value,substeps,',') || !parseCount(comma+1,iterations) || substeps==0 || iterations==0){usage(); return 2;}
+            xpbd.substeps=(unsigned)substeps;
+            xpbd.iterations=(unsigned)iterations;
+            xpbd.enabled=true;
+        }
+        else {usage(); return 2;}
+    }
+
+    // links[k] relie la tranche k (extrémité 0) à la tranche k+1 (extrémité 1)
+    std::vector<int> links(2*(processes-1));
+    for (unsigned k=0;k+1<processes;k++){
+        if (!SlabChannel::socketPair(&links[2*k])){
+            std::perror("pbd_slabs: socketpair");
+            return 1;
+        }
+    }
+    int reports[2];
+    if (::pipe(reports)!=0){
+        std::perror("pbd_slabs: pipe");
+        return 1;
+    }
+    std::fflush(stdout);
+
+    std::vector<pid_t> children;
+    for (unsigned rank=0;rank<processes;rank++){
+        pid_t pid=::fork();
+        if (pid<0){
+            std::perror("pbd_slabs: fork");
+            return 1;
+        }
+        if (pid>0){
+            children.push_back(pid);
+            continue;
+        }
+        // Processus fils: il ne garde que ses deux liens
+        ::close(reports[0]);
+        SlabChannel* left=nullptr;
+        SlabChannel* right=nullptr;
+        for (unsigned k=0;k+1<processes;k++){
+            if (k+1==rank){left=new SlabChannel(links[2*k+1]);} else {::close(links[2*k+1]);}
+            if (k==rank){right=new SlabChannel(links[2*k]);} else {::close(links[2*k]);}
+        }
+        SlabSettings settings;
+        settings.rank=rank;
+        settings.count=processes;
+        settings.balanced=balanced;
+        SlabReport report=real_float?runSlab<float>(scene,settings,left,right,steps,dt,threads,xpbd)
+                                       :runSlab<double>(scene,settings,left,right,steps,dt,threads,xpbd);
+        delete left;
+        delete right;
+        bool written=::write(reports[1],&report,sizeof(report))==(ssize_t)sizeof(report);
+        ::_exit(written && report.ok?0:1);
+    }
+    for (int fd:links){::close(fd);}
+    ::close(reports[1]);
+
+    std::vector<SlabReport> results(processes);
+    std::vector<bool> received(processes,false);
+    SlabReport r;
+    while (::read(reports[0],&r,sizeof(r))==(ssize_t)sizeof(r)){
+        if (r.rank<processes){results[r.rank]=r; received[r.rank]=true;}
+    }
+    ::close(reports[0]);
+    bool ok=true;
+    for (pid_t pid:children){
+        int status=0;
+        if (::waitpid(pid,&status,0)<0 || !WIFEXITED(status) || WEXITSTATUS(status)!=0){ok=false;}
+    }
+
+    std::printf("scene: %s\n",scene.c_str());
+    std::printf("processes: %u, %s split, %u thread(s) each, real %s\n",processes,balanced?"balanced":"even",threads,real_float?"float":"double");
+    std::printf("%5s %10s %10s %10s %12s %12s %14s %9s %9s %18s\n","slab","min_x","max_x","particles","migr/step","ghosts/step","kinetic","seconds","cpu (s)","hash");
+    std::uint64_t particles=0,particle_steps=0;
+    double energy=0,slowest=0,slowest_cpu=0;
+    for (unsigned k=0;k<processes;k++){
+        if (!received[k] || !results[k].ok){
+            std::printf("%5u failed\n",k);
+            ok=false;
+            continue;
+        }
+        const SlabReport& s=results[k];
+        std::printf("%5u %10.1f %10.1f %10" PRIu64 " %12.2f %12.2f %14.6g %9.3f %9.3f  %016" PRIx64 "\n",k,s.min_x,s.max_x,s.particles,
+                    steps>0?(double)s.migrated/steps:0.0,steps>0?(double)s.ghosts/steps:0.0,s.kinetic_energy,s.seconds,s.cpu_seconds,s.hash);
+        particles+=s.particles;
+        particle_steps+=s.particle_steps;
+        energy+=s.kinetic_energy;
+        slowest=std::max(slowest,s.seconds);
+        slowest_cpu=std::max(slowest_cpu,s.cpu_seconds);
+    }
+    std::printf("particles: %" PRIu64 "\n",particles);
+    std::printf("kinetic energy: %.6g\n",energy);
+    std::printf("steps: %ld\n",steps);
+    std::printf("time: %.3f s elapsed, %.3f s cpu (slowest slab)\n",slowest,slowest_cpu);
+    std::printf("steps/s: %.1f elapsed, %.1f cpu\n",slowest>0?steps/slowest:0.0,slowest_cpu>0?steps/slowest_cpu:0.0);
+    std::printf("particle-steps/s: %.4g elapsed, %.4g cpu\n",slowest>0?particle_steps/slowest:0.0,slowest_cpu>0?particle_steps/slowest_cpu:0.0);
+    return ok?0:1;
+}
@@ -0,0 +1,441 @@
+/******************************************************************************
+ * @file trajectory.cpp
+ * @brief Implémentation des classes TrajectoryRecorder et TrajectoryPlayer définies dans trajectory.h
+ ******************************************************************************/
+
+#include "trajectory.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#ifndef _WIN32
+#include <sys/types.h>
+#endif
+
+namespace {
+
+const char trajectory_magic[8]={'P','B','D','T','R','A','J','\0'};
+/**
+ * Version 2: identifiant de poignée de chaque particule avant x, y et rayon. Les fichiers de version 1,
+ * sans identifiants, sont encore relus.
+ */
+const std::uint32_t trajectory_version=2;
+const std::size_t values_per_particle=4;
+const std::uint32_t chunk_magic=0x4B4E4843; /**< "CHNK" */
+
+/**
+ * @struct TrajectoryHeader
+ * @brief En-tête du fichier. frame_count, chunk_count et index_offset valent 0 tant que le fichier n'est pas fermé.
+ */
+struct TrajectoryHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t frames_per_chunk;
+    double quantum;
+    std::uint64_t frame_count;
+    std::uint64_t chunk_count;
+    std::uint64_t index_offset; /**< Position de l'index (chunk_count TrajectoryChunk) */
+    std::uint64_t reserved[2];
+};
+static_assert(sizeof(TrajectoryHeader)==64,"l'en-tête fait partie du format");
+
+/**
+ * @struct ChunkHeader
+ * @brief En-tête d'un morceau, suivi de byte_size octets codés.
+ */
+struct ChunkHeader {
+    std::uint32_t magic;
+    std::uint32_t frames;
+    std::uint64_t first_frame;
+    std::uint64_t byte_size;
+};
+static_assert(sizeof(ChunkHeader)==24,"l'en-tête de morceau fait partie du format");
+static_assert(sizeof(TrajectoryChunk)==24,"l'index fait partie du format");
+
+void setError(std::string* error,const std::string& message){if (error){*error=message;}}
+
+/**
+* @brief Se place à une position du fichier, au delà de 2 Go compris (long ne fait que 32 bits sous Windows)
+*/
+bool seekTo(FILE* file,std::uint64_t offset){
+#ifdef _WIN32
+    return _fseeki64(file,(__int64)offset,SEEK_SET)==0;
+#else
+    return fseeko(file,(off_t)offset,SEEK_SET)==0;
+#endif
+}
+
+/**
+* @brief Taille du fichier ouvert, ou false si elle ne peut être lue
+*/
+bool fileSize(FILE* file,std::uint64_t& size){
+#ifdef _WIN32
+    if (_fseeki64(file,0,SEEK_END)!=0){return false;}
+    __int64 end=_ftelli64(file);
+#else
+    if (fseeko(file,0,SEEK_END)!=0){return false;}
+    off_t end=ftello(file);
+#endif
+    if (end<0){return false;}
+    size=(std::uint64_t)end;
+    return true;
+}
+
+/**
+* @brief Ajoute un entier non signé en base 128 (7 bits par octet, bit de poids fort = suite)
+*/
+inline void putVarint(std::vector<std::uint8_t>& out,std::uint64_t v){
+    while (v>=0x80){
+        out.push_back((std::uint8_t)(v|0x80));
+        v>>=7;
+    }
+    out.push_back((std::uint8_t)v);
+}
+
+/**
+* @brief Lit un entier écrit par putVarint
+* @return false si les octets se terminent avant l'entier
+*/
+inline bool getVarint(const std::vector<std::uint8_t>& in,std::size_t& cursor,std::uint64_t& v){
+    v=0;
+    for (int shift=0;shift<64;shift+=7){
+        if (cursor>=in.size()){return false;}
+        std::uint8_t byte=in[cursor++];
+        v|=(std::uint64_t)(byte&0x7F)<<shift;
+        if (!(byte&0x80)){return true;}
+    }
+    return false;
+}
+
+/**
+* @brief Codage zigzag: les petits entiers négatifs deviennent de petits entiers positifs
+*/
+inline std::uint64_t zigzag(std::int64_t v){return ((std::uint64_t)v<<1)^(std::uint64_t)(v>>63);}
+inline std::int64_t unzigzag(std::uint64_t v){return (std::int64_t)(v>>1)^-(std::int64_t)(v&1);}
+
+} // namespace
+
+bool TrajectoryRecorder::open(const std::string& path,double new_quantum,std::uint32_t new_frames_per_chunk,std::size_t max_pending_frames,std::string* error){
+    close(nullptr);
+    if (!(new_quantum>0)){
+        setError(error,"la précision doit être positive");
+        return false;
+    }
+    file=std::fopen(path.c_str(),"wb");
+    if (!file){
+        setError(error,path+": impossible d'écrire le fichier");
+        return false;
+    }
+    quantum=new_quantum;
+    frames_per_chunk=std::max<std::uint32_t>(new_frames_per_chunk,1);
+    frame_count=0;
+    pending.assign(std::max<std::size_t>(max_pending_frames,1),PendingFrame());
+    pending_head=0;
+    pending_count=0;
+    closing=false;
+    previous.clear();
+    chunk.clear();
+    chunk_frames=0;
+    chunk_first_frame=0;
+    index.clear();
+    write_failed=false;
+
+    TrajectoryHeader header{};
+    std::memcpy(header.magic,trajectory_magic,8);
+    header.version=trajectory_version;
+    header.frames_per_chunk=frames_per_chunk;
+    header.quantum=quantum;
+    file_offset=0;
+    write(&header,sizeof(header));
+
+    writer=std::thread(&TrajectoryRecorder::writerLoop,this);
+    return true;
+}
+
+template <class Real>
+void TrajectoryRecorder::record(const BasicParticleStore<Real>& particles){
+    if (!file){return;}
+    std::size_t slot;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        slot_free.wait(lock,[this]{return pending_count<pending.size();});
+        slot=(pending_head+pending_count)%pending.size();
+    }
+    // L'emplacement n'est pas lu par le thread d'écriture tant que pending_count ne l'inclut pas
+    std::vector<std::int64_t>& values=pending[slot].values;
+    const std::size_t n=particles.size();
+    values.resize(values_per_particle*n);
+    const double scale=1/quantum;
+    for (std::size_t i=0;i<n;i++){
+        std::int64_t* v=&values[values_per_particle*i];
+        v[0]=particles.handleAt(i).id;
+        v[1]=std::llround(particles.x[i]*scale);
+        v[2]=std::llround(particles.y[i]*scale);
+        v[3]=std::llround(particles.radius[i]*scale);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending_count++;
+    }
+    frame_ready.notify_one();
+    frame_count++;
+}
+
+template void TrajectoryRecorder::record<float>(const BasicParticleStore<float>&);
+template void TrajectoryRecorder::record<double>(const BasicParticleStore<double>&);
+
+bool TrajectoryRecorder::close(std::string* error){
+    if (!file){return true;}
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        closing=true;
+    }
+    frame_ready.notify_one();
+    writer.join();
+
+    flushChunk();
+    TrajectoryHeader header{};
+    std::memcpy(header.magic,trajectory_magic,8);
+    header.version=trajectory_version;
+    header.frames_per_chunk=frames_per_chunk;
+    header.quantum=quantum;
+    header.frame_count=frame_count;
+    header.chunk_count=index.size();
+    header.index_offset=file_offset;
+    write(index.data(),index.size()*sizeof(TrajectoryChunk));
+    if (std::fseek(file,0,SEEK_SET)!=0 || std::fwrite(&header,sizeof(header),1,file)!=1){write_failed=true;}
+    if (std::fclose(file)!=0){write_failed=true;}
+    file=nullptr;
+    if (write_failed){setError(error,"erreur d'écriture de la trajectoire");}
+    return !write_failed;
+}
+
+/**
+* @brief Thread d'écriture: code les images en attente dans l'ordre, jusqu'à la fermeture
+*/
+void TrajectoryRecorder::writerLoop(){
+    while (true){
+        std::size_t slot;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frame_ready.wait(lock,[this]{return pending_count>0 || closing;});
+            if (pending_count==0){return;}
+            slot=pending_head;
+        }
+        encodeFrame(pending[slot].values);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending_head=(pending_head+1)%pending.size();
+            pending_count--;
+        }
+        slot_free.notify_one();
+    }
+}
+
+/**
+* @brief Code une image par différence avec la précédente du morceau.
+* Format: nombre de particules, puis des couples (plage de particules inchangées, différences identifiant x y rayon)
+* jusqu'à la dernière particule; une plage qui atteint la fin n'est pas suivie de différences.
+* L'identifiant d'une particule restée au même indice ne change pas: sa différence est nulle.
+*/
+void TrajectoryRecorder::encodeFrame(const std::vector<std::int64_t>& values){
+    if (chunk_frames==0){
+        // Première image du morceau: codée par rapport à une image vide
+        previous.clear();
+        chunk_first_frame=index.empty()?0:index.back().first_frame+index.back().frames;
+    }
+    const std::size_t stride=values_per_particle;
+    const std::size_t n=values.size()/stride;
+    const std::size_t n_previous=previous.size()/stride;
+    putVarint(chunk,n);
+    std::size_t run=0;
+    std::int64_t delta[values_per_particle];
+    for (std::size_t i=0;i<n;i++){
+        bool unchanged=i<n_previous;
+        for (std::size_t k=0;k<stride;k++){
+            delta[k]=values[stride*i+k]-(i<n_previous?previous[stride*i+k]:0);
+            unchanged=unchanged && delta[k]==0;
+        }
+        if (unchanged){
+            run++;
+            continue;
+        }
+        putVarint(chunk,run);
+        run=0;
+        for (std::size_t k=0;k<stride;k++){putVarint(chunk,zigzag(delta[k]));}
+    }
+    if (run>0){putVarint(chunk,run);}
+    previous=values;
+    if (++chunk_frames==frames_per_chunk){flushChunk();}
+}
+
+/**
+* @brief Écrit le morceau en cours et l'ajoute à l'index
+*/
+void TrajectoryRecorder::flushChunk(){
+    if (chunk_frames==0){return;}
+    ChunkHeader header{chunk_magic,chunk_frames,chunk_first_frame,chunk.size()};
+    index.push_back({chunk_first_frame,file_offset,chunk_frames});
+    write(&header,sizeof(header));
+    write(chunk.data(),chunk.size());
+    // Le tampon garde sa capacité: pas d'allocation d'un morceau à l'autre
+    chunk.clear();
+    chunk_frames=0;
+}
+
+void TrajectoryRecorder::write(const void* data,std::size_t bytes){
+    if (bytes>0 && std::fwrite(data,1,bytes,file)!=bytes){write_failed=true;}
+    file_offset+=bytes;
+}
+
+TrajectoryPlayer::~TrajectoryPlayer(){
+    if (file){std::fclose(file);}
+}
+
+bool TrajectoryPlayer::open(const std::string& path,std::string* error){
+    if (file){std::fclose(file);}
+    chunks.clear();
+    loaded_chunk=SIZE_MAX;
+    frame_count=0;
+    file=std::fopen(path.c_str(),"rb");
+    if (!file){
+        setError(error,path+": impossible de lire le fichier");
+        return false;
+    }
+    TrajectoryHeader header;
+    if (std::fread(&header,sizeof(header),1,file)!=1 || std::memcmp(header.magic,trajectory_magic,8)!=0){
+        setError(error,path+": ce n'est pas une trajectoire");
+        return false;
+    }
+    if (header.version<1 || header.version>trajectory_version || !(header.quantum>0)){
+        setError(error,path+": version "+std::to_string(header.version)+" non prise en charge");
+        return false;
+    }
+    quantum=header.quantum;
+    stride=header.version>=2?values_per_particle:3;
+    if (!fileSize(file,file_size)){
+        setError(error,path+": impossible de lire le fichier");
+        return false;
+    }
+
+    if (header.index_offset!=0){
+        // L'index doit tenir dans le fichier avant d'être alloué, puis couvrir toutes les images, dans l'ordre
+        if (header.index_offset<sizeof(header) || header.index_offset>file_size
+            || header.chunk_count>(file_size-header.index_offset)/sizeof(TrajectoryChunk)){
+            setError(error,path+": index hors du fichier");
+            return false;
+        }
+        chunks.resize(header.chunk_count);
+        if (!seekTo(file,header.index_offset)
+            || std::fread(chunks.data(),sizeof(TrajectoryChunk),chunks.size(),file)!=chunks.size()){
+            chunks.clear();
+            setError(error,path+": index illisible");
+            return false;
+        }
+        std::uint64_t frames=0;
+        for (const TrajectoryChunk& c:chunks){
+            if (c.first_frame!=frames || c.frames==0 || c.frames>header.frame_count-frames
+                || c.offset<sizeof(header) || c.offset>header.index_offset-sizeof(ChunkHeader)){
+                chunks.clear();
+                setError(error,path+": index incohérent");
+                return false;
+            }
+            frames+=c.frames;
+        }
+        if (frames!=header.frame_count){
+            chunks.clear();
+            setError(error,path+": l'index ne couvre pas les "+std::to_string(header.frame_count)+" images");
+            return false;
+        }
+        frame_count=header.frame_count;
+        return true;
+    }
+
+    // Fichier non fermé: on reconstruit l'index en suivant les en-têtes de morceaux; un morceau tronqué est ignoré
+    std::uint64_t offset=sizeof(header);
+    ChunkHeader chunk_header;
+    while (offset+sizeof(chunk_header)<=file_size){
+        if (!seekTo(file,offset) || std::fread(&chunk_header,sizeof(chunk_header),1,file)!=1
+            || chunk_header.magic!=chunk_magic || chunk_header.first_frame!=frame_count || chunk_header.frames==0
+            || chunk_header.byte_size>file_size-offset-sizeof(chunk_header)){break;}
+        chunks.push_back({chunk_header.first_frame,offset,chunk_header.frames});
+        frame_count+=chunk_header.frames;
+        offset+=sizeof(chunk_header)+chunk_header.byte_size;
+    }
+    return true;
+}
+
+/**
+* @brief Charge les octets d'un morceau et se place sur sa première image
+*/
+bool TrajectoryPlayer::loadChunk(std::size_t c){
+    ChunkHeader header;
+    if (!seekTo(file,chunks[c].offset) || std::fread(&header,sizeof(header),1,file)!=1
+        || header.magic!=chunk_magic || header.byte_size>file_size-chunks[c].offset-sizeof(header)){return false;}
+    chunk.resize(header.byte_size);
+    if (std::fread(chunk.data(),1,chunk.size(),file)!=chunk.size()){return false;}
+    loaded_chunk=c;
+    cursor=0;
+    next_frame=chunks[c].first_frame;
+    values.clear();
+    return true;
+}
+
+/**
+* @brief Décode l'image suivante du morceau chargé dans values (voir TrajectoryRecorder::encodeFrame)
+*/
+bool TrajectoryPlayer::decodeFrame(){
+    std::uint64_t n;
+    const std::size_t n_previous=values.size()/stride;
+    // Chaque nouvelle particule occupe au moins un octet: on refuse un nombre incohérent avant d'allouer
+    if (!getVarint(chunk,cursor,n) || n>n_previous+(chunk.size()-cursor)){return false;}
+    // Les particules au delà de l'image précédente sont codées par rapport à 0
+    values.resize(stride*n,0);
+    std::size_t i=0;
+    while (i<n){
+        std::uint64_t run,delta;
+        if (!getVarint(chunk,cursor,run) || run>n-i){return false;}
+        i+=run;
+        if (i==n){break;}
+        for (std::size_t k=0;k<stride;k++){
+            if (!getVarint(chunk,cursor,delta)){return false;}
+            values[stride*i+k]+=unzigzag(delta);
+        }
+        i++;
+    }
+    next_frame++;
+    return true;
+}
+
+bool TrajectoryPlayer::readFrame(std::uint64_t frame,TrajectoryFrame& out){
+    if (!file || frame>=frame_count){return false;}
+    // Morceau contenant l'image: le dernier qui commence avant elle
+    auto it=std::upper_bound(chunks.begin(),chunks.end(),frame,
+                             [](std::uint64_t f,const TrajectoryChunk& c){return f<c.first_frame;});
+    std::size_t c=(std::size_t)(it-chunks.begin())-1;
+    // On ne recharge le morceau que si l'image est avant la position actuelle du décodage
+    if (c!=loaded_chunk || frame+1<next_frame){
+        if (!loadChunk(c)){return false;}
+    }
+    while (next_frame<=frame){
+        if (!decodeFrame()){
+            loaded_chunk=SIZE_MAX;
+            return false;
+        }
+    }
+    const std::size_t n=values.size()/stride;
+    // Dans un fichier de version 1, les valeurs commencent à x et les identifiants manquent
+    const std::size_t first=stride-3;
+    out.index=frame;
+    out.id.resize(first>0?n:0);
+    out.x.resize(n);
+    out.y.resize(n);
+    out.radius.resize(n);
+    for (std::size_t i=0;i<n;i++){
+        const std::int64_t* v=&values[stride*i];
+        if (first>0){out.id[i]=(std::uint32_t)v[0];}
+        out.x[i]=v[first]*quantum;
+        out.y[i]=v[first+1]*quantum;
+        out.radius[i]=v[first+2]*quantum;
+    }
+    return true;
+}
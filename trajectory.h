@@ -0,0 +1,183 @@
+/******************************************************************************
+ * @file trajectory.h
+ * @brief Enregistrement compact des positions de chaque pas (TrajectoryRecorder) et relecture
+ * avec accès direct à n'importe quel pas (TrajectoryPlayer).
+ *
+ * Les positions et rayons sont quantifiés (multiples entiers de quantum) et accompagnés de l'identifiant
+ * de la poignée de chaque particule (ParticleHandle::id): les indices changent quand des particules sont
+ * supprimées, endormies ou migrent d'une tranche à l'autre, l'identifiant permet de suivre une particule
+ * d'une image à l'autre. Chaque image est codée par différence avec l'image précédente: entiers zigzag de
+ * longueur variable, et les particules immobiles (et restées au même indice) sont codées par plages. Les images sont regroupées en morceaux
+ * (frames_per_chunk images), dont la première est codée sans référence: un morceau se décode
+ * seul. Un index des morceaux, écrit à la fin du fichier, permet d'aller directement au morceau
+ * d'une image; s'il manque (enregistrement interrompu), le lecteur le reconstruit en parcourant
+ * les en-têtes de morceaux.
+ *
+ * Le codage et l'écriture se font sur un thread de fond. record() ne fait que quantifier les
+ * positions dans un tampon parmi max_pending_frames: la mémoire utilisée est bornée, et record()
+ * attend si le disque ne suit pas.
+ ******************************************************************************/
+
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "particlestore.h"
+
+/**
+ * @struct TrajectoryFrame
+ * @brief Identifiants, positions et rayons des particules d'une image relue.
+ */
+struct TrajectoryFrame {
+    std::uint64_t index=0; /**< Numéro de l'image */
+    std::vector<std::uint32_t> id; /**< Identifiant de poignée de chaque particule, vide pour un fichier de version 1 */
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> radius;
+};
+
+/**
+ * @struct TrajectoryChunk
+ * @brief Entrée de l'index des morceaux.
+ */
+struct TrajectoryChunk {
+    std::uint64_t first_frame=0; /**< Numéro de la première image du morceau */
+    std::uint64_t offset=0; /**< Position de l'en-tête du morceau dans le fichier */
+    std::uint64_t frames=0; /**< Nombre d'images du morceau */
+};
+
+/**
+ * @class TrajectoryRecorder
+ * @brief Écrit une image par appel à record() dans un fichier de trajectoire.
+ */
+class TrajectoryRecorder {
+private:
+    /**
+     * @struct PendingFrame
+     * @brief Image quantifiée en attente de codage (identifiant, x, y, rayon entrelacés).
+     */
+    struct PendingFrame {
+        std::vector<std::int64_t> values;
+    };
+
+    FILE* file=nullptr;
+    double quantum=1.0/64;
+    std::uint32_t frames_per_chunk=64;
+    std::uint64_t frame_count=0; /**< Images passées à record() */
+
+    std::vector<PendingFrame> pending; /**< Tampon circulaire des images en attente */
+    std::size_t pending_head=0; /**< Prochaine image à coder */
+    std::size_t pending_count=0; /**< Images en attente, protégé par mutex */
+    bool closing=false; /**< Protégé par mutex */
+    std::mutex mutex;
+    std::condition_variable frame_ready;
+    std::condition_variable slot_free;
+    std::thread writer;
+
+    // État du thread d'écriture
+    std::vector<std::int64_t> previous; /**< Image précédente du morceau en cours */
+    std::vector<std::uint8_t> chunk; /**< Octets du morceau en cours */
+    std::uint32_t chunk_frames=0;
+    std::uint64_t chunk_first_frame=0;
+    std::uint64_t file_offset=0;
+    std::vector<TrajectoryChunk> index; /**< Morceaux déjà écrits */
+    bool write_failed=false;
+
+    void writerLoop();
+    void encodeFrame(const std::vector<std::int64_t>& values);
+    void flushChunk();
+    void write(const void* data,std::size_t bytes);
+
+public:
+    TrajectoryRecorder()=default;
+    ~TrajectoryRecorder(){close(nullptr);}
+    TrajectoryRecorder(const TrajectoryRecorder&)=delete;
+    TrajectoryRecorder& operator=(const TrajectoryRecorder&)=delete;
+
+    /**
+     * @brief Crée le fichier et lance le thread d'écriture.
+     * @param path Chemin du fichier.
+     * @param quantum Précision des positions et rayons enregistrés.
+     * @param frames_per_chunk Nombre d'images par morceau (plus petit: accès direct plus rapide, fichier plus gros).
+     * @param max_pending_frames Nombre d'images en attente de codage au plus.
+     * @param error Message d'erreur si le fichier ne peut être créé, peut être nullptr.
+     */
+    bool open(const std::string& path,double quantum,std::uint32_t frames_per_chunk,std::size_t max_pending_frames,std::string* error);
+
+    /**
+     * @brief Ajoute une image: les identifiants de poignée, les positions actuelles (x, y) et les rayons des particules.
+     * Instanciée en float et en double: le format ne dépend pas de la précision de la simulation.
+     */
+    template <class Real>
+    void record(const BasicParticleStore<Real>& particles);
+
+    /**
+     * @brief Code les images en attente, écrit l'index et ferme le fichier.
+     * @return false si une écriture a échoué.
+     */
+    bool close(std::string* error);
+
+    /**
+     * @brief Nombre d'images enregistrées.
+     */
+    std::uint64_t frameCount() const {return frame_count;}
+};
+
+/**
+ * @class TrajectoryPlayer
+ * @brief Relit les images d'un fichier de trajectoire, dans n'importe quel ordre.
+ *
+ * Lire les images dans l'ordre ne décode chaque image qu'une fois; aller à une image quelconque
+ * ne décode que le début de son morceau.
+ */
+class TrajectoryPlayer {
+private:
+    FILE* file=nullptr;
+    double quantum=1;
+    std::size_t stride=4; /**< Valeurs par particule: 4 avec l'identifiant, 3 dans un fichier de version 1 */
+    std::uint64_t frame_count=0;
+    std::uint64_t file_size=0;
+    std::vector<TrajectoryChunk> chunks; /**< Index des morceaux, vérifié: il couvre les frame_count images dans l'ordre */
+
+    // Morceau chargé et position du décodage dans ce morceau
+    std::size_t loaded_chunk=SIZE_MAX;
+    std::vector<std::uint8_t> chunk;
+    std::size_t cursor=0;
+    std::uint64_t next_frame=0; /**< Image que le prochain décodage produira */
+    std::vector<std::int64_t> values; /**< Dernière image décodée */
+
+    bool loadChunk(std::size_t c);
+    bool decodeFrame();
+
+public:
+    TrajectoryPlayer()=default;
+    ~TrajectoryPlayer();
+    TrajectoryPlayer(const TrajectoryPlayer&)=delete;
+    TrajectoryPlayer& operator=(const TrajectoryPlayer&)=delete;
+
+    /**
+     * @brief Ouvre un fichier de trajectoire et lit (ou reconstruit) l'index des morceaux.
+     */
+    bool open(const std::string& path,std::string* error);
+
+    std::uint64_t frameCount() const {return frame_count;}
+    std::size_t chunkCount() const {return chunks.size();}
+    double precision() const {return quantum;}
+
+    /**
+     * @brief Décode une image.
+     * @param frame Numéro de l'image, inférieur à frameCount().
+     * @param out Image décodée.
+     * @return false si le numéro est hors limites ou si le fichier est corrompu.
+     */
+    bool readFrame(std::uint64_t frame,TrajectoryFrame& out);
+};
+
+#endif // TRAJECTORY_H